@@ -0,0 +1,184 @@
+#ifndef SL_BENCH_H
+#define SL_BENCH_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "../sl_cpu.h"
+
+#ifdef SL_CPU_X86
+#include <x86intrin.h>
+#endif
+
+#define SL_BENCH_WARMUP_NS (100 * 1000 * 1000)
+#define SL_BENCH_SAMPLE_NS  (20 * 1000 * 1000)
+#define SL_BENCH_SAMPLES    7
+
+typedef uint64_t (*sl_bench_function)(void *fixture, size_t iterations);
+
+typedef struct sl_bench_result sl_bench_result;
+
+struct sl_bench_result {
+    char *name;
+    size_t iterations;
+    size_t bytes;
+    double ns_per_op;
+    double cycles_per_op;
+    double mallocs_per_op;
+    double allocations_per_op;
+    double arena_bytes_per_op;
+};
+
+static size_t sl_bench_mallocs;
+static volatile uint64_t sl_bench_sink;
+
+static inline uint64_t sl_bench_now(void)
+{
+    struct timespec timestamp;
+
+    clock_gettime(CLOCK_MONOTONIC, &timestamp);
+
+    return (uint64_t) timestamp.tv_sec * 1000000000 + timestamp.tv_nsec;
+}
+
+static inline uint64_t sl_bench_cycles(void)
+{
+#ifdef SL_CPU_X86
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static inline bool sl_bench_machine_readable(void)
+{
+    char *format = getenv("SL_BENCH_FORMAT");
+
+    return format != NULL && strcmp(format, "tsv") == 0;
+}
+
+static inline void sl_bench_emit(sl_bench_result *result)
+{
+    double mb_per_s = result->bytes > 0 && result->ns_per_op > 0.0 ? (double) result->bytes * 1000.0 / result->ns_per_op : 0.0;
+
+    if (sl_bench_machine_readable() == true) {
+        printf("%s\t%.2f\t%.2f\t%.2f\t%.3f\t%.3f\t%.1f\n", result->name, result->ns_per_op, result->cycles_per_op, mb_per_s,
+            result->mallocs_per_op, result->allocations_per_op, result->arena_bytes_per_op);
+        return;
+    }
+
+    printf("%-40s %12.2f ns/op", result->name, result->ns_per_op);
+
+    if (mb_per_s > 0.0) {
+        printf(" %10.2f MB/s", mb_per_s);
+    }
+
+    if (result->cycles_per_op > 0.0) {
+        printf(" %10.1f cycles/op %8.3f mallocs/op %8.3f allocations/op %10.1f arena bytes/op", result->cycles_per_op,
+            result->mallocs_per_op, result->allocations_per_op, result->arena_bytes_per_op);
+    }
+
+    printf("\n");
+}
+
+static inline void sl_bench_report(char *name, size_t iterations, size_t bytes, uint64_t elapsed)
+{
+    sl_bench_result result = {
+        .name = name,
+        .iterations = iterations,
+        .bytes = elapsed > 0 ? bytes : 0,
+        .ns_per_op = (double) elapsed / iterations
+    };
+
+    sl_bench_emit(&result);
+}
+
+static inline size_t sl_bench_calibrate(sl_bench_function function, void *fixture)
+{
+    size_t iterations = 1;
+    uint64_t elapsed = 0, start = sl_bench_now();
+
+    while (sl_bench_now() - start < SL_BENCH_WARMUP_NS) {
+        uint64_t round_start = sl_bench_now();
+
+        sl_bench_sink += function(fixture, iterations);
+        elapsed = sl_bench_now() - round_start;
+
+        if (elapsed < SL_BENCH_SAMPLE_NS / 4) {
+            iterations <<= 1;
+        }
+    }
+
+    if (elapsed == 0) {
+        return iterations;
+    }
+
+    size_t scaled = (size_t) ((double) iterations * SL_BENCH_SAMPLE_NS / elapsed);
+
+    return scaled > 0 ? scaled : 1;
+}
+
+static inline void sl_bench_measure(sl_bench_result *result, sl_bench_function function, void *fixture)
+{
+    size_t iterations = sl_bench_calibrate(function, fixture);
+
+    result->iterations = iterations;
+    result->ns_per_op = 0.0;
+
+    for (size_t n = 0; n < SL_BENCH_SAMPLES; n ++) {
+        size_t mallocs = sl_bench_mallocs;
+        uint64_t cycles = sl_bench_cycles(), start = sl_bench_now();
+
+        sl_bench_sink += function(fixture, iterations);
+
+        uint64_t elapsed = sl_bench_now() - start;
+        cycles = sl_bench_cycles() - cycles;
+
+        double ns_per_op = (double) elapsed / iterations;
+
+        if (n == 0 || ns_per_op < result->ns_per_op) {
+            result->ns_per_op = ns_per_op;
+            result->cycles_per_op = (double) cycles / iterations;
+            result->mallocs_per_op = (double) (sl_bench_mallocs - mallocs) / iterations;
+        }
+    }
+}
+
+#ifdef SL_BENCH_COUNT_MALLOCS
+#ifdef __GLIBC__
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *buffer, size_t size);
+extern void *__libc_memalign(size_t alignment, size_t size);
+
+void *malloc(size_t size)
+{
+    sl_bench_mallocs ++;
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size)
+{
+    sl_bench_mallocs ++;
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *buffer, size_t size)
+{
+    sl_bench_mallocs ++;
+    return __libc_realloc(buffer, size);
+}
+
+void *aligned_alloc(size_t alignment, size_t size)
+{
+    sl_bench_mallocs ++;
+    return __libc_memalign(alignment, size);
+}
+#endif
+#endif
+
+#endif
@@ -0,0 +1,62 @@
+#!/bin/sh
+#
+# Compare two machine-readable benchmark runs and flag regressions.
+#
+#   SL_BENCH_FORMAT=tsv ./sl_bench_core > baseline.tsv
+#   SL_BENCH_FORMAT=tsv ./sl_bench_core > candidate.tsv
+#   ./sl_bench_compare.sh baseline.tsv candidate.tsv [threshold percent]
+#
+# Columns: name, ns/op, cycles/op, MB/s, mallocs/op, arena allocations/op,
+# arena bytes/op. A benchmark regresses when ns/op grows by more than the
+# threshold (default 10%) or when it makes more mallocs or arena allocations
+# per operation. Exits with status 1 if anything regressed.
+
+if [ $# -lt 2 ]; then
+    echo "Usage: $0 baseline.tsv candidate.tsv [threshold percent]" >&2
+    exit 2
+fi
+
+awk -F '\t' -v threshold="${3:-10}" '
+    NF != 7 {
+        next
+    }
+    FNR == NR {
+        ns[$1] = $2; mallocs[$1] = $5; allocations[$1] = $6
+        next
+    }
+    !($1 in ns) {
+        printf "%-40s %12s %12.2f %9s  new\n", $1, "-", $2, "-"
+        next
+    }
+    {
+        change = ns[$1] > 0 ? ($2 - ns[$1]) * 100.0 / ns[$1] : 0
+        status = "ok"
+
+        if (change > threshold) {
+            status = "REGRESSION"
+        } else if (change < -threshold) {
+            status = "improved"
+        }
+
+        if ($5 > mallocs[$1] + 0.001 || $6 > allocations[$1] + 0.001) {
+            status = "REGRESSION (allocations " allocations[$1] " -> " $6 ", mallocs " mallocs[$1] " -> " $5 ")"
+        }
+
+        if (status ~ /^REGRESSION/) {
+            regressions ++
+        }
+
+        printf "%-40s %12.2f %12.2f %+8.1f%%  %s\n", $1, ns[$1], $2, change, status
+        seen[$1] = 1
+    }
+    END {
+        for (name in ns) {
+            if (!(name in seen)) {
+                printf "%-40s %12.2f %12s %9s  missing\n", name, ns[name], "-", "-"
+            }
+        }
+
+        printf "%d regression(s) at %s%% threshold\n", regressions, threshold
+        exit regressions > 0
+    }
+' "$1" "$2"
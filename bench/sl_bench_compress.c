@@ -0,0 +1,148 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "sl_bench.h"
+#include "../sl_arena.h"
+#include "../sl_log.h"
+#include "../sl_fcgi.h"
+#include "../sl_compress.h"
+
+#define SL_BENCH_COMPRESS_BYTES           (64 * 1024 * 1024)
+#define SL_BENCH_COMPRESS_ARENA_PREALLOCATE 102400
+#define SL_BENCH_COMPRESS_MAX_SIZE        (256 * 1024)
+
+typedef struct sl_bench_compress_fixture sl_bench_compress_fixture;
+
+struct sl_bench_compress_fixture {
+    char *name;
+    void (*fill)(char *buffer, size_t length);
+};
+
+static char sl_bench_compress_body[SL_BENCH_COMPRESS_MAX_SIZE];
+
+static size_t sl_bench_compress_sizes[] = {1024, 16 * 1024, SL_BENCH_COMPRESS_MAX_SIZE};
+static int sl_bench_compress_levels[] = {1, 6, 9};
+
+static void sl_bench_compress_fill_html(char *buffer, size_t length)
+{
+    size_t offset = 0;
+
+    for (size_t n = 0; offset < length; n ++) {
+        char row[128];
+        int written = snprintf(row, sizeof(row), "<tr class=\"row-%zu\"><td>%zu</td><td>item %zu</td><td>%zu.%02zu</td></tr>\n", n % 2, n, n * 7919 % 10007, n * 31 % 997, n % 100);
+
+        size_t copy = (size_t) written < length - offset ? (size_t) written : length - offset;
+
+        memcpy(buffer + offset, row, copy);
+        offset += copy;
+    }
+}
+
+static void sl_bench_compress_fill_json(char *buffer, size_t length)
+{
+    size_t offset = 0;
+
+    for (size_t n = 0; offset < length; n ++) {
+        char row[128];
+        int written = snprintf(row, sizeof(row), "{\"id\":%zu,\"user\":\"user%zu\",\"score\":%zu,\"active\":%s},", n, n * 2654435761u % 100000, n * 40503 % 65536, n % 3 == 0 ? "true" : "false");
+
+        size_t copy = (size_t) written < length - offset ? (size_t) written : length - offset;
+
+        memcpy(buffer + offset, row, copy);
+        offset += copy;
+    }
+}
+
+static void sl_bench_compress_fill_random(char *buffer, size_t length)
+{
+    uint64_t state = 0x9e3779b97f4a7c15;
+
+    for (size_t n = 0; n < length; n ++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        buffer[n] = (char) state;
+    }
+}
+
+static sl_bench_compress_fixture sl_bench_compress_fixtures[] = {
+    { "html", sl_bench_compress_fill_html },
+    { "json", sl_bench_compress_fill_json },
+    { "random", sl_bench_compress_fill_random }
+};
+
+static size_t sl_bench_compress_run(sl_compress *compress, sl_arena *arena, sl_log *log, size_t length, sl_compress_encoding encoding, size_t iterations)
+{
+    size_t compressed = 0;
+
+    for (size_t n = 0; n < iterations; n ++) {
+        sl_fcgi_response response;
+
+        sl_arena_rewind(arena);
+        sl_fcgi_response_init(&response, arena, log, 16);
+
+        if (sl_fcgi_response_append_buffer(&response, sl_bench_compress_body, length) == -1 ||
+            sl_compress_response(compress, &response, encoding) == -1) {
+            fprintf(stderr, "sl_compress_response() failed\n");
+            exit(EXIT_FAILURE);
+        }
+
+        compressed = response.output.length;
+    }
+
+    return compressed;
+}
+
+int main(void)
+{
+    sl_arena arena;
+    sl_log log;
+    char name[64];
+
+    sl_arena_init(&arena, SL_BENCH_COMPRESS_ARENA_PREALLOCATE);
+    sl_log_init(&log, SL_LOG_ERROR, STDERR_FILENO);
+
+    size_t fixtures = sizeof(sl_bench_compress_fixtures) / sizeof(sl_bench_compress_fixture);
+    size_t sizes = sizeof(sl_bench_compress_sizes) / sizeof(size_t);
+    size_t levels = sizeof(sl_bench_compress_levels) / sizeof(int);
+
+    for (size_t f = 0; f < fixtures; f ++) {
+        sl_bench_compress_fixture *fixture = &sl_bench_compress_fixtures[f];
+
+        fixture->fill(sl_bench_compress_body, SL_BENCH_COMPRESS_MAX_SIZE);
+
+        for (size_t s = 0; s < sizes; s ++) {
+            size_t length = sl_bench_compress_sizes[s];
+            size_t iterations = SL_BENCH_COMPRESS_BYTES / length / 8;
+
+            for (size_t l = 0; l < levels; l ++) {
+                sl_compress compress;
+
+                sl_compress_init(&compress, sl_bench_compress_levels[l], 0);
+                sl_bench_compress_run(&compress, &arena, &log, length, SL_COMPRESS_ENCODING_GZIP, iterations / 10 + 1);
+
+                uint64_t start = sl_bench_now();
+                size_t compressed = sl_bench_compress_run(&compress, &arena, &log, length, SL_COMPRESS_ENCODING_GZIP, iterations);
+                uint64_t elapsed = sl_bench_now() - start;
+
+                snprintf(name, sizeof(name), "compress/%s/%zu/gzip-%d", fixture->name, length, sl_bench_compress_levels[l]);
+                sl_bench_report(name, iterations, length, elapsed);
+
+                if (compress.skipped > 0) {
+                    printf("%-40s %12s\n", "", "incompressible, sent as identity");
+                } else {
+                    size_t saved = length - compressed;
+
+                    printf("%-40s %12.2f ns/byte saved %6.1f%% ratio\n", "", (double) elapsed / iterations / saved, 100.0 * compressed / length);
+                }
+
+                sl_compress_destroy(&compress);
+            }
+        }
+    }
+
+    sl_arena_destroy(&arena);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,594 @@
+#define SL_BENCH_COUNT_MALLOCS
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <arpa/inet.h>
+
+#include "sl_bench.h"
+#include "../sl_arena.h"
+#include "../sl_string.h"
+#include "../sl_hashtable.h"
+#include "../sl_slab.h"
+#include "../sl_log.h"
+#include "../sl_fcgi.h"
+
+#define SL_BENCH_CORE_ARENA_PREALLOCATE 102400
+#define SL_BENCH_CORE_REWIND_INTERVAL   1024
+#define SL_BENCH_CORE_APPEND_INTERVAL   64
+#define SL_BENCH_CORE_NGINX_PARAMS      20
+#define SL_BENCH_CORE_UPLOAD_SIZE       (128 * 1024)
+#define SL_BENCH_CORE_MAX_FIXTURES      64
+#define SL_BENCH_CORE_REQUEST_BUDGET    (1024 * 1024)
+
+typedef struct sl_bench_core_fixture sl_bench_core_fixture;
+typedef struct sl_bench_core_param_set sl_bench_core_param_set;
+typedef struct sl_bench_core_body sl_bench_core_body;
+
+struct sl_bench_core_fixture {
+    sl_arena arena;
+    size_t allocations;
+    size_t arena_bytes;
+    sl_string *keys;
+    sl_string *values;
+    sl_string *missing;
+    size_t count;
+    sl_hashtable hashtable;
+    sl_string string;
+    uint8_t *request;
+    size_t request_length;
+    sl_slab *param_slab;
+    sl_log *log;
+};
+
+struct sl_bench_core_param_set {
+    char *name;
+    char **pairs;
+    size_t count;
+};
+
+struct sl_bench_core_body {
+    char *name;
+    char *data;
+    size_t length;
+};
+
+static char *sl_bench_core_params[] = {
+    "QUERY_STRING", "page=2&sort=price_desc&category=shoes",
+    "REQUEST_METHOD", "GET",
+    "CONTENT_TYPE", "",
+    "CONTENT_LENGTH", "",
+    "SCRIPT_NAME", "/index.php",
+    "REQUEST_URI", "/catalog/shoes?page=2&sort=price_desc&category=shoes",
+    "DOCUMENT_URI", "/index.php",
+    "DOCUMENT_ROOT", "/var/www/shop/public",
+    "SERVER_PROTOCOL", "HTTP/1.1",
+    "REQUEST_SCHEME", "https",
+    "HTTPS", "on",
+    "GATEWAY_INTERFACE", "CGI/1.1",
+    "SERVER_SOFTWARE", "nginx/1.24.0",
+    "REMOTE_ADDR", "203.0.113.42",
+    "REMOTE_PORT", "51724",
+    "SERVER_ADDR", "10.0.0.5",
+    "SERVER_PORT", "443",
+    "SERVER_NAME", "shop.example.com",
+    "REDIRECT_STATUS", "200",
+    "SCRIPT_FILENAME", "/var/www/shop/public/index.php",
+    "HTTP_HOST", "shop.example.com",
+    "HTTP_CONNECTION", "keep-alive",
+    "HTTP_SEC_CH_UA", "\"Chromium\";v=\"128\", \"Not;A=Brand\";v=\"24\", \"Google Chrome\";v=\"128\"",
+    "HTTP_SEC_CH_UA_MOBILE", "?0",
+    "HTTP_SEC_CH_UA_PLATFORM", "\"Linux\"",
+    "HTTP_UPGRADE_INSECURE_REQUESTS", "1",
+    "HTTP_USER_AGENT", "Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/128.0.0.0 Safari/537.36",
+    "HTTP_ACCEPT", "text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,image/apng,*/*;q=0.8",
+    "HTTP_SEC_FETCH_SITE", "same-origin",
+    "HTTP_SEC_FETCH_MODE", "navigate",
+    "HTTP_SEC_FETCH_USER", "?1",
+    "HTTP_SEC_FETCH_DEST", "document",
+    "HTTP_REFERER", "https://shop.example.com/catalog/shoes?page=1&sort=price_desc&category=shoes",
+    "HTTP_ACCEPT_ENCODING", "gzip, deflate, br, zstd",
+    "HTTP_ACCEPT_LANGUAGE", "en-US,en;q=0.9,de;q=0.8",
+    "HTTP_COOKIE", "sessionid=6f1c2a9be0d34f7a8c51e2b9d0a4c7f3; csrftoken=Zk3pQ9xWmT2rL8vN5bY1hJ6gF4dS7aE0; theme=dark; _ga=GA1.2.1234567890.1700000000"
+};
+
+static char *sl_bench_core_headers[] = {
+    "Content-Type", "text/html; charset=utf-8",
+    "Cache-Control", "private, no-cache, no-store, must-revalidate",
+    "Vary", "Accept-Encoding, Cookie",
+    "ETag", "W/\"5e1f-18c3b2a7d40\"",
+    "Last-Modified", "Mon, 19 Oct 2026 08:12:45 GMT",
+    "Set-Cookie", "sessionid=6f1c2a9be0d34f7a8c51e2b9d0a4c7f3; Path=/; HttpOnly; Secure; SameSite=Lax",
+    "Strict-Transport-Security", "max-age=63072000; includeSubDomains; preload",
+    "Content-Security-Policy", "default-src 'self'; img-src 'self' data: https://cdn.example.com; script-src 'self'",
+    "X-Content-Type-Options", "nosniff",
+    "X-Frame-Options", "DENY"
+};
+
+static sl_bench_core_param_set sl_bench_core_param_sets[] = {
+    { "nginx", sl_bench_core_params, SL_BENCH_CORE_NGINX_PARAMS },
+    { "browser", sl_bench_core_params, sizeof(sl_bench_core_params) / sizeof(char *) / 2 },
+    { "response", sl_bench_core_headers, sizeof(sl_bench_core_headers) / sizeof(char *) / 2 }
+};
+
+static char sl_bench_core_upload[SL_BENCH_CORE_UPLOAD_SIZE];
+
+static sl_bench_core_body sl_bench_core_bodies[] = {
+    { "none", "", 0 },
+    { "form", "username=alice&password=correct+horse+battery+staple&remember=1&csrfmiddlewaretoken=Zk3pQ9xWmT2rL8vN5bY1hJ6gF4dS7aE0", 0 },
+    { "upload", sl_bench_core_upload, sizeof(sl_bench_core_upload) }
+};
+
+static sl_bench_core_fixture sl_bench_core_fixtures[SL_BENCH_CORE_MAX_FIXTURES];
+static size_t sl_bench_core_fixture_count;
+
+static sl_bench_core_fixture *sl_bench_core_create_fixture(void)
+{
+    if (sl_bench_core_fixture_count >= SL_BENCH_CORE_MAX_FIXTURES) {
+        fprintf(stderr, "too many fixtures\n");
+        exit(EXIT_FAILURE);
+    }
+
+    sl_bench_core_fixture *fixture = &sl_bench_core_fixtures[sl_bench_core_fixture_count ++];
+
+    sl_arena_init(&fixture->arena, SL_BENCH_CORE_ARENA_PREALLOCATE);
+
+    return fixture;
+}
+
+static void sl_bench_core_rewind(sl_bench_core_fixture *fixture)
+{
+    fixture->allocations += fixture->arena.allocations;
+    fixture->arena_bytes += fixture->arena.used;
+
+    sl_arena_rewind(&fixture->arena);
+}
+
+static sl_string *sl_bench_core_create_strings(sl_arena *arena, char **pairs, size_t count, size_t offset, char *prefix)
+{
+    sl_string *strings = sl_arena_allocate(arena, sizeof(sl_string) * count);
+    if (strings == NULL) {
+        return NULL;
+    }
+
+    for (size_t n = 0; n < count; n ++) {
+        sl_string *string = sl_string_format(arena, "%s%s", prefix, pairs[n * 2 + offset]);
+        if (string == NULL) {
+            return NULL;
+        }
+
+        strings[n] = *string;
+    }
+
+    return strings;
+}
+
+static void sl_bench_core_load_pairs(sl_bench_core_fixture *fixture, sl_arena *arena, sl_bench_core_param_set *set)
+{
+    fixture->count = set->count;
+    fixture->keys = sl_bench_core_create_strings(arena, set->pairs, set->count, 0, "");
+    fixture->values = sl_bench_core_create_strings(arena, set->pairs, set->count, 1, "");
+    fixture->missing = sl_bench_core_create_strings(arena, set->pairs, set->count, 0, "X_");
+
+    if (fixture->keys == NULL || fixture->values == NULL || fixture->missing == NULL) {
+        fprintf(stderr, "unable to create fixture strings\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+static uint64_t sl_bench_core_arena_small(void *context, size_t iterations)
+{
+    sl_bench_core_fixture *fixture = context;
+    uint64_t sink = 0;
+
+    for (size_t n = 0; n < iterations; n ++) {
+        if (n % SL_BENCH_CORE_REWIND_INTERVAL == 0) {
+            sl_bench_core_rewind(fixture);
+        }
+
+        sink += (uintptr_t) sl_arena_allocate(&fixture->arena, 8 + (n & 15) * 8);
+    }
+
+    return sink;
+}
+
+static uint64_t sl_bench_core_arena_mixed(void *context, size_t iterations)
+{
+    sl_bench_core_fixture *fixture = context;
+    uint64_t sink = 0;
+
+    for (size_t n = 0; n < iterations; n ++) {
+        if (n % SL_BENCH_CORE_REWIND_INTERVAL == 0) {
+            sl_bench_core_rewind(fixture);
+        }
+
+        size_t size = (n & 63) == 63 ? 16384 : (n & 7) == 7 ? 1024 : 8 + (n & 15) * 8;
+
+        sink += (uintptr_t) sl_arena_allocate(&fixture->arena, size);
+    }
+
+    return sink;
+}
+
+static uint64_t sl_bench_core_hashtable_set(void *context, size_t iterations)
+{
+    sl_bench_core_fixture *fixture = context;
+    uint64_t sink = 0;
+
+    for (size_t n = 0; n < iterations; n ++) {
+        size_t index = n % fixture->count;
+
+        if (index == 0) {
+            sl_bench_core_rewind(fixture);
+            sl_hashtable_init(&fixture->hashtable, &fixture->arena, 16, true);
+        }
+
+        sink += sl_hashtable_set(&fixture->hashtable, &fixture->keys[index], &fixture->values[index]);
+    }
+
+    return sink;
+}
+
+static uint64_t sl_bench_core_hashtable_hit(void *context, size_t iterations)
+{
+    sl_bench_core_fixture *fixture = context;
+    uint64_t sink = 0;
+
+    for (size_t n = 0; n < iterations; n ++) {
+        sink += (uintptr_t) sl_hashtable_get(&fixture->hashtable, &fixture->keys[n % fixture->count]);
+    }
+
+    return sink;
+}
+
+static uint64_t sl_bench_core_hashtable_miss(void *context, size_t iterations)
+{
+    sl_bench_core_fixture *fixture = context;
+    uint64_t sink = 0;
+
+    for (size_t n = 0; n < iterations; n ++) {
+        sink += (uintptr_t) sl_hashtable_get(&fixture->hashtable, &fixture->missing[n % fixture->count]);
+    }
+
+    return sink;
+}
+
+static uint64_t sl_bench_core_string_append(void *context, size_t iterations)
+{
+    sl_bench_core_fixture *fixture = context;
+    uint64_t sink = 0;
+
+    for (size_t n = 0; n < iterations; n ++) {
+        if (n % SL_BENCH_CORE_APPEND_INTERVAL == 0) {
+            sink += fixture->string.length;
+            sl_bench_core_rewind(fixture);
+            fixture->string = (sl_string) {0};
+        }
+
+        sl_string *value = &fixture->values[n % fixture->count];
+
+        sink += sl_string_append_with_buffer(&fixture->arena, &fixture->string, value->buffer, value->length);
+    }
+
+    return sink;
+}
+
+static uint64_t sl_bench_core_string_format_header(void *context, size_t iterations)
+{
+    sl_bench_core_fixture *fixture = context;
+    uint64_t sink = 0;
+
+    for (size_t n = 0; n < iterations; n ++) {
+        if (n % SL_BENCH_CORE_REWIND_INTERVAL == 0) {
+            sl_bench_core_rewind(fixture);
+        }
+
+        size_t index = n % fixture->count;
+
+        sink += (uintptr_t) sl_string_format(&fixture->arena, "%S: %S\r\n", &fixture->keys[index], &fixture->values[index]);
+    }
+
+    return sink;
+}
+
+static uint64_t sl_bench_core_string_format_numbers(void *context, size_t iterations)
+{
+    sl_bench_core_fixture *fixture = context;
+    uint64_t sink = 0;
+
+    for (size_t n = 0; n < iterations; n ++) {
+        if (n % SL_BENCH_CORE_REWIND_INTERVAL == 0) {
+            sl_bench_core_rewind(fixture);
+        }
+
+        sink += (uintptr_t) sl_string_format(&fixture->arena, "Request memory: %z allocations, %z bytes used, %z bytes in %z blocks", n, n * 977, n * 4096, n & 7);
+    }
+
+    return sink;
+}
+
+static void sl_bench_core_parse(sl_bench_core_fixture *fixture, sl_fcgi_request *request)
+{
+    sl_fcgi_parser parser;
+    size_t offset = 0;
+
+    sl_fcgi_parser_init(&parser, &fixture->arena, fixture->param_slab, fixture->log);
+    sl_fcgi_request_init(request, &fixture->arena, fixture->log, 64);
+
+    while (offset < fixture->request_length) {
+        offset += sl_fcgi_parser_parse(&parser, fixture->request + offset, fixture->request_length - offset);
+
+        if (parser.state == SL_FCGI_PARSER_STATE_ERROR) {
+            request->state = SL_FCGI_REQUEST_STATE_ERROR;
+            return;
+        }
+
+        if (parser.state == SL_FCGI_PARSER_STATE_FINISHED) {
+            sl_fcgi_request_process(request, &parser);
+
+            if (request->state == SL_FCGI_REQUEST_STATE_FINISHED || request->state == SL_FCGI_REQUEST_STATE_ERROR) {
+                return;
+            }
+
+            sl_fcgi_parser_init(&parser, &fixture->arena, fixture->param_slab, fixture->log);
+        }
+    }
+}
+
+static uint64_t sl_bench_core_parser(void *context, size_t iterations)
+{
+    sl_bench_core_fixture *fixture = context;
+    sl_fcgi_request request;
+    uint64_t sink = 0;
+
+    for (size_t n = 0; n < iterations; n ++) {
+        sl_bench_core_rewind(fixture);
+        sl_bench_core_parse(fixture, &request);
+
+        if (request.state != SL_FCGI_REQUEST_STATE_FINISHED) {
+            fprintf(stderr, "FCGI request failed to parse\n");
+            exit(EXIT_FAILURE);
+        }
+
+        sink += request.parameters.count + request.stdin.length;
+    }
+
+    return sink;
+}
+
+static int sl_bench_core_append_record(sl_string_builder *builder, uint8_t type, uint8_t *content, size_t length)
+{
+    do {
+        size_t chunk = length < SL_FCGI_MAX_CONTENT_LENGTH ? length : SL_FCGI_MAX_CONTENT_LENGTH;
+        uint8_t padding[8] = {0}, padding_length = (8 - chunk % 8) % 8;
+
+        sl_fcgi_msg_header header = {
+            .version = SL_FCGI_VERSION,
+            .type = type,
+            .request_id = htons(1),
+            .content_length = htons(chunk),
+            .padding_length = padding_length,
+            .reserved = 0
+        };
+
+        if (sl_string_builder_append(builder, (char *) &header, sizeof(header)) == -1 ||
+            sl_string_builder_append(builder, (char *) content, chunk) == -1 ||
+            sl_string_builder_append(builder, (char *) padding, padding_length) == -1) {
+            return -1;
+        }
+
+        content += chunk;
+        length -= chunk;
+    } while (length > 0);
+
+    return 0;
+}
+
+static int sl_bench_core_append_length(sl_string_builder *builder, size_t length)
+{
+    if (length < 128) {
+        uint8_t byte = length;
+        return sl_string_builder_append(builder, (char *) &byte, 1);
+    }
+
+    uint32_t word = htonl(length | 0x80000000);
+
+    return sl_string_builder_append(builder, (char *) &word, sizeof(word));
+}
+
+static int sl_bench_core_encode_request(sl_bench_core_fixture *fixture, sl_arena *arena, sl_bench_core_param_set *set, sl_bench_core_body *body)
+{
+    sl_string_builder params, request;
+    sl_fcgi_msg_begin begin = {
+        .role = htons(1),
+        .flags = SL_FCGI_FLAG_KEEP_CONN
+    };
+
+    sl_string_builder_init(&params, arena);
+    sl_string_builder_init(&request, arena);
+
+    for (size_t n = 0; n < set->count; n ++) {
+        char *name = set->pairs[n * 2], *value = set->pairs[n * 2 + 1];
+        size_t name_length = strlen(name), value_length = strlen(value);
+
+        if (sl_bench_core_append_length(&params, name_length) == -1 ||
+            sl_bench_core_append_length(&params, value_length) == -1 ||
+            sl_string_builder_append(&params, name, name_length) == -1 ||
+            sl_string_builder_append(&params, value, value_length) == -1) {
+            return -1;
+        }
+    }
+
+    if (sl_bench_core_append_record(&request, SL_FCGI_TYPE_BEGIN_REQUEST, (uint8_t *) &begin, sizeof(begin)) == -1 ||
+        sl_bench_core_append_record(&request, SL_FCGI_TYPE_PARAMS, (uint8_t *) params.string.buffer, params.string.length) == -1 ||
+        sl_bench_core_append_record(&request, SL_FCGI_TYPE_PARAMS, NULL, 0) == -1 ||
+        (body->length > 0 && sl_bench_core_append_record(&request, SL_FCGI_TYPE_STDIN, (uint8_t *) body->data, body->length) == -1) ||
+        sl_bench_core_append_record(&request, SL_FCGI_TYPE_STDIN, NULL, 0) == -1) {
+        return -1;
+    }
+
+    fixture->request = (uint8_t *) request.string.buffer;
+    fixture->request_length = request.string.length;
+
+    return 0;
+}
+
+static void sl_bench_core_check_budget(sl_arena *arena, sl_slab *param_slab, sl_log *log, size_t length, bool accepted)
+{
+    char content_length[32];
+    char *pairs[] = { "CONTENT_LENGTH", content_length, "DOCUMENT_URI", "/upload" };
+    sl_bench_core_param_set set = { "budget", pairs, 2 };
+    sl_bench_core_body body = { "budget", malloc(length), length };
+    sl_bench_core_fixture *fixture = sl_bench_core_create_fixture();
+    sl_fcgi_request request;
+
+    if (body.data == NULL) {
+        fprintf(stderr, "unable to allocate request body\n");
+        exit(EXIT_FAILURE);
+    }
+
+    memset(body.data, 'x', length);
+    snprintf(content_length, sizeof(content_length), "%zu", length);
+
+    fixture->param_slab = param_slab;
+    fixture->log = log;
+    sl_arena_set_limit(&fixture->arena, SL_BENCH_CORE_REQUEST_BUDGET);
+
+    if (sl_bench_core_encode_request(fixture, arena, &set, &body) == -1) {
+        fprintf(stderr, "unable to encode FCGI request\n");
+        exit(EXIT_FAILURE);
+    }
+
+    sl_bench_core_parse(fixture, &request);
+
+    if ((request.state == SL_FCGI_REQUEST_STATE_FINISHED && request.stdin.length == length) != accepted) {
+        fprintf(stderr, "%zu byte body with a %d byte budget was %s, %zu bytes in %zu arena blocks\n", length, SL_BENCH_CORE_REQUEST_BUDGET,
+            accepted == true ? "rejected" : "accepted", fixture->arena.allocated, fixture->arena.blocks);
+        exit(EXIT_FAILURE);
+    }
+
+    printf("%-40s %12zu bytes %s, %zu arena bytes\n", "core/parser/budget", length, accepted == true ? "accepted" : "rejected", fixture->arena.allocated);
+
+    free(body.data);
+}
+
+static void sl_bench_core_run(char *name, sl_bench_function function, sl_bench_core_fixture *fixture, size_t bytes)
+{
+    sl_bench_result result = {
+        .name = name,
+        .bytes = bytes
+    };
+
+    sl_bench_measure(&result, function, fixture);
+
+    sl_bench_core_rewind(fixture);
+
+    fixture->allocations = 0;
+    fixture->arena_bytes = 0;
+
+    sl_bench_sink += function(fixture, result.iterations);
+    sl_bench_core_rewind(fixture);
+
+    result.allocations_per_op = (double) fixture->allocations / result.iterations;
+    result.arena_bytes_per_op = (double) fixture->arena_bytes / result.iterations;
+
+    sl_bench_emit(&result);
+}
+
+int main(void)
+{
+    sl_arena fixtures_arena;
+    sl_slab param_slab;
+    sl_log log;
+    char name[64];
+
+    int fd = open("/dev/null", O_WRONLY);
+    if (fd == -1) {
+        perror("open()");
+        return EXIT_FAILURE;
+    }
+
+    if (sl_hashtable_init_seed() == -1) {
+        fprintf(stderr, "sl_hashtable_init_seed() failed\n");
+        return EXIT_FAILURE;
+    }
+
+    sl_arena_init(&fixtures_arena, SL_BENCH_CORE_ARENA_PREALLOCATE);
+    sl_slab_init(&param_slab, sizeof(sl_fcgi_msg_param), 256);
+    sl_log_init(&log, SL_LOG_ERROR, fd);
+
+    for (size_t n = 0; n < sizeof(sl_bench_core_upload); n ++) {
+        sl_bench_core_upload[n] = "{\"id\":1024,\"name\":\"item\",\"tags\":[\"a\",\"b\"]}\n"[n % 44];
+    }
+
+    sl_bench_core_bodies[1].length = strlen(sl_bench_core_bodies[1].data);
+
+    sl_bench_core_run("core/arena/allocate/small", sl_bench_core_arena_small, sl_bench_core_create_fixture(), 0);
+    sl_bench_core_run("core/arena/allocate/mixed", sl_bench_core_arena_mixed, sl_bench_core_create_fixture(), 0);
+
+    for (size_t s = 0; s < sizeof(sl_bench_core_param_sets) / sizeof(sl_bench_core_param_set); s ++) {
+        sl_bench_core_param_set *set = &sl_bench_core_param_sets[s];
+        sl_bench_core_fixture *fixture = sl_bench_core_create_fixture();
+
+        sl_bench_core_load_pairs(fixture, &fixtures_arena, set);
+
+        snprintf(name, sizeof(name), "core/hashtable/set/%s", set->name);
+        sl_bench_core_run(name, sl_bench_core_hashtable_set, fixture, 0);
+
+        sl_hashtable_init(&fixture->hashtable, &fixtures_arena, 16, true);
+
+        for (size_t n = 0; n < fixture->count; n ++) {
+            if (sl_hashtable_set(&fixture->hashtable, &fixture->keys[n], &fixture->values[n]) == -1) {
+                fprintf(stderr, "sl_hashtable_set() failed\n");
+                return EXIT_FAILURE;
+            }
+        }
+
+        snprintf(name, sizeof(name), "core/hashtable/hit/%s", set->name);
+        sl_bench_core_run(name, sl_bench_core_hashtable_hit, fixture, 0);
+
+        snprintf(name, sizeof(name), "core/hashtable/miss/%s", set->name);
+        sl_bench_core_run(name, sl_bench_core_hashtable_miss, fixture, 0);
+
+        snprintf(name, sizeof(name), "core/string/append/%s", set->name);
+        sl_bench_core_run(name, sl_bench_core_string_append, fixture, 0);
+
+        snprintf(name, sizeof(name), "core/string/format/%s", set->name);
+        sl_bench_core_run(name, sl_bench_core_string_format_header, fixture, 0);
+    }
+
+    sl_bench_core_run("core/string/format/numbers", sl_bench_core_string_format_numbers, sl_bench_core_create_fixture(), 0);
+
+    for (size_t s = 0; s < 2; s ++) {
+        for (size_t b = 0; b < sizeof(sl_bench_core_bodies) / sizeof(sl_bench_core_body); b ++) {
+            sl_bench_core_fixture *fixture = sl_bench_core_create_fixture();
+
+            fixture->param_slab = &param_slab;
+            fixture->log = &log;
+
+            if (sl_bench_core_encode_request(fixture, &fixtures_arena, &sl_bench_core_param_sets[s], &sl_bench_core_bodies[b]) == -1) {
+                fprintf(stderr, "unable to encode FCGI request\n");
+                return EXIT_FAILURE;
+            }
+
+            snprintf(name, sizeof(name), "core/parser/%s/%s", sl_bench_core_param_sets[s].name, sl_bench_core_bodies[b].name);
+            sl_bench_core_run(name, sl_bench_core_parser, fixture, fixture->request_length);
+        }
+    }
+
+    sl_bench_core_check_budget(&fixtures_arena, &param_slab, &log, SL_BENCH_CORE_REQUEST_BUDGET - SL_BENCH_CORE_ARENA_PREALLOCATE - 4096, true);
+    sl_bench_core_check_budget(&fixtures_arena, &param_slab, &log, SL_BENCH_CORE_REQUEST_BUDGET, false);
+
+    for (size_t n = 0; n < sl_bench_core_fixture_count; n ++) {
+        sl_arena_destroy(&sl_bench_core_fixtures[n].arena);
+    }
+
+    sl_slab_destroy(&param_slab);
+    sl_arena_destroy(&fixtures_arena);
+    close(fd);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,336 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "sl_bench.h"
+#include "../sl_arena.h"
+#include "../sl_cpu.h"
+#include "../sl_rope.h"
+#include "../sl_encode.h"
+
+#define SL_BENCH_ENCODE_BYTES             (256 * 1024 * 1024)
+#define SL_BENCH_ENCODE_MAX_SIZE          (64 * 1024)
+#define SL_BENCH_ENCODE_ARENA_PREALLOCATE (256 * 1024)
+#define SL_BENCH_ENCODE_FUZZ_ITERATIONS   200000
+#define SL_BENCH_ENCODE_FUZZ_SIZE         96
+
+typedef struct sl_bench_encode_fixture sl_bench_encode_fixture;
+
+struct sl_bench_encode_fixture {
+    char *name;
+    void (*fill)(char *buffer, size_t length);
+};
+
+static char *sl_bench_encode_levels[SL_CPU_MAX] = {
+    "scalar", "sse2", "avx2"
+};
+
+static size_t sl_bench_encode_sizes[] = {64, 1024, SL_BENCH_ENCODE_MAX_SIZE};
+
+static char sl_bench_encode_input[SL_BENCH_ENCODE_MAX_SIZE + 4];
+static char sl_bench_encode_output[SL_BENCH_ENCODE_MAX_SIZE + 4];
+static uint64_t sl_bench_encode_state = 0x9e3779b97f4a7c15;
+
+static volatile size_t sl_bench_encode_sink;
+
+static uint64_t sl_bench_encode_random(void)
+{
+    sl_bench_encode_state ^= sl_bench_encode_state << 13;
+    sl_bench_encode_state ^= sl_bench_encode_state >> 7;
+    sl_bench_encode_state ^= sl_bench_encode_state << 17;
+
+    return sl_bench_encode_state;
+}
+
+static void sl_bench_encode_fill_text(char *buffer, size_t length, char *source)
+{
+    size_t source_length = strlen(source);
+
+    for (size_t n = 0; n < length; n ++) {
+        buffer[n] = source[n % source_length];
+    }
+}
+
+static void sl_bench_encode_fill_clean(char *buffer, size_t length)
+{
+    sl_bench_encode_fill_text(buffer, length, "The quick brown fox jumps over the lazy dog, again and again. ");
+}
+
+static void sl_bench_encode_fill_comment(char *buffer, size_t length)
+{
+    sl_bench_encode_fill_text(buffer, length, "I'd say \"use <b>bold</b>\" & move on; it's fine for most of the comments we get. ");
+}
+
+static void sl_bench_encode_fill_markup(char *buffer, size_t length)
+{
+    sl_bench_encode_fill_text(buffer, length, "<a href=\"x\">'&'</a>");
+}
+
+static size_t sl_bench_encode_codepoint(char *buffer, uint32_t codepoint)
+{
+    if (codepoint < 0x80) {
+        buffer[0] = (char) codepoint;
+        return 1;
+    } else if (codepoint < 0x800) {
+        buffer[0] = (char) (0xc0 | (codepoint >> 6));
+        buffer[1] = (char) (0x80 | (codepoint & 0x3f));
+        return 2;
+    } else if (codepoint < 0x10000) {
+        buffer[0] = (char) (0xe0 | (codepoint >> 12));
+        buffer[1] = (char) (0x80 | ((codepoint >> 6) & 0x3f));
+        buffer[2] = (char) (0x80 | (codepoint & 0x3f));
+        return 3;
+    }
+
+    buffer[0] = (char) (0xf0 | (codepoint >> 18));
+    buffer[1] = (char) (0x80 | ((codepoint >> 12) & 0x3f));
+    buffer[2] = (char) (0x80 | ((codepoint >> 6) & 0x3f));
+    buffer[3] = (char) (0x80 | (codepoint & 0x3f));
+    return 4;
+}
+
+static void sl_bench_encode_fill_codepoints(char *buffer, size_t length, uint32_t low, uint32_t high)
+{
+    size_t n = 0;
+
+    while (n < length) {
+        char sequence[4];
+        uint32_t codepoint = low + sl_bench_encode_random() % (high - low);
+
+        if (codepoint >= 0xd800 && codepoint <= 0xdfff) {
+            continue;
+        }
+
+        size_t size = sl_bench_encode_codepoint(sequence, codepoint);
+        if (n + size > length) {
+            size = sl_bench_encode_codepoint(sequence, 'x');
+        }
+
+        memcpy(buffer + n, sequence, size);
+        n += size;
+    }
+}
+
+static void sl_bench_encode_fill_ascii(char *buffer, size_t length)
+{
+    sl_bench_encode_fill_codepoints(buffer, length, 0x20, 0x7f);
+}
+
+static void sl_bench_encode_fill_latin(char *buffer, size_t length)
+{
+    sl_bench_encode_fill_codepoints(buffer, length, 0x20, 0x180);
+}
+
+static void sl_bench_encode_fill_cjk(char *buffer, size_t length)
+{
+    sl_bench_encode_fill_codepoints(buffer, length, 0x4e00, 0x9fff);
+}
+
+static void sl_bench_encode_fill_emoji(char *buffer, size_t length)
+{
+    sl_bench_encode_fill_codepoints(buffer, length, 0x1f300, 0x1f64f);
+}
+
+static sl_bench_encode_fixture sl_bench_encode_html_fixtures[] = {
+    { "clean", sl_bench_encode_fill_clean },
+    { "comment", sl_bench_encode_fill_comment },
+    { "markup", sl_bench_encode_fill_markup }
+};
+
+static sl_bench_encode_fixture sl_bench_encode_utf8_fixtures[] = {
+    { "ascii", sl_bench_encode_fill_ascii },
+    { "latin", sl_bench_encode_fill_latin },
+    { "cjk", sl_bench_encode_fill_cjk },
+    { "emoji", sl_bench_encode_fill_emoji }
+};
+
+static void sl_bench_encode_verify_html(sl_arena *arena, sl_cpu_level level)
+{
+    static char alphabet[] = "ab<>&\"'`= \xc3\xa9";
+    char input[SL_BENCH_ENCODE_FUZZ_SIZE];
+
+    for (size_t iteration = 0; iteration < SL_BENCH_ENCODE_FUZZ_ITERATIONS / 10; iteration ++) {
+        size_t length = sl_bench_encode_random() % SL_BENCH_ENCODE_FUZZ_SIZE;
+
+        for (size_t n = 0; n < length; n ++) {
+            input[n] = sl_bench_encode_random() % 8 == 0 ? alphabet[sl_bench_encode_random() % (sizeof(alphabet) - 1)] : 'x';
+        }
+
+        for (sl_encode_context context = SL_ENCODE_CONTEXT_HTML; context < SL_ENCODE_CONTEXTS; context ++) {
+            sl_string source = sl_string_init_with_buffer(input, length);
+            sl_rope rope;
+
+            sl_arena_rewind(arena);
+
+            sl_cpu_set_level(SL_CPU_SCALAR);
+            sl_string *expected = sl_encode_html_string(arena, &source, context);
+
+            sl_cpu_set_level(level);
+            sl_rope_init(&rope, arena);
+
+            if (expected == NULL || sl_encode_html_rope(&rope, input, length, context) == -1 ||
+                sl_encode_html_length(input, length, context) != expected->length || rope.length != expected->length ||
+                sl_rope_flatten(&rope, sl_bench_encode_output, sizeof(sl_bench_encode_output)) != expected->length ||
+                memcmp(sl_bench_encode_output, expected->buffer, expected->length) != 0) {
+                fprintf(stderr, "html: %s mismatch for %.*s\n", sl_bench_encode_levels[level], (int) length, input);
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+}
+
+static void sl_bench_encode_verify_utf8(sl_cpu_level level)
+{
+    static uint8_t interesting[] = {0x00, 0x41, 0x7f, 0x80, 0x8f, 0x90, 0x9f, 0xa0, 0xbf, 0xc0, 0xc1, 0xc2, 0xdf, 0xe0, 0xe1, 0xec, 0xed, 0xee, 0xef, 0xf0, 0xf1, 0xf3, 0xf4, 0xf5, 0xff};
+    static char *invalid[] = {"\xc0\xaf", "\xe0\x80\xaf", "\xed\xa0\x80", "\xf4\x90\x80\x80", "\xf8\x88\x80\x80\x80", "\xe2\x82", "\x80", "abc\xf0\x9f\x98"};
+    static char *valid[] = {"", "plain", "caf\xc3\xa9", "\xe2\x82\xac", "\xf0\x9f\x98\x80", "\xef\xbf\xbf", "\xf4\x8f\xbf\xbf"};
+    char input[SL_BENCH_ENCODE_FUZZ_SIZE];
+
+    sl_cpu_set_level(level);
+
+    for (size_t n = 0; n < sizeof(invalid) / sizeof(char *); n ++) {
+        if (sl_encode_utf8_is_valid(invalid[n], strlen(invalid[n])) == true) {
+            fprintf(stderr, "utf8: %s accepted invalid case %zu\n", sl_bench_encode_levels[level], n);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    for (size_t n = 0; n < sizeof(valid) / sizeof(char *); n ++) {
+        if (sl_encode_utf8_is_valid(valid[n], strlen(valid[n])) == false) {
+            fprintf(stderr, "utf8: %s rejected valid case %zu\n", sl_bench_encode_levels[level], n);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    for (size_t iteration = 0; iteration < SL_BENCH_ENCODE_FUZZ_ITERATIONS; iteration ++) {
+        size_t length = sl_bench_encode_random() % SL_BENCH_ENCODE_FUZZ_SIZE;
+
+        sl_bench_encode_fill_codepoints(input, length, 0x20, 0x10ffff);
+
+        if (length > 0 && iteration % 2 == 0) {
+            input[sl_bench_encode_random() % length] = (char) interesting[sl_bench_encode_random() % sizeof(interesting)];
+        }
+
+        sl_cpu_set_level(SL_CPU_SCALAR);
+        bool expected = sl_encode_utf8_is_valid(input, length);
+
+        sl_cpu_set_level(level);
+
+        if (sl_encode_utf8_is_valid(input, length) != expected) {
+            fprintf(stderr, "utf8: %s disagrees with scalar at length %zu\n", sl_bench_encode_levels[level], length);
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+static void sl_bench_encode_run_html(sl_arena *arena, sl_bench_encode_fixture *fixture, sl_cpu_level detected)
+{
+    char name[64];
+
+    for (size_t s = 0; s < sizeof(sl_bench_encode_sizes) / sizeof(size_t); s ++) {
+        size_t length = sl_bench_encode_sizes[s];
+        size_t iterations = SL_BENCH_ENCODE_BYTES / length / 16;
+
+        fixture->fill(sl_bench_encode_input, length);
+
+        for (sl_cpu_level level = SL_CPU_SCALAR; level <= detected; level ++) {
+            sl_cpu_set_level(level);
+
+            uint64_t start = sl_bench_now();
+
+            for (size_t n = 0; n < iterations; n ++) {
+                sl_rope rope;
+
+                sl_arena_rewind(arena);
+                sl_rope_init(&rope, arena);
+
+                if (sl_encode_html_rope(&rope, sl_bench_encode_input, length, SL_ENCODE_CONTEXT_HTML) == -1) {
+                    fprintf(stderr, "sl_encode_html_rope() failed\n");
+                    exit(EXIT_FAILURE);
+                }
+
+                sl_bench_encode_sink += rope.length;
+            }
+
+            snprintf(name, sizeof(name), "encode/html/%s/%zu/%s", fixture->name, length, sl_bench_encode_levels[level]);
+            sl_bench_report(name, iterations, length, sl_bench_now() - start);
+        }
+
+        uint64_t start = sl_bench_now();
+
+        for (size_t n = 0; n < iterations; n ++) {
+            memcpy(sl_bench_encode_output, sl_bench_encode_input, length);
+            __asm__ volatile("" ::: "memory");
+        }
+
+        snprintf(name, sizeof(name), "encode/html/%s/%zu/memcpy", fixture->name, length);
+        sl_bench_report(name, iterations, length, sl_bench_now() - start);
+    }
+}
+
+static void sl_bench_encode_run_utf8(sl_bench_encode_fixture *fixture, sl_cpu_level detected)
+{
+    char name[64];
+
+    for (size_t s = 0; s < sizeof(sl_bench_encode_sizes) / sizeof(size_t); s ++) {
+        size_t length = sl_bench_encode_sizes[s];
+        size_t iterations = SL_BENCH_ENCODE_BYTES / length / 4;
+
+        fixture->fill(sl_bench_encode_input, length);
+
+        for (sl_cpu_level level = SL_CPU_SCALAR; level <= detected; level ++) {
+            sl_cpu_set_level(level);
+
+            if (sl_encode_utf8_is_valid(sl_bench_encode_input, length) == false) {
+                fprintf(stderr, "utf8: %s rejected the %s fixture\n", sl_bench_encode_levels[level], fixture->name);
+                exit(EXIT_FAILURE);
+            }
+
+            uint64_t start = sl_bench_now();
+
+            for (size_t n = 0; n < iterations; n ++) {
+                sl_bench_encode_sink += sl_encode_utf8_is_valid(sl_bench_encode_input, length);
+                __asm__ volatile("" ::: "memory");
+            }
+
+            snprintf(name, sizeof(name), "encode/utf8/%s/%zu/%s", fixture->name, length, sl_bench_encode_levels[level]);
+            sl_bench_report(name, iterations, length, sl_bench_now() - start);
+        }
+
+        uint64_t start = sl_bench_now();
+
+        for (size_t n = 0; n < iterations; n ++) {
+            memcpy(sl_bench_encode_output, sl_bench_encode_input, length);
+            __asm__ volatile("" ::: "memory");
+        }
+
+        snprintf(name, sizeof(name), "encode/utf8/%s/%zu/memcpy", fixture->name, length);
+        sl_bench_report(name, iterations, length, sl_bench_now() - start);
+    }
+}
+
+int main(void)
+{
+    sl_arena arena;
+
+    sl_arena_init(&arena, SL_BENCH_ENCODE_ARENA_PREALLOCATE);
+
+    sl_cpu_level detected = sl_cpu_detect();
+
+    for (sl_cpu_level level = SL_CPU_SCALAR; level <= detected; level ++) {
+        sl_bench_encode_verify_html(&arena, level);
+        sl_bench_encode_verify_utf8(level);
+    }
+
+    for (size_t f = 0; f < sizeof(sl_bench_encode_html_fixtures) / sizeof(sl_bench_encode_fixture); f ++) {
+        sl_bench_encode_run_html(&arena, &sl_bench_encode_html_fixtures[f], detected);
+    }
+
+    for (size_t f = 0; f < sizeof(sl_bench_encode_utf8_fixtures) / sizeof(sl_bench_encode_fixture); f ++) {
+        sl_bench_encode_run_utf8(&sl_bench_encode_utf8_fixtures[f], detected);
+    }
+
+    sl_arena_destroy(&arena);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,133 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "sl_bench.h"
+#include "../sl_arena.h"
+#include "../sl_string.h"
+#include "../sl_format.h"
+
+#define SL_BENCH_FORMAT_ITERATIONS       2000000
+#define SL_BENCH_FORMAT_ARENA_PREALLOCATE 102400
+#define SL_BENCH_FORMAT_BUFFER_SIZE      256
+
+static char sl_bench_format_buffer[SL_BENCH_FORMAT_BUFFER_SIZE];
+static volatile size_t sl_bench_format_sink;
+
+static uint64_t sl_bench_format_parsed(size_t iterations, int use_snprintf)
+{
+    uint64_t start = sl_bench_now();
+
+    for (size_t n = 0; n < iterations; n ++) {
+        if (use_snprintf == 1) {
+            sl_bench_format_sink += snprintf(sl_bench_format_buffer, sizeof(sl_bench_format_buffer), "Parsed %zu bytes", n);
+        } else {
+            sl_bench_format_sink += sl_format(sl_bench_format_buffer, sizeof(sl_bench_format_buffer), "Parsed %z bytes", n);
+        }
+    }
+
+    return sl_bench_now() - start;
+}
+
+static uint64_t sl_bench_format_counters(size_t iterations, int use_snprintf)
+{
+    uint64_t start = sl_bench_now();
+
+    for (size_t n = 0; n < iterations; n ++) {
+        size_t used = n * 977, allocated = n * 4096;
+
+        if (use_snprintf == 1) {
+            sl_bench_format_sink += snprintf(sl_bench_format_buffer, sizeof(sl_bench_format_buffer), "Request memory: %zu allocations, %zu bytes used, %zu bytes in %zu blocks", n, used, allocated, n & 7);
+        } else {
+            sl_bench_format_sink += sl_format(sl_bench_format_buffer, sizeof(sl_bench_format_buffer), "Request memory: %z allocations, %z bytes used, %z bytes in %z blocks", n, used, allocated, n & 7);
+        }
+    }
+
+    return sl_bench_now() - start;
+}
+
+static uint64_t sl_bench_format_mixed(size_t iterations, int use_snprintf)
+{
+    uint64_t start = sl_bench_now();
+
+    for (size_t n = 0; n < iterations; n ++) {
+        int value = (int) (n * 2654435761u);
+        double ratio = (double) n / 7.0;
+
+        if (use_snprintf == 1) {
+            sl_bench_format_sink += snprintf(sl_bench_format_buffer, sizeof(sl_bench_format_buffer), "%-8s %08x %d %.3f %s", "worker", (unsigned int) n, value, ratio, "/index.html");
+        } else {
+            sl_bench_format_sink += sl_format(sl_bench_format_buffer, sizeof(sl_bench_format_buffer), "%-8s %08x %d %.3f %s", "worker", (unsigned int) n, value, ratio, "/index.html");
+        }
+    }
+
+    return sl_bench_now() - start;
+}
+
+static uint64_t sl_bench_format_string(sl_arena *arena, size_t iterations)
+{
+    uint64_t start = sl_bench_now();
+
+    for (size_t n = 0; n < iterations; n ++) {
+        if ((n & 1023) == 0) {
+            sl_arena_rewind(arena);
+        }
+
+        sl_string *string = sl_string_format(arena, "Parsed %z bytes", n);
+        if (string == NULL) {
+            fprintf(stderr, "sl_string_format() failed\n");
+            exit(EXIT_FAILURE);
+        }
+
+        sl_bench_format_sink += string->length;
+    }
+
+    return sl_bench_now() - start;
+}
+
+static uint64_t sl_bench_format_builder(sl_arena *arena, size_t iterations)
+{
+    sl_string_builder builder;
+
+    uint64_t start = sl_bench_now();
+
+    for (size_t n = 0; n < iterations; n ++) {
+        if ((n & 1023) == 0) {
+            sl_arena_rewind(arena);
+            sl_string_builder_init(&builder, arena);
+        }
+
+        if (sl_format_builder(&builder, "%z:%x;", n, (unsigned int) n) == -1) {
+            fprintf(stderr, "sl_format_builder() failed\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    sl_bench_format_sink += builder.string.length;
+
+    return sl_bench_now() - start;
+}
+
+int main(void)
+{
+    sl_arena arena;
+
+    sl_arena_init(&arena, SL_BENCH_FORMAT_ARENA_PREALLOCATE);
+
+    sl_bench_format_parsed(SL_BENCH_FORMAT_ITERATIONS / 10, 0);
+    sl_bench_report("format/parsed/sl_format", SL_BENCH_FORMAT_ITERATIONS, 0, sl_bench_format_parsed(SL_BENCH_FORMAT_ITERATIONS, 0));
+    sl_bench_report("format/parsed/snprintf", SL_BENCH_FORMAT_ITERATIONS, 0, sl_bench_format_parsed(SL_BENCH_FORMAT_ITERATIONS, 1));
+
+    sl_bench_report("format/counters/sl_format", SL_BENCH_FORMAT_ITERATIONS, 0, sl_bench_format_counters(SL_BENCH_FORMAT_ITERATIONS, 0));
+    sl_bench_report("format/counters/snprintf", SL_BENCH_FORMAT_ITERATIONS, 0, sl_bench_format_counters(SL_BENCH_FORMAT_ITERATIONS, 1));
+
+    sl_bench_report("format/mixed/sl_format", SL_BENCH_FORMAT_ITERATIONS, 0, sl_bench_format_mixed(SL_BENCH_FORMAT_ITERATIONS, 0));
+    sl_bench_report("format/mixed/snprintf", SL_BENCH_FORMAT_ITERATIONS, 0, sl_bench_format_mixed(SL_BENCH_FORMAT_ITERATIONS, 1));
+
+    sl_bench_report("format/sl_string_format", SL_BENCH_FORMAT_ITERATIONS, 0, sl_bench_format_string(&arena, SL_BENCH_FORMAT_ITERATIONS));
+    sl_bench_report("format/sl_format_builder", SL_BENCH_FORMAT_ITERATIONS, 0, sl_bench_format_builder(&arena, SL_BENCH_FORMAT_ITERATIONS));
+
+    sl_arena_destroy(&arena);
+
+    return EXIT_SUCCESS;
+}
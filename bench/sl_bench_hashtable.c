@@ -0,0 +1,338 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "sl_bench.h"
+#include "../sl_arena.h"
+#include "../sl_string.h"
+#include "../sl_hashtable.h"
+
+#define SL_BENCH_HASHTABLE_OPERATIONS 2000000
+#define SL_BENCH_HASHTABLE_ARENA_PREALLOCATE 1048576
+#define SL_BENCH_HASHTABLE_HASH_ITERATIONS 10000000
+#define SL_BENCH_HASHTABLE_COLLISION_BLOCKS 12
+#define SL_BENCH_HASHTABLE_REUSE_KEYS 100000
+#define SL_BENCH_HASHTABLE_REUSE_MINIMUM 90
+
+static size_t sl_bench_hashtable_sizes[] = {
+    8, 64, 512, 4096, 32768, 100000
+};
+
+static size_t sl_bench_hashtable_lengths[] = {
+    4, 8, 16, 32, 64, 256, 1024
+};
+
+static sl_hashtable_hash sl_bench_hashtable_hash_legacy(char *buffer, size_t length, uint64_t seed)
+{
+    sl_hashtable_hash hash = 0;
+
+    (void) seed;
+
+    for (size_t n = 0; n < length; n ++) {
+        hash = buffer[n] + (hash << 5) - hash;
+    }
+
+    return hash;
+}
+
+static void sl_bench_hashtable_hash(char *name, sl_hashtable_hash_function hash_function)
+{
+    char buffer[1024], report_name[64];
+    sl_hashtable_hash sink = 0;
+
+    for (size_t n = 0; n < sizeof(buffer); n ++) {
+        buffer[n] = 'A' + (n % 26);
+    }
+
+    for (size_t l = 0; l < sizeof(sl_bench_hashtable_lengths) / sizeof(size_t); l ++) {
+        size_t length = sl_bench_hashtable_lengths[l];
+        size_t iterations = SL_BENCH_HASHTABLE_HASH_ITERATIONS / (length / 4);
+
+        uint64_t start = sl_bench_now();
+
+        for (size_t n = 0; n < iterations; n ++) {
+            sink += hash_function(buffer, length, sink);
+        }
+
+        snprintf(report_name, sizeof(report_name), "hash/%s/%zu", name, length);
+        sl_bench_report(report_name, iterations, length, sl_bench_now() - start);
+    }
+
+    if (sink == 42) {
+        printf("\n");
+    }
+}
+
+static sl_string *sl_bench_hashtable_create_collisions(sl_arena *arena, size_t blocks, size_t *count)
+{
+    *count = (size_t) 1 << blocks;
+
+    sl_string *keys = sl_arena_allocate(arena, sizeof(sl_string) * *count);
+    if (keys == NULL) {
+        return NULL;
+    }
+
+    for (size_t n = 0; n < *count; n ++) {
+        char *buffer = sl_arena_allocate(arena, blocks * 2);
+        if (buffer == NULL) {
+            return NULL;
+        }
+
+        for (size_t b = 0; b < blocks; b ++) {
+            memcpy(buffer + b * 2, (n >> b) & 1 ? "BB" : "Aa", 2);
+        }
+
+        keys[n] = sl_string_init_with_buffer(buffer, blocks * 2);
+    }
+
+    return keys;
+}
+
+static void sl_bench_hashtable_attack(sl_arena *arena, char *name, sl_string *keys, size_t count, sl_hashtable_hash_function hash_function, size_t max_probe_groups)
+{
+    sl_hashtable hashtable;
+    char report_name[64];
+
+    sl_arena_rewind(arena);
+    sl_hashtable_init(&hashtable, arena, 64, true);
+    sl_hashtable_set_hash_function(&hashtable, hash_function);
+    hashtable.max_probe_groups = max_probe_groups;
+
+    uint64_t start = sl_bench_now();
+
+    for (size_t n = 0; n < count; n ++) {
+        sl_hashtable_set(&hashtable, &keys[n], &keys[n]);
+    }
+
+    uint64_t elapsed = sl_bench_now() - start;
+
+    snprintf(report_name, sizeof(report_name), "attack/%s/%zu", name, count);
+    sl_bench_report(report_name, count, 0, elapsed);
+    printf("%-40s %12zu stored %10zu rejected\n", "", hashtable.count, hashtable.rejected);
+}
+
+static sl_string *sl_bench_hashtable_create_keys(sl_arena *arena, char *prefix, size_t count)
+{
+    sl_string *keys = sl_arena_allocate(arena, sizeof(sl_string) * count);
+    if (keys == NULL) {
+        return NULL;
+    }
+
+    for (size_t n = 0; n < count; n ++) {
+        char buffer[64];
+        int length = snprintf(buffer, sizeof(buffer), "%s_%zu", prefix, n * 2654435761u % 1000003);
+
+        sl_string *key = sl_string_create_from_buffer(arena, buffer, length, length);
+        if (key == NULL) {
+            return NULL;
+        }
+
+        keys[n] = *key;
+    }
+
+    return keys;
+}
+
+static void sl_bench_hashtable_fill(sl_hashtable *hashtable, sl_string *keys, size_t count)
+{
+    for (size_t n = 0; n < count; n ++) {
+        if (sl_hashtable_set(hashtable, &keys[n], &keys[n]) == -1) {
+            fprintf(stderr, "sl_hashtable_set() failed\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+static void sl_bench_hashtable_verify(sl_arena *arena, sl_string *keys, sl_string *missing, size_t count)
+{
+    sl_hashtable hashtable;
+
+    sl_arena_rewind(arena);
+    sl_hashtable_init(&hashtable, arena, 16, true);
+    sl_bench_hashtable_fill(&hashtable, keys, count);
+
+    for (size_t n = 0; n < count; n += 2) {
+        if (sl_hashtable_delete(&hashtable, &keys[n]) == -1) {
+            fprintf(stderr, "sl_hashtable_delete() failed\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    size_t position = 0, iterated = 0;
+    while (sl_hashtable_next(&hashtable, &position) != NULL) {
+        iterated ++;
+    }
+
+    for (size_t n = 0; n < count; n ++) {
+        sl_string *value = sl_hashtable_get(&hashtable, &keys[n]);
+
+        if ((n % 2 == 0 && value != NULL) || (n % 2 == 1 && value != &keys[n]) || sl_hashtable_get(&hashtable, &missing[n]) != NULL) {
+            fprintf(stderr, "hashtable verification failed for %zu keys\n", count);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if (iterated != hashtable.count || hashtable.count != count / 2) {
+        fprintf(stderr, "hashtable iteration failed for %zu keys\n", count);
+        exit(EXIT_FAILURE);
+    }
+}
+
+static size_t sl_bench_hashtable_free_bytes(sl_arena *arena)
+{
+    size_t bytes = 0;
+
+    for (uint64_t classes = arena->free_mask; classes != 0; classes &= classes - 1) {
+        for (sl_arena_chunk *chunk = arena->free_chunks[__builtin_ctzl(classes)]; chunk != NULL; chunk = chunk->next) {
+            bytes += chunk->size;
+        }
+    }
+
+    return bytes;
+}
+
+static void sl_bench_hashtable_reuse(sl_arena *arena, sl_string *keys, size_t count, size_t object_size)
+{
+    sl_hashtable hashtable;
+    char report_name[64];
+
+    sl_arena_rewind(arena);
+    sl_hashtable_init(&hashtable, arena, 16, true);
+    sl_bench_hashtable_fill(&hashtable, keys, count);
+
+    size_t freed = sl_bench_hashtable_free_bytes(arena);
+    size_t allocated = arena->allocated, used = arena->current->used, reused = 0, objects = 0;
+    sl_arena_block *current = arena->current;
+
+    uint64_t start = sl_bench_now();
+
+    while (arena->free_mask != 0) {
+        if (sl_arena_allocate(arena, object_size) == NULL) {
+            fprintf(stderr, "sl_arena_allocate() failed\n");
+            exit(EXIT_FAILURE);
+        }
+
+        objects ++;
+
+        if (arena->current != current || arena->current->used != used || arena->allocated != allocated) {
+            break;
+        }
+
+        reused += object_size;
+    }
+
+    uint64_t elapsed = sl_bench_now() - start;
+
+    snprintf(report_name, sizeof(report_name), "reuse/hashtable/%zu", object_size);
+    sl_bench_report(report_name, objects, 0, elapsed);
+    printf("%-40s %12zu freed %10zu reused %3zu resizes\n", "", freed, reused, hashtable.resizes);
+
+    if (freed == 0 || reused * 100 < freed * SL_BENCH_HASHTABLE_REUSE_MINIMUM) {
+        fprintf(stderr, "only %zu of %zu bytes freed by hashtable resizes were reused\n", reused, freed);
+        exit(EXIT_FAILURE);
+    }
+}
+
+int main(void)
+{
+    sl_arena keys_arena, table_arena;
+    char name[64];
+
+    sl_arena_init(&keys_arena, SL_BENCH_HASHTABLE_ARENA_PREALLOCATE);
+    sl_arena_init(&table_arena, SL_BENCH_HASHTABLE_ARENA_PREALLOCATE);
+
+    if (sl_hashtable_init_seed() == -1) {
+        fprintf(stderr, "sl_hashtable_init_seed() failed\n");
+        return EXIT_FAILURE;
+    }
+
+    for (size_t s = 0; s < sizeof(sl_bench_hashtable_sizes) / sizeof(size_t); s ++) {
+        size_t count = sl_bench_hashtable_sizes[s];
+        size_t rounds = SL_BENCH_HASHTABLE_OPERATIONS / count;
+
+        sl_arena_rewind(&keys_arena);
+
+        sl_string *keys = sl_bench_hashtable_create_keys(&keys_arena, "HTTP_X_HEADER", count);
+        sl_string *missing = sl_bench_hashtable_create_keys(&keys_arena, "HTTP_X_MISSING", count);
+        if (keys == NULL || missing == NULL) {
+            fprintf(stderr, "unable to create keys\n");
+            return EXIT_FAILURE;
+        }
+
+        sl_bench_hashtable_verify(&table_arena, keys, missing, count);
+
+        sl_hashtable hashtable;
+        uint64_t start = sl_bench_now();
+
+        for (size_t r = 0; r < rounds; r ++) {
+            sl_arena_rewind(&table_arena);
+            sl_hashtable_init(&hashtable, &table_arena, 16, true);
+            sl_bench_hashtable_fill(&hashtable, keys, count);
+        }
+
+        snprintf(name, sizeof(name), "hashtable/insert/%zu", count);
+        sl_bench_report(name, rounds * count, 0, sl_bench_now() - start);
+
+        size_t found = 0;
+        start = sl_bench_now();
+
+        for (size_t r = 0; r < rounds; r ++) {
+            for (size_t n = 0; n < count; n ++) {
+                found += sl_hashtable_get(&hashtable, &keys[n]) != NULL;
+            }
+        }
+
+        snprintf(name, sizeof(name), "hashtable/hit/%zu", count);
+        sl_bench_report(name, rounds * count, 0, sl_bench_now() - start);
+
+        start = sl_bench_now();
+
+        for (size_t r = 0; r < rounds; r ++) {
+            for (size_t n = 0; n < count; n ++) {
+                found += sl_hashtable_get(&hashtable, &missing[n]) != NULL;
+            }
+        }
+
+        snprintf(name, sizeof(name), "hashtable/miss/%zu", count);
+        sl_bench_report(name, rounds * count, 0, sl_bench_now() - start);
+
+        if (found != rounds * count) {
+            fprintf(stderr, "unexpected lookup results\n");
+            return EXIT_FAILURE;
+        }
+    }
+
+    sl_bench_hashtable_hash("default", sl_hashtable_hash_default);
+    sl_bench_hashtable_hash("legacy", sl_bench_hashtable_hash_legacy);
+
+    size_t collisions;
+
+    sl_arena_rewind(&keys_arena);
+
+    sl_string *attack_keys = sl_bench_hashtable_create_collisions(&keys_arena, SL_BENCH_HASHTABLE_COLLISION_BLOCKS, &collisions);
+    if (attack_keys == NULL) {
+        fprintf(stderr, "unable to create keys\n");
+        return EXIT_FAILURE;
+    }
+
+    sl_bench_hashtable_attack(&table_arena, "legacy-unlimited", attack_keys, collisions, sl_bench_hashtable_hash_legacy, (size_t) -1);
+    sl_bench_hashtable_attack(&table_arena, "legacy-limited", attack_keys, collisions, sl_bench_hashtable_hash_legacy, SL_HASHTABLE_MAX_PROBE_GROUPS);
+    sl_bench_hashtable_attack(&table_arena, "default", attack_keys, collisions, sl_hashtable_hash_default, SL_HASHTABLE_MAX_PROBE_GROUPS);
+
+    sl_arena_rewind(&keys_arena);
+
+    sl_string *reuse_keys = sl_bench_hashtable_create_keys(&keys_arena, "HTTP_X_REUSE", SL_BENCH_HASHTABLE_REUSE_KEYS);
+    if (reuse_keys == NULL) {
+        fprintf(stderr, "unable to create keys\n");
+        return EXIT_FAILURE;
+    }
+
+    sl_bench_hashtable_reuse(&table_arena, reuse_keys, SL_BENCH_HASHTABLE_REUSE_KEYS, 24);
+    sl_bench_hashtable_reuse(&table_arena, reuse_keys, SL_BENCH_HASHTABLE_REUSE_KEYS, 32);
+    sl_bench_hashtable_reuse(&table_arena, reuse_keys, SL_BENCH_HASHTABLE_REUSE_KEYS, 4096);
+
+    sl_arena_destroy(&table_arena);
+    sl_arena_destroy(&keys_arena);
+
+    return EXIT_SUCCESS;
+}
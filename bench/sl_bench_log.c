@@ -0,0 +1,80 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "sl_bench.h"
+#include "../sl_string.h"
+#include "../sl_log.h"
+
+#define SL_BENCH_LOG_ITERATIONS 2000000
+
+static uint64_t sl_bench_log_parameter(sl_log *log, size_t iterations)
+{
+    sl_string name = sl_string_init_with_cstring("HTTP_ACCEPT_ENCODING");
+    sl_string value = sl_string_init_with_cstring("gzip, deflate, br");
+
+    uint64_t start = sl_bench_now();
+
+    for (size_t n = 0; n < iterations; n ++) {
+        SL_LOG_WRITE_FORMAT(log, SL_LOG_DEBUG, "FCGI parameter: %S=%S", &name, &value);
+    }
+
+    return sl_bench_now() - start;
+}
+
+static uint64_t sl_bench_log_counters(sl_log *log, size_t iterations)
+{
+    uint64_t start = sl_bench_now();
+
+    for (size_t n = 0; n < iterations; n ++) {
+        SL_LOG_WRITE_FORMAT(log, SL_LOG_INFO, "Request memory: %z allocations, %z bytes used, %z bytes in %z blocks", n, n * 977, n * 4096, n & 7);
+    }
+
+    return sl_bench_now() - start;
+}
+
+static void sl_bench_log_run(char *name, sl_log_mode mode, sl_log_level min_level, int fd)
+{
+    sl_log log;
+    sl_log_ring ring;
+    char label[64];
+
+    if (sl_log_ring_init(&ring, SL_LOG_RING_DEFAULT_SIZE, SL_LOG_OVERFLOW_BLOCK, fd) == -1) {
+        fprintf(stderr, "sl_log_ring_init() failed\n");
+        exit(EXIT_FAILURE);
+    }
+
+    sl_log_init(&log, min_level, fd);
+    sl_log_set_pid(&log, getpid());
+    sl_log_set_mode(&log, mode);
+    sl_log_set_ring(&log, &ring);
+
+    sl_bench_log_parameter(&log, SL_BENCH_LOG_ITERATIONS / 10);
+
+    snprintf(label, sizeof(label), "log/parameter/%s", name);
+    sl_bench_report(label, SL_BENCH_LOG_ITERATIONS, 0, sl_bench_log_parameter(&log, SL_BENCH_LOG_ITERATIONS));
+
+    snprintf(label, sizeof(label), "log/counters/%s", name);
+    sl_bench_report(label, SL_BENCH_LOG_ITERATIONS, 0, sl_bench_log_counters(&log, SL_BENCH_LOG_ITERATIONS));
+
+    sl_log_ring_destroy(&ring);
+}
+
+int main(void)
+{
+    int fd = open("/dev/null", O_WRONLY);
+    if (fd == -1) {
+        perror("open()");
+        return EXIT_FAILURE;
+    }
+
+    sl_bench_log_run("suppressed", SL_LOG_MODE_TEXT, SL_LOG_ERROR, fd);
+    sl_bench_log_run("text", SL_LOG_MODE_TEXT, SL_LOG_DEBUG, fd);
+    sl_bench_log_run("binary", SL_LOG_MODE_BINARY, SL_LOG_DEBUG, fd);
+
+    close(fd);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,123 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "sl_bench.h"
+#include "../sl_arena.h"
+#include "../sl_cpu.h"
+#include "../sl_query.h"
+
+#define SL_BENCH_QUERY_ITERATIONS 200000
+#define SL_BENCH_QUERY_ARENA_PREALLOCATE 102400
+
+typedef struct sl_bench_query_fixture sl_bench_query_fixture;
+
+struct sl_bench_query_fixture {
+    char *name;
+    sl_query_type type;
+    char *source;
+};
+
+static char *sl_bench_query_levels[SL_CPU_MAX] = {
+    "scalar", "sse2", "avx2"
+};
+
+static char sl_bench_query_long[4096];
+
+static sl_bench_query_fixture sl_bench_query_fixtures[] = {
+    { "short", SL_QUERY_TYPE_QUERY_STRING, "a=1&b=2" },
+    { "search", SL_QUERY_TYPE_QUERY_STRING, "q=fast+cgi+server%21&page=2&utm_source=newsletter&utm_medium=email&utm_campaign=autumn_launch_2026&ref=homepage_banner" },
+    { "cookie", SL_QUERY_TYPE_COOKIE, "sessionid=6f1c2a9be0d34f7a8c51e2b9d0a4c7f3; csrftoken=Zk3pQ9xWmT2rL8vN5bY1hJ6gF4dS7aE0; theme=dark; _ga=GA1.2.1234567890.1700000000" },
+    { "long", SL_QUERY_TYPE_QUERY_STRING, sl_bench_query_long }
+};
+
+static size_t sl_bench_query_run(sl_arena *arena, sl_bench_query_fixture *fixture, size_t iterations)
+{
+    sl_string source = sl_string_init_with_cstring(fixture->source);
+    sl_query query;
+    size_t pairs = 0;
+
+    for (size_t n = 0; n < iterations; n ++) {
+        sl_arena_rewind(arena);
+        sl_query_init(&query, arena, fixture->type);
+
+        if (sl_query_decode(&query, &source) == -1) {
+            fprintf(stderr, "sl_query_decode() failed\n");
+            exit(EXIT_FAILURE);
+        }
+
+        pairs += query.count;
+    }
+
+    return pairs;
+}
+
+static void sl_bench_query_verify(sl_arena *arena, sl_bench_query_fixture *fixture, sl_cpu_level level)
+{
+    sl_string source = sl_string_init_with_cstring(fixture->source);
+    sl_query scalar, vector;
+
+    sl_arena_rewind(arena);
+
+    sl_cpu_set_level(SL_CPU_SCALAR);
+    sl_query_init(&scalar, arena, fixture->type);
+    sl_query_decode(&scalar, &source);
+
+    sl_cpu_set_level(level);
+    sl_query_init(&vector, arena, fixture->type);
+    sl_query_decode(&vector, &source);
+
+    if (scalar.count != vector.count) {
+        fprintf(stderr, "%s: pair count mismatch for %s\n", fixture->name, sl_bench_query_levels[level]);
+        exit(EXIT_FAILURE);
+    }
+
+    for (size_t n = 0; n < scalar.count; n ++) {
+        if (scalar.pairs[n].key.length != vector.pairs[n].key.length || scalar.pairs[n].value.length != vector.pairs[n].value.length ||
+            memcmp(scalar.pairs[n].key.buffer, vector.pairs[n].key.buffer, scalar.pairs[n].key.length) != 0 ||
+            memcmp(scalar.pairs[n].value.buffer, vector.pairs[n].value.buffer, scalar.pairs[n].value.length) != 0) {
+            fprintf(stderr, "%s: pair %zu mismatch for %s\n", fixture->name, n, sl_bench_query_levels[level]);
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+int main(void)
+{
+    sl_arena arena;
+    char name[64];
+
+    sl_arena_init(&arena, SL_BENCH_QUERY_ARENA_PREALLOCATE);
+
+    memcpy(sl_bench_query_long, "payload=", 8);
+    for (size_t n = 8; n < sizeof(sl_bench_query_long) - 16; n ++) {
+        sl_bench_query_long[n] = 'a' + (n % 26);
+    }
+    memcpy(sl_bench_query_long + sizeof(sl_bench_query_long) - 16, "&tail=%41%42%43", 16);
+
+    sl_cpu_level detected = sl_cpu_detect();
+    size_t fixtures = sizeof(sl_bench_query_fixtures) / sizeof(sl_bench_query_fixture);
+
+    for (size_t f = 0; f < fixtures; f ++) {
+        sl_bench_query_fixture *fixture = &sl_bench_query_fixtures[f];
+        size_t length = strlen(fixture->source);
+
+        for (sl_cpu_level level = SL_CPU_SCALAR; level <= detected; level ++) {
+            sl_bench_query_verify(&arena, fixture, level);
+
+            sl_cpu_set_level(level);
+            sl_bench_query_run(&arena, fixture, SL_BENCH_QUERY_ITERATIONS / 10);
+
+            uint64_t start = sl_bench_now();
+            sl_bench_query_run(&arena, fixture, SL_BENCH_QUERY_ITERATIONS);
+            uint64_t elapsed = sl_bench_now() - start;
+
+            snprintf(name, sizeof(name), "query/%s/%s", fixture->name, sl_bench_query_levels[level]);
+            sl_bench_report(name, SL_BENCH_QUERY_ITERATIONS, length, elapsed);
+        }
+    }
+
+    sl_arena_destroy(&arena);
+
+    return EXIT_SUCCESS;
+}
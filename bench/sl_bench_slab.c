@@ -0,0 +1,155 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "sl_bench.h"
+#include "../sl_arena.h"
+#include "../sl_slab.h"
+#include "../sl_fcgi.h"
+
+#define SL_BENCH_SLAB_ROUNDS 100000
+#define SL_BENCH_SLAB_BATCH  64
+#define SL_BENCH_SLAB_LIVE   1024
+#define SL_BENCH_SLAB_CHURN  10000000
+
+static void *sl_bench_slab_objects[SL_BENCH_SLAB_LIVE];
+
+static void sl_bench_slab_touch(void *object, size_t size)
+{
+    memset(object, 0, size);
+}
+
+static void sl_bench_slab_batch_slab(size_t size)
+{
+    sl_slab slab;
+
+    sl_slab_init(&slab, size, 256);
+
+    uint64_t start = sl_bench_now();
+
+    for (size_t r = 0; r < SL_BENCH_SLAB_ROUNDS; r ++) {
+        for (size_t n = 0; n < SL_BENCH_SLAB_BATCH; n ++) {
+            sl_bench_slab_objects[n] = sl_slab_allocate(&slab);
+            sl_bench_slab_touch(sl_bench_slab_objects[n], size);
+        }
+
+        for (size_t n = 0; n < SL_BENCH_SLAB_BATCH; n ++) {
+            sl_slab_free(&slab, sl_bench_slab_objects[n]);
+        }
+    }
+
+    sl_bench_report("slab/batch/slab", SL_BENCH_SLAB_ROUNDS * SL_BENCH_SLAB_BATCH, 0, sl_bench_now() - start);
+    sl_slab_destroy(&slab);
+}
+
+static void sl_bench_slab_batch_arena(size_t size)
+{
+    sl_arena arena;
+
+    sl_arena_init(&arena, 102400);
+
+    uint64_t start = sl_bench_now();
+
+    for (size_t r = 0; r < SL_BENCH_SLAB_ROUNDS; r ++) {
+        for (size_t n = 0; n < SL_BENCH_SLAB_BATCH; n ++) {
+            sl_bench_slab_objects[n] = sl_arena_allocate(&arena, size);
+            sl_bench_slab_touch(sl_bench_slab_objects[n], size);
+        }
+
+        sl_arena_rewind(&arena);
+    }
+
+    sl_bench_report("slab/batch/arena", SL_BENCH_SLAB_ROUNDS * SL_BENCH_SLAB_BATCH, 0, sl_bench_now() - start);
+    sl_arena_destroy(&arena);
+}
+
+static void sl_bench_slab_batch_malloc(size_t size)
+{
+    uint64_t start = sl_bench_now();
+
+    for (size_t r = 0; r < SL_BENCH_SLAB_ROUNDS; r ++) {
+        for (size_t n = 0; n < SL_BENCH_SLAB_BATCH; n ++) {
+            sl_bench_slab_objects[n] = malloc(size);
+            sl_bench_slab_touch(sl_bench_slab_objects[n], size);
+        }
+
+        for (size_t n = 0; n < SL_BENCH_SLAB_BATCH; n ++) {
+            free(sl_bench_slab_objects[n]);
+        }
+    }
+
+    sl_bench_report("slab/batch/malloc", SL_BENCH_SLAB_ROUNDS * SL_BENCH_SLAB_BATCH, 0, sl_bench_now() - start);
+}
+
+static void sl_bench_slab_churn_slab(size_t size)
+{
+    sl_slab slab;
+    uint32_t random = 2463534242;
+
+    sl_slab_init(&slab, size, 256);
+
+    for (size_t n = 0; n < SL_BENCH_SLAB_LIVE; n ++) {
+        sl_bench_slab_objects[n] = sl_slab_allocate(&slab);
+    }
+
+    uint64_t start = sl_bench_now();
+
+    for (size_t n = 0; n < SL_BENCH_SLAB_CHURN; n ++) {
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+
+        size_t index = random % SL_BENCH_SLAB_LIVE;
+
+        sl_slab_free(&slab, sl_bench_slab_objects[index]);
+        sl_bench_slab_objects[index] = sl_slab_allocate(&slab);
+        sl_bench_slab_touch(sl_bench_slab_objects[index], size);
+    }
+
+    sl_bench_report("slab/churn/slab", SL_BENCH_SLAB_CHURN, 0, sl_bench_now() - start);
+    sl_slab_destroy(&slab);
+}
+
+static void sl_bench_slab_churn_malloc(size_t size)
+{
+    uint32_t random = 2463534242;
+
+    for (size_t n = 0; n < SL_BENCH_SLAB_LIVE; n ++) {
+        sl_bench_slab_objects[n] = malloc(size);
+    }
+
+    uint64_t start = sl_bench_now();
+
+    for (size_t n = 0; n < SL_BENCH_SLAB_CHURN; n ++) {
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+
+        size_t index = random % SL_BENCH_SLAB_LIVE;
+
+        free(sl_bench_slab_objects[index]);
+        sl_bench_slab_objects[index] = malloc(size);
+        sl_bench_slab_touch(sl_bench_slab_objects[index], size);
+    }
+
+    sl_bench_report("slab/churn/malloc", SL_BENCH_SLAB_CHURN, 0, sl_bench_now() - start);
+
+    for (size_t n = 0; n < SL_BENCH_SLAB_LIVE; n ++) {
+        free(sl_bench_slab_objects[n]);
+    }
+}
+
+int main(void)
+{
+    size_t size = sizeof(sl_fcgi_msg_param);
+
+    printf("object size: %zu bytes\n", size);
+
+    sl_bench_slab_batch_slab(size);
+    sl_bench_slab_batch_arena(size);
+    sl_bench_slab_batch_malloc(size);
+    sl_bench_slab_churn_slab(size);
+    sl_bench_slab_churn_malloc(size);
+
+    return EXIT_SUCCESS;
+}
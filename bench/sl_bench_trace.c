@@ -0,0 +1,116 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "sl_bench.h"
+#include "../sl_trace.h"
+
+#define SL_BENCH_TRACE_ITERATIONS 10000000
+#define SL_BENCH_TRACE_SAMPLES      100000
+
+static volatile uint64_t sl_bench_trace_sink;
+static uint64_t sl_bench_trace_values[SL_BENCH_TRACE_SAMPLES];
+
+static uint64_t sl_bench_trace_now(size_t iterations)
+{
+    uint64_t start = sl_bench_now();
+
+    for (size_t n = 0; n < iterations; n ++) {
+        sl_bench_trace_sink += sl_trace_now();
+    }
+
+    return sl_bench_now() - start;
+}
+
+static uint64_t sl_bench_trace_span(sl_trace *trace, size_t iterations)
+{
+    sl_trace_span span = {0};
+
+    uint64_t start = sl_bench_now();
+
+    for (size_t n = 0; n < iterations; n ++) {
+        uint64_t phase_start = sl_trace_now();
+
+        sl_trace_span_begin(trace, &span, phase_start);
+        sl_trace_span_record(&span, SL_TRACE_PHASE_PARSE, phase_start);
+    }
+
+    sl_bench_trace_sink += span.durations[SL_TRACE_PHASE_PARSE];
+
+    return sl_bench_now() - start;
+}
+
+static uint64_t sl_bench_trace_histogram(sl_trace_histogram *histogram, size_t iterations)
+{
+    uint64_t state = 0x9e3779b97f4a7c15;
+
+    uint64_t start = sl_bench_now();
+
+    for (size_t n = 0; n < iterations; n ++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+
+        sl_trace_histogram_record(histogram, state & 0xfffff);
+    }
+
+    return sl_bench_now() - start;
+}
+
+static int sl_bench_trace_compare(const void *a, const void *b)
+{
+    uint64_t left = *(const uint64_t *) a, right = *(const uint64_t *) b;
+
+    return left < right ? -1 : left > right;
+}
+
+static void sl_bench_trace_verify(void)
+{
+    static sl_trace_histogram histogram;
+    double percentiles[] = {50.0, 90.0, 99.0, 99.9};
+    uint64_t state = 0x2545f4914f6cdd1d;
+
+    for (size_t n = 0; n < SL_BENCH_TRACE_SAMPLES; n ++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+
+        sl_bench_trace_values[n] = (state & 0xffff) * (1 + (state >> 60));
+        sl_trace_histogram_record(&histogram, sl_bench_trace_values[n]);
+    }
+
+    qsort(sl_bench_trace_values, SL_BENCH_TRACE_SAMPLES, sizeof(uint64_t), sl_bench_trace_compare);
+
+    for (size_t n = 0; n < sizeof(percentiles) / sizeof(double); n ++) {
+        uint64_t exact = sl_bench_trace_values[(size_t) (percentiles[n] / 100.0 * SL_BENCH_TRACE_SAMPLES + 0.5) - 1];
+        uint64_t estimated = sl_trace_histogram_percentile(&histogram, percentiles[n]);
+        double error = exact > 0 ? 100.0 * ((double) estimated - exact) / exact : 0.0;
+
+        printf("%-40s p%-5.1f exact %10lu estimated %10lu error %+6.2f%%\n", "trace/histogram/accuracy", percentiles[n], exact, estimated, error);
+
+        if (error < 0.0 || error > 100.0 / SL_TRACE_SUB_BUCKETS) {
+            fprintf(stderr, "percentile estimate out of bounds\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+int main(void)
+{
+    static sl_trace trace;
+    static sl_trace_histogram histogram;
+
+    sl_trace_init(&trace, 0);
+    sl_trace_calibrate();
+
+    printf("%-40s %s\n", "trace/clock", sl_trace_get_clock() == SL_TRACE_CLOCK_TSC ? "tsc" : "monotonic_raw");
+
+    sl_bench_trace_now(SL_BENCH_TRACE_ITERATIONS / 10);
+    sl_bench_report("trace/now", SL_BENCH_TRACE_ITERATIONS, 0, sl_bench_trace_now(SL_BENCH_TRACE_ITERATIONS));
+    sl_bench_report("trace/span_record", SL_BENCH_TRACE_ITERATIONS, 0, sl_bench_trace_span(&trace, SL_BENCH_TRACE_ITERATIONS));
+    sl_bench_report("trace/histogram_record", SL_BENCH_TRACE_ITERATIONS, 0, sl_bench_trace_histogram(&histogram, SL_BENCH_TRACE_ITERATIONS));
+
+    sl_bench_trace_verify();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,366 @@
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <inttypes.h>
+
+#include "sl_bench.h"
+#include "../sl_cpu.h"
+#include "../sl_view.h"
+
+#define SL_BENCH_VIEW_BYTES       (256 * 1024 * 1024)
+#define SL_BENCH_VIEW_MAX_SIZE    4096
+#define SL_BENCH_VIEW_VERIFY_SIZE 160
+#define SL_BENCH_VIEW_ITERATIONS  10000000
+
+typedef struct sl_bench_view_operation sl_bench_view_operation;
+
+struct sl_bench_view_operation {
+    char *name;
+    char *libc;
+    size_t (*run)(size_t length, size_t iterations);
+    size_t (*run_libc)(size_t length, size_t iterations);
+};
+
+static char *sl_bench_view_levels[SL_CPU_MAX] = {
+    "scalar", "sse2", "avx2"
+};
+
+static size_t sl_bench_view_sizes[] = {8, 32, 256, SL_BENCH_VIEW_MAX_SIZE};
+
+static char *sl_bench_view_numbers[] = {"7", "8080", "12345678", "1700000000123", "18446744073709551615"};
+
+static char sl_bench_view_text[SL_BENCH_VIEW_MAX_SIZE + 1];
+static char sl_bench_view_copy[SL_BENCH_VIEW_MAX_SIZE + 1];
+static char sl_bench_view_upper[SL_BENCH_VIEW_MAX_SIZE + 1];
+static char sl_bench_view_needle[] = "\r\n\r\n";
+
+static volatile size_t sl_bench_view_sink;
+
+static size_t sl_bench_view_equal(size_t length, size_t iterations)
+{
+    sl_string a = sl_string_init_with_buffer(sl_bench_view_text, length);
+    sl_string b = sl_string_init_with_buffer(sl_bench_view_copy, length);
+    size_t result = 0;
+
+    for (size_t n = 0; n < iterations; n ++) {
+        result += sl_view_equal(&a, &b);
+        __asm__ volatile("" ::: "memory");
+    }
+
+    return result;
+}
+
+static size_t sl_bench_view_equal_libc(size_t length, size_t iterations)
+{
+    size_t result = 0;
+
+    for (size_t n = 0; n < iterations; n ++) {
+        result += memcmp(sl_bench_view_text, sl_bench_view_copy, length) == 0;
+        __asm__ volatile("" ::: "memory");
+    }
+
+    return result;
+}
+
+static size_t sl_bench_view_equal_case(size_t length, size_t iterations)
+{
+    sl_string a = sl_string_init_with_buffer(sl_bench_view_text, length);
+    sl_string b = sl_string_init_with_buffer(sl_bench_view_upper, length);
+    size_t result = 0;
+
+    for (size_t n = 0; n < iterations; n ++) {
+        result += sl_view_equal_case(&a, &b);
+        __asm__ volatile("" ::: "memory");
+    }
+
+    return result;
+}
+
+static size_t sl_bench_view_equal_case_libc(size_t length, size_t iterations)
+{
+    size_t result = 0;
+
+    for (size_t n = 0; n < iterations; n ++) {
+        result += strncasecmp(sl_bench_view_text, sl_bench_view_upper, length) == 0;
+        __asm__ volatile("" ::: "memory");
+    }
+
+    return result;
+}
+
+static size_t sl_bench_view_find_byte(size_t length, size_t iterations)
+{
+    sl_string a = sl_string_init_with_buffer(sl_bench_view_text, length);
+    size_t result = 0;
+
+    for (size_t n = 0; n < iterations; n ++) {
+        result += sl_view_find_byte(&a, '\n');
+        __asm__ volatile("" ::: "memory");
+    }
+
+    return result;
+}
+
+static size_t sl_bench_view_find_byte_libc(size_t length, size_t iterations)
+{
+    size_t result = 0;
+
+    for (size_t n = 0; n < iterations; n ++) {
+        char *found = memchr(sl_bench_view_text, '\n', length);
+
+        result += found == NULL ? SL_VIEW_NOT_FOUND : (size_t) (found - sl_bench_view_text);
+        __asm__ volatile("" ::: "memory");
+    }
+
+    return result;
+}
+
+static size_t sl_bench_view_find(size_t length, size_t iterations)
+{
+    sl_string a = sl_string_init_with_buffer(sl_bench_view_text, length);
+    sl_string needle = sl_string_init_with_cstring(sl_bench_view_needle);
+    size_t result = 0;
+
+    for (size_t n = 0; n < iterations; n ++) {
+        result += sl_view_find(&a, &needle);
+        __asm__ volatile("" ::: "memory");
+    }
+
+    return result;
+}
+
+static size_t sl_bench_view_find_libc(size_t length, size_t iterations)
+{
+    size_t result = 0;
+
+    for (size_t n = 0; n < iterations; n ++) {
+        char *found = memmem(sl_bench_view_text, length, sl_bench_view_needle, sizeof(sl_bench_view_needle) - 1);
+
+        result += found == NULL ? SL_VIEW_NOT_FOUND : (size_t) (found - sl_bench_view_text);
+        __asm__ volatile("" ::: "memory");
+    }
+
+    return result;
+}
+
+static sl_bench_view_operation sl_bench_view_operations[] = {
+    { "equal", "memcmp", sl_bench_view_equal, sl_bench_view_equal_libc },
+    { "equal_case", "strncasecmp", sl_bench_view_equal_case, sl_bench_view_equal_case_libc },
+    { "find_byte", "memchr", sl_bench_view_find_byte, sl_bench_view_find_byte_libc },
+    { "find", "memmem", sl_bench_view_find, sl_bench_view_find_libc }
+};
+
+static void sl_bench_view_fill(size_t length)
+{
+    static char *line = "X-Forwarded-For: 203.0.113.7\r\nAccept-Language: en-GB,en;q=0.8\r\n";
+    size_t line_length = strlen(line);
+
+    for (size_t n = 0; n < length; n ++) {
+        sl_bench_view_text[n] = line[n % line_length];
+    }
+
+    for (size_t n = 0; n < length; n ++) {
+        if (sl_bench_view_text[n] == '\n') {
+            sl_bench_view_text[n] = ' ';
+        }
+    }
+
+    memcpy(sl_bench_view_text + length - 4, sl_bench_view_needle, 4);
+
+    for (size_t n = 0; n < length; n ++) {
+        char c = sl_bench_view_text[n];
+
+        sl_bench_view_copy[n] = c;
+        sl_bench_view_upper[n] = c >= 'a' && c <= 'z' ? c - 32 : c;
+    }
+}
+
+static void sl_bench_view_fail(char *operation, sl_cpu_level level, size_t length, size_t position)
+{
+    fprintf(stderr, "%s: %s mismatch at length %zu, position %zu\n", operation, sl_bench_view_levels[level], length, position);
+    exit(EXIT_FAILURE);
+}
+
+static void sl_bench_view_verify(sl_cpu_level level)
+{
+    char a[SL_BENCH_VIEW_VERIFY_SIZE], b[SL_BENCH_VIEW_VERIFY_SIZE], c[SL_BENCH_VIEW_VERIFY_SIZE];
+
+    sl_cpu_set_level(level);
+
+    for (size_t length = 0; length < SL_BENCH_VIEW_VERIFY_SIZE; length ++) {
+        for (size_t n = 0; n < length; n ++) {
+            a[n] = (char) (0x20 + n * 7 % 0xe0);
+            b[n] = (a[n] >= 'a' && a[n] <= 'z') || (a[n] >= 'A' && a[n] <= 'Z') ? a[n] ^ 0x20 : a[n];
+            c[n] = a[n];
+        }
+
+        sl_string view_a = sl_string_init_with_buffer(a, length);
+        sl_string view_b = sl_string_init_with_buffer(b, length);
+        sl_string view_c = sl_string_init_with_buffer(c, length);
+
+        for (size_t position = 0; position <= length; position ++) {
+            char saved = position < length ? a[position] : 0;
+
+            if (position < length) {
+                a[position] = '\n';
+            }
+
+            bool equal = memcmp(a, c, length) == 0;
+            bool equal_case = strncasecmp(a, b, length) == 0;
+            char *byte = memchr(a, '\n', length);
+            char *found = length >= 2 ? memmem(a, length, a + length / 3, 2) : NULL;
+            sl_string needle = sl_string_init_with_buffer(a + length / 3, 2);
+
+            if (sl_view_equal(&view_a, &view_c) != equal) {
+                sl_bench_view_fail("equal", level, length, position);
+            }
+
+            if (sl_view_equal_case(&view_a, &view_b) != equal_case) {
+                sl_bench_view_fail("equal_case", level, length, position);
+            }
+
+            if (sl_view_find_byte(&view_a, '\n') != (byte == NULL ? SL_VIEW_NOT_FOUND : (size_t) (byte - a))) {
+                sl_bench_view_fail("find_byte", level, length, position);
+            }
+
+            if (length >= 2 && sl_view_find(&view_a, &needle) != (found == NULL ? SL_VIEW_NOT_FOUND : (size_t) (found - a))) {
+                sl_bench_view_fail("find", level, length, position);
+            }
+
+            if (position < length) {
+                a[position] = saved;
+            }
+        }
+    }
+}
+
+static void sl_bench_view_verify_parse(void)
+{
+    static char *invalid[] = {"", "-", "+", "12a", "18446744073709551616", "99999999999999999999", "1 2"};
+
+    for (size_t n = 0; n < sizeof(sl_bench_view_numbers) / sizeof(char *); n ++) {
+        sl_string number = sl_string_init_with_cstring(sl_bench_view_numbers[n]);
+        uint64_t value;
+
+        if (sl_view_parse_unsigned(&number, &value) == -1 || value != strtoull(sl_bench_view_numbers[n], NULL, 10)) {
+            fprintf(stderr, "parse: mismatch for %s\n", sl_bench_view_numbers[n]);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    for (size_t n = 0; n < sizeof(invalid) / sizeof(char *); n ++) {
+        sl_string number = sl_string_init_with_cstring(invalid[n]);
+        uint64_t value;
+
+        if (sl_view_parse_unsigned(&number, &value) == 0) {
+            fprintf(stderr, "parse: accepted %s\n", invalid[n]);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    sl_string minimum = sl_string_init_with_cstring("-9223372036854775808");
+    sl_string overflow = sl_string_init_with_cstring("9223372036854775808");
+    int64_t value;
+
+    if (sl_view_parse_signed(&minimum, &value) == -1 || value != INT64_MIN || sl_view_parse_signed(&overflow, &value) == 0) {
+        fprintf(stderr, "parse: signed range check failed\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+static void sl_bench_view_parse(char *source)
+{
+    sl_string number = sl_string_init_with_cstring(source);
+    size_t length = strlen(source);
+    char name[64];
+    uint64_t value;
+
+    uint64_t start = sl_bench_now();
+
+    for (size_t n = 0; n < SL_BENCH_VIEW_ITERATIONS; n ++) {
+        sl_view_parse_unsigned(&number, &value);
+        sl_bench_view_sink += value;
+        __asm__ volatile("" ::: "memory");
+    }
+
+    snprintf(name, sizeof(name), "view/parse/%zu/sl_view", length);
+    sl_bench_report(name, SL_BENCH_VIEW_ITERATIONS, length, sl_bench_now() - start);
+
+    start = sl_bench_now();
+
+    for (size_t n = 0; n < SL_BENCH_VIEW_ITERATIONS; n ++) {
+        sl_bench_view_sink += strtoull(source, NULL, 10);
+        __asm__ volatile("" ::: "memory");
+    }
+
+    snprintf(name, sizeof(name), "view/parse/%zu/strtoull", length);
+    sl_bench_report(name, SL_BENCH_VIEW_ITERATIONS, length, sl_bench_now() - start);
+}
+
+int main(void)
+{
+    char name[64];
+
+    sl_cpu_level detected = sl_cpu_detect();
+
+    for (sl_cpu_level level = SL_CPU_SCALAR; level <= detected; level ++) {
+        sl_bench_view_verify(level);
+    }
+
+    sl_bench_view_verify_parse();
+
+    size_t operations = sizeof(sl_bench_view_operations) / sizeof(sl_bench_view_operation);
+    size_t sizes = sizeof(sl_bench_view_sizes) / sizeof(size_t);
+
+    for (size_t o = 0; o < operations; o ++) {
+        sl_bench_view_operation *operation = &sl_bench_view_operations[o];
+
+        for (size_t s = 0; s < sizes; s ++) {
+            size_t length = sl_bench_view_sizes[s];
+            size_t iterations = SL_BENCH_VIEW_BYTES / length;
+
+            if (iterations > SL_BENCH_VIEW_ITERATIONS) {
+                iterations = SL_BENCH_VIEW_ITERATIONS;
+            }
+
+            sl_bench_view_fill(length);
+
+            size_t expected = operation->run_libc(length, 1);
+
+            for (sl_cpu_level level = SL_CPU_SCALAR; level <= detected; level ++) {
+                sl_cpu_set_level(level);
+
+                if (operation->run(length, 1) != expected) {
+                    sl_bench_view_fail(operation->name, level, length, 0);
+                }
+
+                operation->run(length, iterations / 10);
+
+                uint64_t start = sl_bench_now();
+                sl_bench_view_sink += operation->run(length, iterations);
+                uint64_t elapsed = sl_bench_now() - start;
+
+                snprintf(name, sizeof(name), "view/%s/%zu/%s", operation->name, length, sl_bench_view_levels[level]);
+                sl_bench_report(name, iterations, length, elapsed);
+            }
+
+            uint64_t start = sl_bench_now();
+            sl_bench_view_sink += operation->run_libc(length, iterations);
+            uint64_t elapsed = sl_bench_now() - start;
+
+            snprintf(name, sizeof(name), "view/%s/%zu/%s", operation->name, length, operation->libc);
+            sl_bench_report(name, iterations, length, elapsed);
+        }
+    }
+
+    sl_cpu_set_level(detected);
+
+    for (size_t n = 0; n < sizeof(sl_bench_view_numbers) / sizeof(char *); n ++) {
+        sl_bench_view_parse(sl_bench_view_numbers[n]);
+    }
+
+    return EXIT_SUCCESS;
+}
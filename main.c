@@ -1,13 +1,20 @@
+#define _GNU_SOURCE
+
 #include <stdlib.h>
 #include <stdio.h>
+#include <limits.h>
+#include <sched.h>
 #include <stdbool.h>
 #include <unistd.h>
 #include <string.h>
 #include <signal.h>
 #include <errno.h>
+#include <time.h>
+#include <poll.h>
 #include <sys/uio.h>
 #include <sys/epoll.h>
 #include <sys/wait.h>
+#include <sys/syscall.h>
 
 #include <sys/socket.h>
 #include <netinet/in.h>
@@ -17,15 +24,30 @@
 #include "sl_log.h"
 #include "sl_net.h"
 #include "sl_fcgi.h"
+#include "sl_hashtable.h"
+#include "sl_slab.h"
+#include "sl_cache.h"
+#include "sl_compress.h"
+#include "sl_trace.h"
+#include "sl_metrics.h"
+#include "sl_capture.h"
+#include "sl_probe.h"
 
 #define SL_NET_LISTEN_BACKLOG   1024
 #define SL_NET_RECV_BUFFER_SIZE 10240
 #define SL_NET_IP_ADDRESS_SIZE  16
 
 #define SL_MAIN_ARENA_PREALLOCATE 102400
+#define SL_MAIN_ARENA_POOL_BLOCKS 64
+#define SL_MAIN_ARENA_MAPPED_BLOCKS 32
 #define SL_MAIN_PARAMS_PREALLOCATE 64
 #define SL_MAIN_HEADERS_PREALLOCATE 16
 
+#define SL_MAIN_REQUEST_BUDGET (1024 * 1024)
+#define SL_MAIN_WORKER_BUDGET  (64 * 1024 * 1024)
+#define SL_MAIN_CAPTURE_LIMIT  (1024 * 1024 * 1024)
+#define SL_MAIN_SEND_TIMEOUT   1000
+
 #define SL_MAIN_MASTER_PROCESS_NAME "cpptrw: master process"
 #define SL_MAIN_WORKER_PROCESS_NAME "cpptrw: worker process"
 
@@ -33,12 +55,93 @@
 #define SL_MAIN_MAX_EVENTS       256
 #define SL_MAIN_MAX_PROCESSES      2
 
+#define SL_MAIN_CONNECTION_SLAB_OBJECTS 64
+#define SL_MAIN_PARAM_SLAB_OBJECTS     256
+
 static volatile bool sl_main_running = true;
 
-int sl_main_request_send_response(sl_fcgi_request *request, int connection_socket, void *buffer, uint16_t length)
+static size_t sl_main_request_budget = SL_MAIN_REQUEST_BUDGET;
+static size_t sl_main_worker_budget = SL_MAIN_WORKER_BUDGET;
+static bool sl_main_pin_workers = false;
+static int sl_main_compress_level = SL_COMPRESS_DEFAULT_LEVEL;
+static size_t sl_main_compress_min_size = SL_COMPRESS_DEFAULT_MIN_SIZE;
+
+static sl_cache sl_main_cache;
+static sl_compress sl_main_compress;
+static sl_string *sl_main_content_type_header;
+static size_t sl_main_log_ring_size = SL_LOG_RING_DEFAULT_SIZE;
+static sl_log_overflow sl_main_log_overflow = SL_LOG_OVERFLOW_BLOCK;
+static sl_log_mode sl_main_log_mode = SL_LOG_MODE_TEXT;
+static sl_log_level sl_main_log_level = SL_LOG_ERROR;
+static size_t sl_main_trace_sample_rate = 0;
+static sl_trace sl_main_trace;
+static size_t sl_main_metrics_route = SL_TRACE_ROUTE_OTHER;
+static sl_string *sl_main_metrics_content_type_header;
+static sl_metrics *sl_main_metrics;
+static sl_metrics_worker *sl_main_metrics_worker;
+static char *sl_main_capture_path = NULL;
+static size_t sl_main_capture_sample_rate = 1;
+static size_t sl_main_capture_limit = SL_MAIN_CAPTURE_LIMIT;
+static sl_capture sl_main_capture;
+
+int sl_main_request_send_iovecs(sl_fcgi_request *request, int connection_socket, struct iovec *buffers, size_t count)
 {
     ssize_t bytes_sent;
+    size_t total_sent = 0;
+    uint64_t start = sl_trace_now();
+
+    while (count > 0) {
+        bytes_sent = writev(connection_socket, buffers, count < IOV_MAX ? count : IOV_MAX);
+        if (bytes_sent == -1 && errno == EINTR) {
+            continue;
+        } else if (bytes_sent == -1 && errno == EAGAIN) {
+            struct pollfd writable = { .fd = connection_socket, .events = POLLOUT };
+
+            int ready = poll(&writable, 1, SL_MAIN_SEND_TIMEOUT);
+            if (ready == 1 || (ready == -1 && errno == EINTR)) {
+                continue;
+            }
+
+            if (ready == 0) {
+                SL_LOG_WRITE_LIMITED(request->log, SL_LOG_ERROR, "Timed out sending response");
+            } else {
+                SL_LOG_WRITE_LIMITED(request->log, SL_LOG_ERROR, "poll()");
+            }
+        } else if (bytes_sent == -1) {
+            SL_LOG_WRITE_LIMITED(request->log, SL_LOG_ERROR, "writev()");
+        }
+
+        if (bytes_sent == -1) {
+            sl_trace_span_record(&request->trace, SL_TRACE_PHASE_SEND, start);
+            sl_metrics_add(sl_main_metrics_worker, SL_METRICS_BYTES_SENT, total_sent);
+            return -1;
+        }
+
+        total_sent += bytes_sent;
+        request->bytes_sent += bytes_sent;
+
+        while (count > 0 && (size_t) bytes_sent >= buffers->iov_len) {
+            bytes_sent -= buffers->iov_len;
+            buffers ++;
+            count --;
+        }
 
+        if (count > 0) {
+            buffers->iov_base = (uint8_t *) buffers->iov_base + bytes_sent;
+            buffers->iov_len -= bytes_sent;
+        }
+    }
+
+    sl_trace_span_record(&request->trace, SL_TRACE_PHASE_SEND, start);
+    sl_metrics_add(sl_main_metrics_worker, SL_METRICS_BYTES_SENT, total_sent);
+
+    SL_LOG_WRITE_FORMAT(request->log, SL_LOG_INFO, "Sent %z bytes response", total_sent);
+
+    return 0;
+}
+
+int sl_main_request_send_response(sl_fcgi_request *request, int connection_socket, void *buffer, uint16_t length, uint8_t protocol_status)
+{
     sl_fcgi_msg_header stdout_header = {
         .version = SL_FCGI_VERSION,
         .type = SL_FCGI_TYPE_STDOUT,
@@ -66,7 +169,10 @@ int sl_main_request_send_response(sl_fcgi_request *request, int connection_socke
         .reserved = 0
     };
 
-    sl_fcgi_msg_end end_message = {0};
+    sl_fcgi_msg_end end_message = {
+        .app_status = 0,
+        .protocol_status = protocol_status
+    };
 
     struct iovec buffers[5] = {
         { .iov_base = &stdout_header,       .iov_len = sizeof(sl_fcgi_msg_header) },
@@ -76,28 +182,75 @@ int sl_main_request_send_response(sl_fcgi_request *request, int connection_socke
         { .iov_base = &end_message,         .iov_len = sizeof(sl_fcgi_msg_end)}
     };
 
-    bytes_sent = writev(connection_socket, buffers, sizeof(buffers) / sizeof(struct iovec));
-    if (bytes_sent == -1) {
-        sl_log_write(request->log, SL_LOG_ERROR, "writev()");
+    return sl_main_request_send_iovecs(request, connection_socket, buffers, sizeof(buffers) / sizeof(struct iovec));
+}
+
+int sl_main_request_send_cached(sl_fcgi_request *request, int connection_socket, sl_cache_response *cached)
+{
+    struct iovec buffers[SL_CACHE_RESPONSE_IOVECS];
+
+    size_t count = sl_cache_prepare_response(&sl_main_cache, cached, request->request_id, buffers);
+
+    return sl_main_request_send_iovecs(request, connection_socket, buffers, count);
+}
+
+int sl_main_request_send_metrics(sl_fcgi_request *request, int connection_socket, sl_compress_encoding encoding)
+{
+    sl_fcgi_response response;
+
+    sl_fcgi_response_init(&response, request->arena, request->log, SL_MAIN_HEADERS_PREALLOCATE);
+
+    if (sl_fcgi_response_append_header_line(&response, &sl_main_cache.date) == -1 ||
+        sl_fcgi_response_append_header_line(&response, sl_main_metrics_content_type_header) == -1) {
+        return -1;
+    }
+
+    if (sl_metrics_render(sl_main_metrics, &response.output) == -1) {
         return -1;
     }
 
-    sl_log_write_format(request->arena, request->log, SL_LOG_INFO, "Sent %z bytes response", bytes_sent);
+    if (sl_compress_response(&sl_main_compress, &response, encoding) == -1) {
+        return -1;
+    }
 
-    return 0;
+    if (sl_fcgi_response_serialize(&response, request->request_id, SL_FCGI_PROTOCOL_STATUS_REQUEST_COMPLETE) == -1) {
+        return -1;
+    }
+
+    int result = sl_main_request_send_iovecs(request, connection_socket, response.iovecs, response.iovec_count);
+
+    sl_fcgi_response_release(&response);
+
+    return result;
 }
 
 int sl_main_request_execute(sl_fcgi_request *request, int connection_socket)
 {
     sl_fcgi_response response;
 
+    sl_string document_uri_name = sl_string_init_with_cstring("DOCUMENT_URI");
+    sl_string *document_uri = sl_hashtable_get(&request->parameters, &document_uri_name);
+
+    request->trace.route = sl_trace_find_route(&sl_main_trace, document_uri);
+
+    sl_string accept_encoding_name = sl_string_init_with_cstring("HTTP_ACCEPT_ENCODING");
+    sl_compress_encoding encoding = sl_compress_negotiate(sl_hashtable_get(&request->parameters, &accept_encoding_name));
+
+    if (request->trace.route != SL_TRACE_ROUTE_OTHER && request->trace.route == sl_main_metrics_route) {
+        return sl_main_request_send_metrics(request, connection_socket, encoding);
+    }
+
+    sl_cache_response *cached = document_uri != NULL ? sl_cache_get_response(&sl_main_cache, document_uri, encoding) : NULL;
+    if (cached != NULL) {
+        return sl_main_request_send_cached(request, connection_socket, cached);
+    }
+
     sl_fcgi_response_init(&response, request->arena, request->log, SL_MAIN_HEADERS_PREALLOCATE);
 
-    sl_string header_name = sl_string_init_with_cstring("Content-Type");
-    sl_string value_name = sl_string_init_with_cstring("text/plain");
     sl_string output = sl_string_init_with_cstring("OK\n");
 
-    if (sl_fcgi_response_append_header(&response, &header_name, &value_name) == -1) {
+    if (sl_fcgi_response_append_header_line(&response, &sl_main_cache.date) == -1 ||
+        sl_fcgi_response_append_header_line(&response, sl_main_content_type_header) == -1) {
         return -1;
     }
 
@@ -105,50 +258,164 @@ int sl_main_request_execute(sl_fcgi_request *request, int connection_socket)
         return -1;
     }
 
-    sl_string *raw_response = sl_fcgi_response_process(&response);
-    if (raw_response == NULL) {
+    if (sl_compress_response(&sl_main_compress, &response, encoding) == -1) {
         return -1;
     }
 
-    if (sl_main_request_send_response(request, connection_socket, raw_response->buffer, raw_response->length) == -1) {
+    if (sl_fcgi_response_serialize(&response, request->request_id, SL_FCGI_PROTOCOL_STATUS_REQUEST_COMPLETE) == -1) {
         return -1;
     }
 
+    SL_LOG_WRITE_FORMAT(request->log, SL_LOG_INFO, "Serialized %z bytes response in %z buffers, %z bytes copied", response.length, response.iovec_count, response.copied);
+
+    int result = sl_main_request_send_iovecs(request, connection_socket, response.iovecs, response.iovec_count);
+
+    sl_fcgi_response_release(&response);
+
+    return result;
+}
+
+int sl_main_cache_static_response(sl_arena *arena, sl_log *log, char *document_uri, char *body)
+{
+    sl_string key = sl_string_init_with_cstring(document_uri);
+    sl_string output = sl_string_init_with_cstring(body);
+
+    for (int encoding = SL_COMPRESS_ENCODING_IDENTITY; encoding < SL_COMPRESS_ENCODINGS; encoding ++) {
+        sl_fcgi_response response;
+
+        sl_fcgi_response_init(&response, arena, log, SL_MAIN_HEADERS_PREALLOCATE);
+
+        if (sl_fcgi_response_append_header_line(&response, &sl_main_cache.date) == -1 ||
+            sl_fcgi_response_append_header_line(&response, sl_main_content_type_header) == -1 ||
+            sl_fcgi_response_append_output(&response, &output) == -1) {
+            return -1;
+        }
+
+        int compressed = sl_compress_response(&sl_main_compress, &response, encoding);
+        if (compressed == -1) {
+            return -1;
+        }
+
+        if (encoding != SL_COMPRESS_ENCODING_IDENTITY && compressed == 0) {
+            continue;
+        }
+
+        if (sl_cache_register_response(&sl_main_cache, &key, encoding, &response) == NULL) {
+            return -1;
+        }
+    }
+
     return 0;
 }
 
+int sl_main_init_cache(sl_arena *arena, sl_log *log)
+{
+    sl_compress_init(&sl_main_compress, sl_main_compress_level, sl_main_compress_min_size);
+    sl_cache_init(&sl_main_cache, arena);
+
+    sl_main_content_type_header = sl_cache_create_header(&sl_main_cache, "Content-Type", "text/plain");
+    if (sl_main_content_type_header == NULL) {
+        return -1;
+    }
+
+    sl_main_metrics_content_type_header = sl_cache_create_header(&sl_main_cache, "Content-Type", "text/plain; version=0.0.4");
+    if (sl_main_metrics_content_type_header == NULL) {
+        return -1;
+    }
+
+    return sl_main_cache_static_response(arena, log, "/", "OK\n");
+}
+
+int sl_main_request_reject(sl_fcgi_request *request, int connection_socket)
+{
+    char status[] = "Status: 503 Service Unavailable\r\n\r\n";
+
+    SL_LOG_WRITE_LIMITED(request->log, SL_LOG_ERROR, "FCGI request exceeded its memory budget");
+    sl_metrics_add(sl_main_metrics_worker, SL_METRICS_REQUESTS_REJECTED, 1);
+
+    return sl_main_request_send_response(request, connection_socket, status, sizeof(status) - 1, SL_FCGI_PROTOCOL_STATUS_OVERLOADED);
+}
+
+void sl_main_request_record(sl_fcgi_request *request, bool failed)
+{
+    sl_arena *arena = request->arena;
+
+    if (arena->pool != NULL) {
+        sl_arena_pool_record(arena->pool, arena);
+    }
+
+    sl_metrics_record_latency(sl_main_metrics_worker, sl_trace_span_finish(&sl_main_trace, &request->trace, request->log));
+
+    sl_metrics_add(sl_main_metrics_worker, SL_METRICS_REQUESTS, 1);
+    sl_metrics_add(sl_main_metrics_worker, SL_METRICS_REQUESTS_FAILED, failed);
+    sl_metrics_add(sl_main_metrics_worker, SL_METRICS_ARENA_ALLOCATIONS, arena->allocations);
+    sl_metrics_add(sl_main_metrics_worker, SL_METRICS_ARENA_BYTES_USED, arena->used);
+    sl_metrics_add(sl_main_metrics_worker, SL_METRICS_ARENA_BYTES_ALLOCATED, arena->allocated);
+    sl_metrics_add(sl_main_metrics_worker, SL_METRICS_ARENA_BLOCKS, arena->blocks);
+    sl_metrics_add(sl_main_metrics_worker, SL_METRICS_HASHTABLE_RESIZES, request->parameters.resizes);
+
+    SL_LOG_WRITE_FORMAT(request->log, SL_LOG_INFO, "Request memory: %z allocations, %z bytes used, %z bytes in %z blocks", arena->allocations, arena->used, arena->allocated, arena->blocks);
+}
+
 void sl_main_parse_buffer(sl_fcgi_request *request, sl_fcgi_parser *parser, int connection_socket, uint8_t *buffer, size_t length)
 {
     size_t bytes_parsed = 0, previous = 0;
 
     while (bytes_parsed < length) {
+        uint64_t start = sl_trace_now();
+
         bytes_parsed += sl_fcgi_parser_parse(parser, buffer + bytes_parsed, length - bytes_parsed);
+        sl_trace_span_record(&request->trace, SL_TRACE_PHASE_PARSE, start);
 
-        sl_log_write_format(request->arena, request->log, SL_LOG_INFO, "Parsed %z bytes", bytes_parsed - previous);
+        SL_LOG_WRITE_FORMAT(request->log, SL_LOG_INFO, "Parsed %z bytes", bytes_parsed - previous);
 
         if (parser->state == SL_FCGI_PARSER_STATE_ERROR) {
-            sl_log_write(request->log, SL_LOG_ERROR, "Error parsing FCGI message");
+            SL_LOG_WRITE_LIMITED(request->log, SL_LOG_ERROR, "Error parsing FCGI message");
+            if (request->arena->exceeded == true && request->bytes_sent == 0) {
+                sl_main_request_reject(request, connection_socket);
+            }
+            sl_main_request_record(request, true);
             break;
         }
 
         if (parser->state == SL_FCGI_PARSER_STATE_FINISHED) {
-            sl_log_write(parser->log, SL_LOG_INFO, "Received FCGI message");
+            SL_LOG_WRITE(parser->log, SL_LOG_INFO, "Received FCGI message");
+            start = sl_trace_now();
             sl_fcgi_request_process(request, parser);
+            sl_trace_span_record(&request->trace, SL_TRACE_PHASE_PROCESS, start);
+
             if (request->state == SL_FCGI_REQUEST_STATE_ERROR) {
-                sl_log_write(parser->log, SL_LOG_ERROR, "FCGI request error");
+                SL_LOG_WRITE_LIMITED(parser->log, SL_LOG_ERROR, "FCGI request error");
+                if (request->arena->exceeded == true && request->bytes_sent == 0) {
+                    sl_main_request_reject(request, connection_socket);
+                }
+                sl_main_request_record(request, true);
                 break;
             }
 
             if (request->state == SL_FCGI_REQUEST_STATE_FINISHED) {
-                if (sl_main_request_execute(request, connection_socket) == -1) {
-                    sl_log_write(parser->log, SL_LOG_ERROR, "FCGI request failed to execute");
+                uint64_t sent = request->trace.durations[SL_TRACE_PHASE_SEND];
+
+                start = sl_trace_now();
+                int result = sl_main_request_execute(request, connection_socket);
+
+                sl_trace_span_record(&request->trace, SL_TRACE_PHASE_EXECUTE, start);
+                request->trace.durations[SL_TRACE_PHASE_EXECUTE] -= request->trace.durations[SL_TRACE_PHASE_SEND] - sent;
+
+                if (result == -1) {
+                    SL_LOG_WRITE_LIMITED(parser->log, SL_LOG_ERROR, "FCGI request failed to execute");
+                    if (request->arena->exceeded == true && request->bytes_sent == 0) {
+                        sl_main_request_reject(request, connection_socket);
+                    }
+                    request->state = SL_FCGI_REQUEST_STATE_ERROR;
                 } else {
-                    sl_log_write(parser->log, SL_LOG_INFO, "FCGI request complete");
+                    SL_LOG_WRITE(parser->log, SL_LOG_INFO, "FCGI request complete");
                 }
+                sl_main_request_record(request, result == -1);
                 break;
             }
 
-            sl_fcgi_parser_init(parser, parser->arena, parser->log);
+            sl_fcgi_parser_init(parser, parser->arena, parser->param_slab, parser->log);
         }
 
         previous = bytes_parsed;
@@ -160,8 +427,26 @@ int sl_main_process_connection(sl_net_connection *connection)
     uint8_t recv_buffer[SL_NET_RECV_BUFFER_SIZE];
     ssize_t bytes_read;
 
-    while ((bytes_read = recv(connection->socket_fd, recv_buffer, SL_NET_RECV_BUFFER_SIZE, 0)) > 0) {
-        sl_log_write_format(&connection->arena, &connection->log, SL_LOG_INFO, "Received %z bytes", bytes_read);
+    for (;;) {
+        uint64_t start = sl_trace_now();
+
+        bytes_read = recv(connection->socket_fd, recv_buffer, SL_NET_RECV_BUFFER_SIZE, 0);
+        if (bytes_read > 0) {
+            sl_trace_span_begin(&sl_main_trace, &connection->request.trace, start);
+        }
+
+        sl_trace_span_record(&connection->request.trace, SL_TRACE_PHASE_RECV, start);
+
+        if (bytes_read <= 0) {
+            break;
+        }
+
+        SL_LOG_WRITE_FORMAT(&connection->log, SL_LOG_INFO, "Received %z bytes", bytes_read);
+        sl_metrics_add(sl_main_metrics_worker, SL_METRICS_BYTES_RECEIVED, bytes_read);
+
+        if (connection->capture != 0) {
+            sl_capture_recv(&sl_main_capture, connection->capture, recv_buffer, bytes_read);
+        }
 
         sl_main_parse_buffer(&connection->request, &connection->parser, connection->socket_fd, recv_buffer, bytes_read);
         if (connection->request.state == SL_FCGI_REQUEST_STATE_ERROR || connection->parser.state == SL_FCGI_PARSER_STATE_ERROR) {
@@ -177,20 +462,24 @@ int sl_main_process_connection(sl_net_connection *connection)
         return 0;
     }
 
-    if (connection->request.state == SL_FCGI_REQUEST_STATE_FINISHED ||
-        (connection->request.flags & SL_FCGI_FLAG_KEEP_CONN) == SL_FCGI_FLAG_KEEP_CONN) {
-        sl_log_write(&connection->log, SL_LOG_INFO, "Reusing connection");
+    if (connection->request.state != SL_FCGI_REQUEST_STATE_FINISHED && (bytes_read > 0 || (bytes_read == -1 && errno == EAGAIN))) {
+        return 1;
+    }
 
-        sl_net_init_connection(connection, &connection->log, connection->socket_fd, connection->address, SL_MAIN_ARENA_PREALLOCATE, SL_MAIN_PARAMS_PREALLOCATE);
-        connection->is_busy = true;
+    if (connection->request.state == SL_FCGI_REQUEST_STATE_FINISHED) {
+        SL_LOG_WRITE(&connection->log, SL_LOG_INFO, "Reusing connection");
+        SL_PROBE2(connection__reuse, connection->socket_fd, connection->request.request_id);
+        sl_metrics_add(sl_main_metrics_worker, SL_METRICS_CONNECTIONS_REUSED, 1);
+
+        sl_net_init_connection(connection, &connection->log, connection->socket_fd, connection->address, connection->arena.pool, connection->parser.param_slab, SL_MAIN_ARENA_PREALLOCATE, connection->arena.limit, SL_MAIN_PARAMS_PREALLOCATE);
 
         return 1;
     }
 
     if (bytes_read == -1) {
-        sl_log_write(&connection->log, SL_LOG_ERROR, "recv()");
+        SL_LOG_WRITE_LIMITED(&connection->log, SL_LOG_ERROR, "recv()");
     } else if (bytes_read == 0) {
-        sl_log_write(&connection->log, SL_LOG_INFO, "Remote host closed connection");
+        SL_LOG_WRITE(&connection->log, SL_LOG_INFO, "Remote host closed connection");
     }
 
     return 0;
@@ -243,101 +532,350 @@ void sl_main_set_process_name(int argc, char *argv[], char *env[], char *name)
     memcpy(argv[0], name, length);
 }
 
-void sl_main_event_loop(sl_log *log, int server_socket)
+int sl_main_pin_worker(sl_log *log, int worker)
 {
-    sl_net_connection connections[SL_MAIN_MAX_CONNECTIONS] = {0};
+    cpu_set_t allowed, cpu_set;
+
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) == -1) {
+        SL_LOG_WRITE(log, SL_LOG_ERROR, "sched_getaffinity()");
+        return -1;
+    }
+
+    int processors = CPU_COUNT(&allowed);
+    if (processors == 0) {
+        SL_LOG_WRITE(log, SL_LOG_ERROR, "No allowed CPU to pin the worker to");
+        return -1;
+    }
+
+    int target = worker % processors;
+
+    CPU_ZERO(&cpu_set);
+
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu ++) {
+        if (CPU_ISSET(cpu, &allowed) && target -- == 0) {
+            CPU_SET(cpu, &cpu_set);
+            break;
+        }
+    }
+
+    if (sched_setaffinity(0, sizeof(cpu_set), &cpu_set) == -1) {
+        SL_LOG_WRITE(log, SL_LOG_ERROR, "sched_setaffinity()");
+        return -1;
+    }
+
+    unsigned int cpu, node;
+
+    if (syscall(SYS_getcpu, &cpu, &node, NULL) == -1) {
+        SL_LOG_WRITE(log, SL_LOG_ERROR, "getcpu()");
+        return -1;
+    }
+
+    return node;
+}
+
+void sl_main_event_loop(sl_arena *arena, sl_log *log, int server_socket, int numa_node)
+{
+    sl_net_connection *connections = NULL;
     struct epoll_event event, events[SL_MAIN_MAX_EVENTS];
+    sl_arena_pool arena_pool;
+    sl_slab connection_slab, param_slab;
+    sl_log_ring log_ring;
+
+    if (sl_main_log_ring_size > 0) {
+        if (sl_log_ring_init(&log_ring, sl_main_log_ring_size, sl_main_log_overflow, log->log_fd) == -1) {
+            SL_LOG_WRITE(log, SL_LOG_ERROR, "Unable to allocate log ring, logging synchronously");
+        } else {
+            sl_log_set_ring(log, &log_ring);
+        }
+    }
+
+    sl_arena_pool_init(&arena_pool, SL_MAIN_ARENA_PREALLOCATE, SL_MAIN_ARENA_POOL_BLOCKS);
+    sl_arena_pool_set_limit(&arena_pool, sl_main_worker_budget);
+
+    if (sl_arena_pool_map(&arena_pool, SL_MAIN_ARENA_MAPPED_BLOCKS, numa_node) == -1) {
+        SL_LOG_WRITE(log, SL_LOG_ERROR, "mmap()");
+    }
+    sl_slab_init(&connection_slab, sizeof(sl_net_connection), SL_MAIN_CONNECTION_SLAB_OBJECTS);
+    sl_slab_init(&param_slab, sizeof(sl_fcgi_msg_param), SL_MAIN_PARAM_SLAB_OBJECTS);
+
+    if (sl_main_init_cache(arena, log) == -1) {
+        SL_LOG_WRITE(log, SL_LOG_ERROR, "Unable to initialize response cache");
+        exit(EXIT_FAILURE);
+    }
+
+    sl_trace_init(&sl_main_trace, sl_main_trace_sample_rate);
+    sl_trace_register_route(&sl_main_trace, "/");
+
+    int metrics_route = sl_trace_register_route(&sl_main_trace, "/metrics");
+    if (metrics_route != -1) {
+        sl_main_metrics_route = metrics_route;
+    }
 
     struct sockaddr_in client_address;
     socklen_t client_address_size = sizeof(client_address);
 
     int epoll_instance = epoll_create1(0);
     if (epoll_instance == -1) {
-        sl_log_write(log, SL_LOG_ERROR, "epoll_create1()");
+        SL_LOG_WRITE(log, SL_LOG_ERROR, "epoll_create1()");
         exit(EXIT_FAILURE);
     }
 
     event.events = EPOLLIN;
-    event.data.fd = server_socket;
+    event.data.ptr = NULL;
 
     if (epoll_ctl(epoll_instance, EPOLL_CTL_ADD, server_socket, &event) == -1) {
-        sl_log_write(log, SL_LOG_ERROR, "epoll_ctl()");
+        SL_LOG_WRITE(log, SL_LOG_ERROR, "epoll_ctl()");
         exit(EXIT_FAILURE);
     }
 
     while (sl_main_running == true) {
         int num_events = epoll_wait(epoll_instance, events, SL_MAIN_MAX_EVENTS, -1);
         if (num_events == -1 && errno != EINTR) {
-            sl_log_write(log, SL_LOG_ERROR, "epoll_wait()");
+            SL_LOG_WRITE(log, SL_LOG_ERROR, "epoll_wait()");
             continue;
         }
 
+        sl_cache_update_date(&sl_main_cache, time(NULL));
+
         for (int n = 0; n < num_events; n ++) {
-            if (events[n].data.fd == server_socket) {
+            if (events[n].data.ptr == NULL) {
                 int client_socket = accept(server_socket, (struct sockaddr*) &client_address, &client_address_size);
                 if (client_socket == -1 && errno == EAGAIN) {
                     continue;
                 } else if (client_socket == -1) {
-                    sl_log_write(log, SL_LOG_ERROR, "accept()");
+                    SL_LOG_WRITE_LIMITED(log, SL_LOG_ERROR, "accept()");
                     continue;
                 }
 
+                SL_PROBE3(connection__accept, client_socket, ntohl(client_address.sin_addr.s_addr), ntohs(client_address.sin_port));
+
                 if (sl_net_set_nonblocking_socket(client_socket) == -1) {
-                    sl_log_write(log, SL_LOG_ERROR, "fcntl()");
+                    SL_LOG_WRITE_LIMITED(log, SL_LOG_ERROR, "fcntl()");
+                    sl_metrics_add(sl_main_metrics_worker, SL_METRICS_CONNECTIONS_REFUSED, 1);
+                    close(client_socket);
+                    continue;
+                }
+
+                if (connection_slab.used >= SL_MAIN_MAX_CONNECTIONS) {
+                    SL_LOG_WRITE_LIMITED(log, SL_LOG_ERROR, "No free connections left in the pool");
+                    sl_metrics_add(sl_main_metrics_worker, SL_METRICS_CONNECTIONS_REFUSED, 1);
                     close(client_socket);
                     continue;
                 }
 
-                sl_net_connection *connection = sl_net_find_free_connection(connections, SL_MAIN_MAX_CONNECTIONS);
+                sl_net_connection *connection = sl_net_create_connection(&connection_slab, &connections);
                 if (connection == NULL) {
-                    sl_log_write(log, SL_LOG_ERROR, "No free connections left in the pool");
+                    SL_LOG_WRITE_LIMITED(log, SL_LOG_ERROR, "Unable to allocate connection");
+                    sl_metrics_add(sl_main_metrics_worker, SL_METRICS_CONNECTIONS_REFUSED, 1);
                     close(client_socket);
                     continue;
                 }
 
                 event.events = EPOLLIN;
-                event.data.fd = client_socket;
+                event.data.ptr = connection;
 
                 if (epoll_ctl(epoll_instance, EPOLL_CTL_ADD, client_socket, &event) == -1) {
-                    sl_log_write(log, SL_LOG_ERROR, "epoll_ctl()");
+                    SL_LOG_WRITE(log, SL_LOG_ERROR, "epoll_ctl()");
+                    sl_net_destroy_connection(&connection_slab, &connections, connection);
+                    sl_metrics_add(sl_main_metrics_worker, SL_METRICS_CONNECTIONS_REFUSED, 1);
                     close(client_socket);
                     continue;
                 }
 
-                sl_net_init_connection(connection, log, client_socket, client_address, SL_MAIN_ARENA_PREALLOCATE, SL_MAIN_PARAMS_PREALLOCATE);
-                sl_log_write(&connection->log, SL_LOG_INFO, "Connection established");
-                connection->is_busy = true;
+                sl_net_init_connection(connection, log, client_socket, client_address, &arena_pool, &param_slab, SL_MAIN_ARENA_PREALLOCATE, sl_main_request_budget, SL_MAIN_PARAMS_PREALLOCATE);
+                connection->capture = sl_capture_accept(&sl_main_capture, &client_address);
+                SL_LOG_WRITE(&connection->log, SL_LOG_INFO, "Connection established");
+                sl_metrics_add(sl_main_metrics_worker, SL_METRICS_CONNECTIONS_ACCEPTED, 1);
+                sl_metrics_adjust(sl_main_metrics_worker, SL_METRICS_CONNECTIONS_ACTIVE, 1);
                 continue;
             }
 
-            sl_net_connection *connection = sl_net_find_connection(connections, SL_MAIN_MAX_CONNECTIONS, events[n].data.fd);
-            if (connection == NULL) {
-                sl_log_write_format(&connection->arena, log, SL_LOG_ERROR, "Unable to find connection in the pool for socket %z", events[n].data.fd);
+            sl_net_connection *connection = events[n].data.ptr;
 
-                if (epoll_ctl(epoll_instance, EPOLL_CTL_DEL, events[n].data.fd, NULL) == -1) {
-                    sl_log_write(log, SL_LOG_ERROR, "epoll_ctl()");
-                }
+            if (sl_main_process_connection(connection) == 0) {
+                int connection_socket = connection->socket_fd;
 
-                close(events[n].data.fd);
-                continue;
-            }
+                if (epoll_ctl(epoll_instance, EPOLL_CTL_DEL, connection_socket, NULL) == -1) {
+                    SL_LOG_WRITE(log, SL_LOG_ERROR, "epoll_ctl()");
+                }
 
-            if (sl_main_process_connection(connection) == 0) {
-                connection->is_busy = false;
+                SL_LOG_WRITE(&connection->log, SL_LOG_INFO, "Connection closed");
 
-                if (epoll_ctl(epoll_instance, EPOLL_CTL_DEL, events[n].data.fd, NULL) == -1) {
-                    sl_log_write(log, SL_LOG_ERROR, "epoll_ctl()");
+                if (connection->capture != 0) {
+                    sl_capture_close(&sl_main_capture, connection->capture);
                 }
 
-                sl_log_write(&connection->log, SL_LOG_INFO, "Connection closed");
+                sl_net_destroy_connection(&connection_slab, &connections, connection);
 
-                close(events[n].data.fd);
+                SL_PROBE1(connection__close, connection_socket);
+                sl_metrics_add(sl_main_metrics_worker, SL_METRICS_CONNECTIONS_CLOSED, 1);
+                sl_metrics_adjust(sl_main_metrics_worker, SL_METRICS_CONNECTIONS_ACTIVE, -1);
+                close(connection_socket);
             }
        }
+
+        sl_metrics_set(sl_main_metrics_worker, SL_METRICS_ARENA_POOL_RESIDENT, arena_pool.resident);
+        sl_metrics_set(sl_main_metrics_worker, SL_METRICS_ARENA_POOL_POOLED, arena_pool.pooled);
+
+        if (log->ring != NULL) {
+            sl_log_ring_flush(log->ring);
+        }
+
+        if (sl_main_capture.used > 0 && sl_capture_flush(&sl_main_capture) == -1) {
+            SL_LOG_WRITE_LIMITED(log, SL_LOG_ERROR, "Unable to write traffic capture");
+        }
+    }
+
+    SL_LOG_WRITE(log, SL_LOG_INFO, "Terminating worker process");
+    sl_net_destroy_connections(&connection_slab, &connections);
+
+    SL_LOG_WRITE_FORMAT(log, SL_LOG_INFO, "Arena pool: %z bytes resident, %z bytes pooled, %z bytes trimmed", arena_pool.resident, arena_pool.pooled, arena_pool.trimmed);
+    SL_LOG_WRITE_FORMAT(log, SL_LOG_INFO, "Response cache: %z hits", sl_main_cache.hits);
+    SL_LOG_WRITE_FORMAT(log, SL_LOG_INFO, "Compression: %z responses, %z skipped, %z bytes in, %z bytes out", sl_main_compress.responses, sl_main_compress.skipped, sl_main_compress.bytes_in, sl_main_compress.bytes_out);
+    sl_compress_destroy(&sl_main_compress);
+    sl_trace_log_summary(&sl_main_trace, log);
+    SL_LOG_WRITE_FORMAT(log, SL_LOG_INFO, "Arena budget: %z requests, %z overflowed preallocation, %z rejected, peak %z bytes used, peak %z bytes allocated", arena_pool.requests, arena_pool.overflowed, arena_pool.rejected, arena_pool.peak_used, arena_pool.peak_allocated);
+    sl_arena_pool_destroy(&arena_pool);
+    sl_slab_destroy(&param_slab);
+    sl_slab_destroy(&connection_slab);
+
+    if (log->ring != NULL) {
+        SL_LOG_WRITE_FORMAT(log, SL_LOG_INFO, "Log ring: %z lines, %z flushes, %z dropped", log_ring.lines, log_ring.flushes, log_ring.dropped);
+        sl_log_ring_destroy(&log_ring);
+        sl_log_set_ring(log, NULL);
+    }
+}
+
+int sl_main_parse_size(char *value, size_t *size)
+{
+    char *end = NULL;
+
+    errno = 0;
+    unsigned long long parsed = strtoull(value, &end, 10);
+    if (errno != 0 || end == value) {
+        return -1;
+    }
+
+    switch (*end) {
+        case 'G':
+        case 'g':
+            parsed <<= 10;
+            /* fallthrough */
+        case 'M':
+        case 'm':
+            parsed <<= 10;
+            /* fallthrough */
+        case 'K':
+        case 'k':
+            parsed <<= 10;
+            end ++;
+            break;
+        default:
+            break;
+    }
+
+    if (*end != '\0') {
+        return -1;
+    }
+
+    *size = parsed;
+
+    return 0;
+}
+
+int sl_main_parse_options(int argc, char *argv[])
+{
+    int option;
+
+    while ((option = getopt(argc, argv, "b:w:l:m:r:o:f:t:c:s:z:pv")) != -1) {
+        switch (option) {
+            case 'b':
+                if (sl_main_parse_size(optarg, &sl_main_request_budget) == -1) {
+                    return -1;
+                }
+                break;
+            case 'w':
+                if (sl_main_parse_size(optarg, &sl_main_worker_budget) == -1) {
+                    return -1;
+                }
+                break;
+            case 'l':
+                if (optarg[0] < '0' || optarg[0] > '9' || optarg[1] != '\0') {
+                    return -1;
+                }
+                sl_main_compress_level = optarg[0] - '0';
+                break;
+            case 'm':
+                if (sl_main_parse_size(optarg, &sl_main_compress_min_size) == -1) {
+                    return -1;
+                }
+                break;
+            case 'r':
+                if (sl_main_parse_size(optarg, &sl_main_log_ring_size) == -1) {
+                    return -1;
+                }
+                break;
+            case 'o':
+                if (strcmp(optarg, "block") == 0) {
+                    sl_main_log_overflow = SL_LOG_OVERFLOW_BLOCK;
+                } else if (strcmp(optarg, "drop") == 0) {
+                    sl_main_log_overflow = SL_LOG_OVERFLOW_DROP;
+                } else {
+                    return -1;
+                }
+                break;
+            case 'f':
+                if (strcmp(optarg, "text") == 0) {
+                    sl_main_log_mode = SL_LOG_MODE_TEXT;
+                } else if (strcmp(optarg, "binary") == 0) {
+                    sl_main_log_mode = SL_LOG_MODE_BINARY;
+                } else {
+                    return -1;
+                }
+                break;
+            case 't':
+                if (sl_main_parse_size(optarg, &sl_main_trace_sample_rate) == -1) {
+                    return -1;
+                }
+                break;
+            case 'c':
+                sl_main_capture_path = strdup(optarg);
+                if (sl_main_capture_path == NULL) {
+                    return -1;
+                }
+                break;
+            case 's':
+                if (sl_main_parse_size(optarg, &sl_main_capture_sample_rate) == -1 || sl_main_capture_sample_rate == 0) {
+                    return -1;
+                }
+                break;
+            case 'z':
+                if (sl_main_parse_size(optarg, &sl_main_capture_limit) == -1) {
+                    return -1;
+                }
+                break;
+            case 'p':
+                sl_main_pin_workers = true;
+                break;
+            case 'v':
+                if (sl_main_log_level > SL_LOG_DEBUG) {
+                    sl_main_log_level --;
+                }
+                break;
+            default:
+                return -1;
+        }
+    }
+
+    if (sl_main_request_budget != 0 && sl_main_request_budget < SL_MAIN_ARENA_PREALLOCATE) {
+        return -1;
+    }
+
+    if (sl_main_worker_budget != 0 && sl_main_request_budget > sl_main_worker_budget) {
+        return -1;
     }
 
-    sl_log_write(log, SL_LOG_INFO, "Terminating worker process");
-    sl_net_destroy_connections(connections, SL_MAIN_MAX_CONNECTIONS);
+    return 0;
 }
 
 int main(int argc, char *argv[], char *env[])
@@ -347,43 +885,83 @@ int main(int argc, char *argv[], char *env[])
 
     sl_arena_init(&arena, SL_MAIN_ARENA_PREALLOCATE);
 
+    sl_log_init(&log, SL_LOG_ERROR, STDOUT_FILENO);
+
+    if (sl_main_parse_options(argc, argv) == -1) {
+        SL_LOG_WRITE(&log, SL_LOG_ERROR, "Usage: [-b request budget] [-w worker budget] [-l compression level 0-9] [-m minimum compressed size] [-r log ring size, 0 writes synchronously] [-o log overflow policy block|drop] [-f log format text|binary] [-t trace 1 in N requests] [-c capture traffic to path.N per worker] [-s capture 1 in N connections] [-z stop capturing new connections past this size per worker, 0 is unlimited] [-p pin each worker to one allowed CPU] [-v more verbose, repeatable], sizes in bytes with optional K/M/G suffix, budgets of 0 are unlimited");
+        exit(EXIT_FAILURE);
+    }
+
     sl_main_set_process_name(argc, argv, env, SL_MAIN_MASTER_PROCESS_NAME);
 
-    sl_log_init(&log, SL_LOG_ERROR, STDOUT_FILENO);
     sl_log_set_pid(&log, getpid());
+    sl_log_set_mode(&log, sl_main_log_mode);
+    sl_log_set_min_level(&log, sl_main_log_level);
+
+    sl_trace_calibrate();
+
+    sl_main_metrics = sl_metrics_create(SL_MAIN_MAX_PROCESSES);
+    if (sl_main_metrics == NULL) {
+        SL_LOG_WRITE(&log, SL_LOG_ERROR, "mmap()");
+        exit(EXIT_FAILURE);
+    }
 
     if (sl_main_init_signals() == -1) {
-        sl_log_write(&log, SL_LOG_ERROR, "signal()");
+        SL_LOG_WRITE(&log, SL_LOG_ERROR, "signal()");
         exit(EXIT_FAILURE);
     }
 
     int server_socket = sl_net_create_listen_socket(INADDR_ANY, 9000, SL_NET_LISTEN_BACKLOG);
     if (server_socket == -1) {
-        sl_log_write(&log, SL_LOG_ERROR, "sl_main_create_socket()");
+        SL_LOG_WRITE(&log, SL_LOG_ERROR, "sl_main_create_socket()");
         exit(EXIT_FAILURE);
     }
 
     if (sl_net_set_nonblocking_socket(server_socket) == -1) {
-        sl_log_write(&log, SL_LOG_ERROR, "fcntl()");
+        SL_LOG_WRITE(&log, SL_LOG_ERROR, "fcntl()");
         exit(EXIT_FAILURE);
     }
 
     for (int n = 0; n < SL_MAIN_MAX_PROCESSES; n ++) {
         pid_t pid = fork();
         if (pid == -1) {
-            sl_log_write(&log, SL_LOG_ERROR, "fork()");
+            SL_LOG_WRITE(&log, SL_LOG_ERROR, "fork()");
             exit(EXIT_FAILURE);
         }
 
         if (pid > 0) {
-            sl_log_write_format(&arena, &log, SL_LOG_INFO, "Spawned worker process %z", pid);
+            SL_LOG_WRITE_FORMAT(&log, SL_LOG_INFO, "Spawned worker process %d", pid);
             continue;
         }
 
         sl_main_set_process_name(argc, argv, env, SL_MAIN_WORKER_PROCESS_NAME);
         sl_log_set_pid(&log, getpid());
 
-        sl_main_event_loop(&log, server_socket);
+        sl_main_metrics_worker = sl_metrics_attach(sl_main_metrics, n, getpid());
+
+        if (sl_hashtable_init_seed() == -1) {
+            SL_LOG_WRITE(&log, SL_LOG_ERROR, "getrandom()");
+            exit(EXIT_FAILURE);
+        }
+
+        int numa_node = sl_main_pin_workers == true ? sl_main_pin_worker(&log, n) : -1;
+
+        if (sl_main_capture_path != NULL) {
+            char capture_path[PATH_MAX];
+
+            snprintf(capture_path, sizeof(capture_path), "%s.%d", sl_main_capture_path, n);
+
+            if (sl_capture_open(&sl_main_capture, capture_path, sl_main_capture_sample_rate, sl_main_capture_limit) == -1) {
+                SL_LOG_WRITE(&log, SL_LOG_ERROR, "Unable to open traffic capture, capturing disabled");
+            }
+        }
+
+        sl_main_event_loop(&arena, &log, server_socket, numa_node);
+
+        if (sl_main_capture.buffer != NULL) {
+            SL_LOG_WRITE_FORMAT(&log, SL_LOG_INFO, "Traffic capture: %z connections, %z records, %z bytes, %z dropped", sl_main_capture.connections, sl_main_capture.records, sl_main_capture.bytes, sl_main_capture.dropped);
+            sl_capture_destroy(&sl_main_capture);
+        }
 
         sl_arena_destroy(&arena);
         return EXIT_SUCCESS;
@@ -392,8 +970,9 @@ int main(int argc, char *argv[], char *env[])
     sl_arena_destroy(&arena);
     close(server_socket);
     wait(NULL);
+    sl_metrics_destroy(sl_main_metrics);
 
-    sl_log_write(&log, SL_LOG_INFO, "Terminating master process");
+    SL_LOG_WRITE(&log, SL_LOG_INFO, "Terminating master process");
 
     return EXIT_SUCCESS;
 }
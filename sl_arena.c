@@ -1,6 +1,14 @@
 #include "sl_arena.h"
 
 #include <stdlib.h>
+#include <stdbool.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include "sl_probe.h"
+
+#define SL_ARENA_MPOL_BIND 2
+#define SL_ARENA_PAGE_SIZE 4096
 
 size_t sl_arena_pow2_size(size_t size)
 {
@@ -16,100 +24,495 @@ size_t sl_arena_pow2_size(size_t size)
     return size;
 }
 
-static sl_arena_block *sl_arena_create_block(size_t size)
+static sl_arena_block *sl_arena_create_block(sl_arena *arena, size_t size)
 {
-    sl_arena_block *block = malloc(sizeof(sl_arena_block) + size);
-    if (block == NULL) {
-        return NULL;
+    sl_arena_pool *pool = arena->pool;
+    sl_arena_block *block = NULL;
+
+    bool reused = pool != NULL && size == pool->block_size && pool->first != NULL;
+
+    if (reused == true) {
+        block = pool->first;
+        pool->first = block->next;
+        pool->blocks --;
+        pool->pooled -= sizeof(sl_arena_block) + block->allocated;
+    } else {
+        if (pool != NULL && pool->limit != 0 && pool->resident + sizeof(sl_arena_block) + size > pool->limit) {
+            pool->rejected ++;
+            arena->exceeded = true;
+            return NULL;
+        }
+
+        block = malloc(sizeof(sl_arena_block) + size);
+        if (block == NULL) {
+            return NULL;
+        }
+
+        block->allocated = size;
+
+        if (pool != NULL) {
+            pool->resident += sizeof(sl_arena_block) + size;
+        }
     }
 
     block->next = NULL;
-    block->allocated = size;
     block->used = 0;
 
+    SL_PROBE3(arena__block, arena, block->allocated, reused);
+
     return block;
 }
 
-static void *sl_arena_allocate_from_block(sl_arena_block *block, size_t size)
+static inline bool sl_arena_pool_owns(sl_arena_pool *pool, sl_arena_block *block)
 {
-    if (size > block->allocated - block->used) {
-        return NULL;
+    return (uint8_t *) block >= pool->region && (uint8_t *) block < pool->region + pool->region_size;
+}
+
+static void sl_arena_destroy_block(sl_arena *arena, sl_arena_block *block)
+{
+    sl_arena_pool *pool = arena->pool;
+
+    if (pool == NULL) {
+        free(block);
+        return;
     }
 
-    void *buffer = block->buffer + block->used;
-    block->used += size;
+    size_t size = sizeof(sl_arena_block) + block->allocated;
 
-    return buffer;
+    if (sl_arena_pool_owns(pool, block) || (block->allocated == pool->block_size && pool->blocks < pool->max_blocks)) {
+        block->next = pool->first;
+        pool->first = block;
+        pool->blocks ++;
+        pool->pooled += size;
+        return;
+    }
+
+    pool->resident -= size;
+    pool->trimmed += size;
+
+    free(block);
 }
 
-void sl_arena_init(sl_arena *arena, size_t preallocate)
+static void sl_arena_release_blocks(sl_arena *arena, sl_arena_block *first)
 {
-    *arena = (sl_arena) {0};
+    sl_arena_block *next = NULL;
 
-    arena->preallocate = preallocate;
+    for (sl_arena_block *block = first; block != NULL; block = next) {
+        next = block->next;
+
+        arena->blocks --;
+        arena->allocated -= block->allocated;
+
+        sl_arena_destroy_block(arena, block);
+    }
 }
 
-void sl_arena_rewind(sl_arena *arena)
+static inline void *sl_arena_allocate_from_block(sl_arena_block *block, size_t size, size_t alignment)
 {
-    for (sl_arena_block *block = arena->first; block != NULL; block = block->next) {
-        block->used = 0;
+    uintptr_t start = (uintptr_t) (block->buffer + block->used);
+    size_t padding = (alignment - (start & (alignment - 1))) & (alignment - 1);
+    size_t available = block->allocated - block->used;
+
+    if (padding > available || size > available - padding) {
+        return NULL;
     }
+
+    block->used += padding + size;
+
+    return (void *) (start + padding);
 }
 
-void sl_arena_destroy(sl_arena *arena)
+static void *sl_arena_allocate_from_free(sl_arena *arena, size_t size, size_t alignment)
 {
-    sl_arena_block *previous = NULL;
+    size_t size_class = size <= 1 ? 0 : 64 - __builtin_clzl(size - 1);
+    if (size_class >= SL_ARENA_FREE_CLASSES) {
+        return NULL;
+    }
+
+    for (uint64_t classes = arena->free_mask >> size_class << size_class; classes != 0; classes &= classes - 1) {
+        size_t chunk_class = __builtin_ctzl(classes);
+        sl_arena_chunk *chunk = arena->free_chunks[chunk_class];
 
-    for (sl_arena_block *block = arena->first; block != NULL; block = block->next) {
-        if (previous != NULL) {
-            free(previous);
+        uintptr_t start = (uintptr_t) chunk;
+        size_t padding = (alignment - (start & (alignment - 1))) & (alignment - 1);
+        size_t chunk_size = chunk->size;
+
+        if (padding > chunk_size || size > chunk_size - padding) {
+            continue;
         }
 
-        previous = block;
+        arena->free_chunks[chunk_class] = chunk->next;
+
+        if (chunk->next == NULL) {
+            arena->free_mask &= ~((uint64_t) 1 << chunk_class);
+        }
+
+        size_t taken = (padding + size + _Alignof(sl_arena_chunk) - 1) & ~(_Alignof(sl_arena_chunk) - 1);
+
+        if (taken < chunk_size) {
+            sl_arena_free(arena, (uint8_t *) chunk + taken, chunk_size - taken);
+        }
+
+        return (void *) (start + padding);
     }
 
-    free(previous);
+    return NULL;
+}
 
-    sl_arena_init(arena, arena->preallocate);
+static sl_arena_block *sl_arena_find_free_block(sl_arena *arena, size_t size)
+{
+    sl_arena_block *current = arena->current;
+    sl_arena_block *previous = current;
+
+    for (sl_arena_block *block = current->next; block != NULL; block = block->next) {
+        if (block->allocated >= size) {
+            if (previous != current) {
+                previous->next = block->next;
+                block->next = current->next;
+                current->next = block;
+
+                if (arena->last == block) {
+                    arena->last = previous;
+                }
+            }
+
+            return block;
+        }
+
+        previous = block;
+    }
+
+    return NULL;
 }
 
-void *sl_arena_allocate(sl_arena *arena, size_t size)
+static void *sl_arena_allocate_from_new_block(sl_arena *arena, size_t size, size_t alignment)
 {
+    sl_arena_block *current = arena->current;
     sl_arena_block *block = NULL;
-    void *buffer = NULL;
 
-    for (block = arena->first; block != NULL; block = block->next) {
-        if ((buffer = sl_arena_allocate_from_block(block, size)) != NULL) {
-            arena->allocations ++;
-            arena->used += size;
-            return buffer;
+    if (current != NULL && (block = sl_arena_find_free_block(arena, size + alignment)) != NULL) {
+        block->used = 0;
+        arena->current = block;
+
+        return sl_arena_allocate_from_block(block, size, alignment);
+    }
+
+    size_t block_size = size > (arena->preallocate >> 1) ? (size + alignment) << 1 : arena->preallocate;
+
+    if (arena->limit != 0 && arena->allocated + block_size > arena->limit) {
+        block_size = size + alignment;
+
+        if (arena->allocated + block_size > arena->limit) {
+            arena->exceeded = true;
+            return NULL;
         }
     }
 
-    block = sl_arena_create_block(size > (arena->preallocate >> 1) ? size << 1 : arena->preallocate);
+    block = sl_arena_create_block(arena, block_size);
     if (block == NULL) {
         return NULL;
     }
 
-    if (arena->last != NULL) {
-        arena->last->next = block;
+    if (current == NULL) {
+        arena->first = block;
+        arena->last = block;
+    } else {
+        block->next = current->next;
+        current->next = block;
+
+        if (arena->last == current) {
+            arena->last = block;
+        }
     }
 
-    arena->last = block;
+    arena->current = block;
     arena->blocks ++;
     arena->allocated += block->allocated;
 
-    if (arena->first == NULL) {
-        arena->first = arena->last;
+    return sl_arena_allocate_from_block(block, size, alignment);
+}
+
+void sl_arena_pool_init(sl_arena_pool *pool, size_t block_size, size_t max_blocks)
+{
+    *pool = (sl_arena_pool) {0};
+
+    pool->block_size = block_size;
+    pool->max_blocks = max_blocks;
+}
+
+static uint8_t *sl_arena_pool_map_region(size_t size, int numa_node)
+{
+    int populate = numa_node < 0 ? MAP_POPULATE : 0;
+
+    void *region = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | populate, -1, 0);
+    if (region != MAP_FAILED) {
+        return region;
     }
 
-    buffer = sl_arena_allocate_from_block(block, size);
-    if (buffer == NULL) {
+    region = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | populate, -1, 0);
+    if (region == MAP_FAILED) {
         return NULL;
     }
 
+    madvise(region, size, MADV_HUGEPAGE);
+
+    return region;
+}
+
+static void sl_arena_pool_bind_region(uint8_t *region, size_t size, int numa_node)
+{
+    unsigned long node_mask = 1ul << numa_node;
+
+    syscall(SYS_mbind, region, size, SL_ARENA_MPOL_BIND, &node_mask, sizeof(node_mask) * 8, 0);
+
+    for (size_t offset = 0; offset < size; offset += SL_ARENA_PAGE_SIZE) {
+        region[offset] = 0;
+    }
+}
+
+int sl_arena_pool_map(sl_arena_pool *pool, size_t blocks, int numa_node)
+{
+    size_t block_size = (sizeof(sl_arena_block) + pool->block_size + SL_ARENA_MAX_ALIGNMENT - 1) & ~(SL_ARENA_MAX_ALIGNMENT - 1);
+    size_t size = (block_size * blocks + SL_ARENA_HUGEPAGE_SIZE - 1) & ~((size_t) SL_ARENA_HUGEPAGE_SIZE - 1);
+
+    if (pool->region != NULL || blocks == 0 || numa_node >= (int) (sizeof(unsigned long) * 8)) {
+        return -1;
+    }
+
+    uint8_t *region = sl_arena_pool_map_region(size, numa_node);
+    if (region == NULL) {
+        return -1;
+    }
+
+    if (numa_node >= 0) {
+        sl_arena_pool_bind_region(region, size, numa_node);
+    }
+
+    pool->region = region;
+    pool->region_size = size;
+    pool->resident += size;
+
+    for (size_t n = size / block_size; n > 0; n --) {
+        sl_arena_block *block = (sl_arena_block *) (region + (n - 1) * block_size);
+
+        block->allocated = pool->block_size;
+        block->next = pool->first;
+
+        pool->first = block;
+        pool->blocks ++;
+        pool->pooled += sizeof(sl_arena_block) + block->allocated;
+    }
+
+    return 0;
+}
+
+void sl_arena_pool_set_limit(sl_arena_pool *pool, size_t limit)
+{
+    pool->limit = limit;
+}
+
+void sl_arena_pool_record(sl_arena_pool *pool, sl_arena *arena)
+{
+    pool->requests ++;
+
+    if (arena->blocks > 1) {
+        pool->overflowed ++;
+    }
+
+    if (arena->used > pool->peak_used) {
+        pool->peak_used = arena->used;
+    }
+
+    if (arena->allocated > pool->peak_allocated) {
+        pool->peak_allocated = arena->allocated;
+    }
+}
+
+void sl_arena_pool_destroy(sl_arena_pool *pool)
+{
+    sl_arena_block *next = NULL;
+
+    for (sl_arena_block *block = pool->first; block != NULL; block = next) {
+        next = block->next;
+
+        if (sl_arena_pool_owns(pool, block) == false) {
+            free(block);
+        }
+    }
+
+    if (pool->region != NULL) {
+        munmap(pool->region, pool->region_size);
+    }
+
+    sl_arena_pool_init(pool, pool->block_size, pool->max_blocks);
+}
+
+void sl_arena_init(sl_arena *arena, size_t preallocate)
+{
+    *arena = (sl_arena) {0};
+
+    arena->preallocate = preallocate;
+}
+
+void sl_arena_set_pool(sl_arena *arena, sl_arena_pool *pool)
+{
+    arena->pool = pool;
+}
+
+void sl_arena_set_limit(sl_arena *arena, size_t limit)
+{
+    arena->limit = limit;
+}
+
+void sl_arena_rewind(sl_arena *arena)
+{
+    if (arena->pool != NULL && arena->first != NULL && arena->first->allocated != arena->pool->block_size) {
+        sl_arena_release(arena);
+        return;
+    }
+
+    if (arena->pool != NULL && arena->first != NULL) {
+        sl_arena_release_blocks(arena, arena->first->next);
+
+        arena->first->next = NULL;
+        arena->last = arena->first;
+    }
+
+    arena->current = arena->first;
+
+    if (arena->current != NULL) {
+        arena->current->used = 0;
+    }
+
+    arena->allocations = 0;
+    arena->used = 0;
+    arena->exceeded = false;
+    arena->free_mask = 0;
+}
+
+void sl_arena_release(sl_arena *arena)
+{
+    sl_arena_release_blocks(arena, arena->first);
+
+    arena->first = NULL;
+    arena->last = NULL;
+    arena->current = NULL;
+    arena->allocations = 0;
+    arena->used = 0;
+    arena->exceeded = false;
+    arena->free_mask = 0;
+}
+
+void sl_arena_destroy(sl_arena *arena)
+{
+    sl_arena_pool *pool = arena->pool;
+    sl_arena_block *next = NULL;
+
+    for (sl_arena_block *block = arena->first; block != NULL; block = next) {
+        next = block->next;
+
+        if (pool != NULL && sl_arena_pool_owns(pool, block) == true) {
+            sl_arena_destroy_block(arena, block);
+            continue;
+        }
+
+        if (pool != NULL) {
+            pool->resident -= sizeof(sl_arena_block) + block->allocated;
+        }
+
+        free(block);
+    }
+
+    size_t limit = arena->limit;
+
+    sl_arena_init(arena, arena->preallocate);
+    sl_arena_set_pool(arena, pool);
+    sl_arena_set_limit(arena, limit);
+}
+
+void *sl_arena_allocate(sl_arena *arena, size_t size)
+{
+    size_t alignment = size & -size;
+
+    if (alignment == 0 || alignment > SL_ARENA_MAX_ALIGNMENT) {
+        alignment = SL_ARENA_MAX_ALIGNMENT;
+    }
+
+    return sl_arena_allocate_aligned(arena, size, alignment);
+}
+
+void *sl_arena_allocate_aligned(sl_arena *arena, size_t size, size_t alignment)
+{
+    void *buffer = NULL;
+
+    if (arena->free_mask != 0) {
+        buffer = sl_arena_allocate_from_free(arena, size, alignment);
+    }
+
+    if (buffer == NULL && arena->current != NULL) {
+        buffer = sl_arena_allocate_from_block(arena->current, size, alignment);
+    }
+
+    if (buffer == NULL) {
+        buffer = sl_arena_allocate_from_new_block(arena, size, alignment);
+        if (buffer == NULL) {
+            return NULL;
+        }
+    }
+
     arena->allocations ++;
-    arena->used +=size;
+    arena->used += size;
 
     return buffer;
 }
+
+int sl_arena_extend(sl_arena *arena, void *buffer, size_t size, size_t new_size)
+{
+    sl_arena_block *block = arena->current;
+
+    if (block == NULL || (uint8_t *) buffer + size != block->buffer + block->used || new_size < size) {
+        return -1;
+    }
+
+    if (new_size - size > block->allocated - block->used) {
+        return -1;
+    }
+
+    block->used += new_size - size;
+    arena->used += new_size - size;
+
+    return 0;
+}
+
+void sl_arena_free(sl_arena *arena, void *buffer, size_t size)
+{
+    if (buffer == NULL || size < sizeof(sl_arena_chunk)) {
+        return;
+    }
+
+    size_t size_class = 63 - __builtin_clzl(size);
+    sl_arena_chunk *chunk = buffer;
+
+    chunk->size = size;
+    chunk->next = (arena->free_mask & ((uint64_t) 1 << size_class)) != 0 ? arena->free_chunks[size_class] : NULL;
+
+    arena->free_chunks[size_class] = chunk;
+    arena->free_mask |= (uint64_t) 1 << size_class;
+}
+
+sl_arena_mark sl_arena_save(sl_arena *arena)
+{
+    return (sl_arena_mark) {arena->current, arena->current != NULL ? arena->current->used : 0};
+}
+
+void sl_arena_restore(sl_arena *arena, sl_arena_mark mark)
+{
+    if (mark.block == NULL) {
+        sl_arena_rewind(arena);
+        return;
+    }
+
+    arena->current = mark.block;
+    arena->current->used = mark.used;
+    arena->free_mask = 0;
+}
@@ -2,9 +2,18 @@
 #define SL_ARENA_H
 
 #include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
 #include <unistd.h>
 
+#define SL_ARENA_FREE_CLASSES 64
+#define SL_ARENA_HUGEPAGE_SIZE (2 * 1024 * 1024)
+#define SL_ARENA_MAX_ALIGNMENT _Alignof(max_align_t)
+
 typedef struct sl_arena_block sl_arena_block;
+typedef struct sl_arena_chunk sl_arena_chunk;
+typedef struct sl_arena_mark sl_arena_mark;
+typedef struct sl_arena_pool sl_arena_pool;
 typedef struct sl_arena sl_arena;
 
 struct sl_arena_block {
@@ -14,21 +23,70 @@ struct sl_arena_block {
     uint8_t buffer[];
 };
 
+struct sl_arena_chunk {
+    sl_arena_chunk *next;
+    size_t size;
+};
+
+struct sl_arena_mark {
+    sl_arena_block *block;
+    size_t used;
+};
+
+struct sl_arena_pool {
+    sl_arena_block *first;
+    uint8_t *region;
+    size_t region_size;
+    size_t block_size;
+    size_t max_blocks;
+    size_t blocks;
+    size_t resident;
+    size_t pooled;
+    size_t trimmed;
+    size_t limit;
+    size_t rejected;
+    size_t requests;
+    size_t overflowed;
+    size_t peak_used;
+    size_t peak_allocated;
+};
+
 struct sl_arena {
+    sl_arena_pool *pool;
     sl_arena_block *first;
     sl_arena_block *last;
+    sl_arena_block *current;
     size_t preallocate;
     size_t allocations;
     size_t allocated;
     size_t blocks;
     size_t used;
+    size_t limit;
+    bool exceeded;
+    uint64_t free_mask;
+    sl_arena_chunk *free_chunks[SL_ARENA_FREE_CLASSES];
 };
 
 size_t sl_arena_pow2_size(size_t size);
 
+void sl_arena_pool_init(sl_arena_pool *pool, size_t block_size, size_t max_blocks);
+int sl_arena_pool_map(sl_arena_pool *pool, size_t blocks, int numa_node);
+void sl_arena_pool_set_limit(sl_arena_pool *pool, size_t limit);
+void sl_arena_pool_record(sl_arena_pool *pool, sl_arena *arena);
+void sl_arena_pool_destroy(sl_arena_pool *pool);
+
 void sl_arena_init(sl_arena *arena, size_t preallocate);
+void sl_arena_set_pool(sl_arena *arena, sl_arena_pool *pool);
+void sl_arena_set_limit(sl_arena *arena, size_t limit);
 void sl_arena_rewind(sl_arena *arena);
+void sl_arena_release(sl_arena *arena);
 void sl_arena_destroy(sl_arena *arena);
 void *sl_arena_allocate(sl_arena *arena, size_t size);
+void *sl_arena_allocate_aligned(sl_arena *arena, size_t size, size_t alignment);
+int sl_arena_extend(sl_arena *arena, void *buffer, size_t size, size_t new_size);
+void sl_arena_free(sl_arena *arena, void *buffer, size_t size);
+
+sl_arena_mark sl_arena_save(sl_arena *arena);
+void sl_arena_restore(sl_arena *arena, sl_arena_mark mark);
 
 #endif
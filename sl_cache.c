@@ -0,0 +1,206 @@
+#include "sl_cache.h"
+#include "sl_view.h"
+
+#include <string.h>
+#include <arpa/inet.h>
+
+#define SL_CACHE_NO_DATE SIZE_MAX
+
+static const char sl_cache_days[7][4] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+static const char sl_cache_months[12][4] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+
+static inline void sl_cache_format_digits(char *buffer, int value)
+{
+    buffer[0] = '0' + value / 10;
+    buffer[1] = '0' + value % 10;
+}
+
+void sl_cache_init(sl_cache *cache, sl_arena *arena)
+{
+    *cache = (sl_cache) {0};
+
+    cache->arena = arena;
+    cache->date_time = -1;
+
+    memcpy(cache->date_line, "Date: ", sizeof("Date: ") - 1);
+    memcpy(cache->date_line + SL_CACHE_DATE_LINE_LENGTH - 2, "\r\n", 2);
+
+    cache->date = sl_string_init_with_buffer(cache->date_line, SL_CACHE_DATE_LINE_LENGTH);
+
+    sl_cache_update_date(cache, time(NULL));
+}
+
+void sl_cache_update_date(sl_cache *cache, time_t now)
+{
+    struct tm tm;
+
+    if (now == cache->date_time || gmtime_r(&now, &tm) == NULL) {
+        return;
+    }
+
+    char *date = cache->date_line + sizeof("Date: ") - 1;
+
+    memcpy(date, sl_cache_days[tm.tm_wday], 3);
+    memcpy(date + 3, ", ", 2);
+    sl_cache_format_digits(date + 5, tm.tm_mday);
+    date[7] = ' ';
+    memcpy(date + 8, sl_cache_months[tm.tm_mon], 3);
+    date[11] = ' ';
+    sl_cache_format_digits(date + 12, (tm.tm_year + 1900) / 100);
+    sl_cache_format_digits(date + 14, (tm.tm_year + 1900) % 100);
+    date[16] = ' ';
+    sl_cache_format_digits(date + 17, tm.tm_hour);
+    date[19] = ':';
+    sl_cache_format_digits(date + 20, tm.tm_min);
+    date[22] = ':';
+    sl_cache_format_digits(date + 23, tm.tm_sec);
+    memcpy(date + 25, " GMT", 4);
+
+    cache->date_time = now;
+}
+
+sl_string *sl_cache_create_header(sl_cache *cache, char *name, char *value)
+{
+    sl_string_builder builder;
+    size_t name_length = strlen(name), value_length = strlen(value);
+
+    sl_string *header = sl_arena_allocate(cache->arena, sizeof(sl_string));
+    if (header == NULL) {
+        return NULL;
+    }
+
+    sl_string_builder_init(&builder, cache->arena);
+
+    if (sl_string_builder_reserve(&builder, name_length + value_length + 4) == -1 ||
+        sl_string_builder_append(&builder, name, name_length) == -1 ||
+        sl_string_builder_append(&builder, ": ", 2) == -1 ||
+        sl_string_builder_append(&builder, value, value_length) == -1 ||
+        sl_string_builder_append(&builder, "\r\n", 2) == -1) {
+        return NULL;
+    }
+
+    *header = builder.string;
+
+    return header;
+}
+
+static size_t sl_cache_find_records(uint8_t *buffer, size_t length, size_t *request_id_offsets)
+{
+    size_t records = 0, offset = 0;
+
+    while (offset + sizeof(sl_fcgi_msg_header) <= length) {
+        sl_fcgi_msg_header header;
+
+        memcpy(&header, buffer + offset, sizeof(sl_fcgi_msg_header));
+
+        if (request_id_offsets != NULL) {
+            request_id_offsets[records] = offset + offsetof(sl_fcgi_msg_header, request_id);
+        }
+
+        offset += sizeof(sl_fcgi_msg_header) + ntohs(header.content_length) + header.padding_length;
+        records ++;
+    }
+
+    return records;
+}
+
+sl_cache_response *sl_cache_register_response(sl_cache *cache, sl_string *key, sl_compress_encoding encoding, sl_fcgi_response *response)
+{
+    if (sl_fcgi_response_serialize(response, 0, SL_FCGI_PROTOCOL_STATUS_REQUEST_COMPLETE) == -1) {
+        return NULL;
+    }
+
+    sl_cache_response *cached = sl_arena_allocate(cache->arena, sizeof(sl_cache_response));
+    if (cached == NULL) {
+        return NULL;
+    }
+
+    *cached = (sl_cache_response) {0};
+
+    cached->key.buffer = sl_arena_allocate(cache->arena, key->length);
+    cached->buffer = sl_arena_allocate(cache->arena, response->length);
+    if (cached->key.buffer == NULL || cached->buffer == NULL) {
+        return NULL;
+    }
+
+    memcpy(cached->key.buffer, key->buffer, key->length);
+
+    cached->key.length = key->length;
+    cached->key.allocated = key->length;
+    cached->encoding = encoding;
+    cached->date_offset = SL_CACHE_NO_DATE;
+
+    for (size_t n = 0; n < response->iovec_count; n ++) {
+        struct iovec *iovec = &response->iovecs[n];
+
+        if (iovec->iov_base == cache->date_line && iovec->iov_len == SL_CACHE_DATE_LINE_LENGTH) {
+            cached->date_offset = cached->length;
+        }
+
+        memcpy(cached->buffer + cached->length, iovec->iov_base, iovec->iov_len);
+        cached->length += iovec->iov_len;
+    }
+
+    cached->records = sl_cache_find_records(cached->buffer, cached->length, NULL);
+
+    cached->request_id_offsets = sl_arena_allocate(cache->arena, cached->records * sizeof(size_t));
+    if (cached->request_id_offsets == NULL) {
+        return NULL;
+    }
+
+    sl_cache_find_records(cached->buffer, cached->length, cached->request_id_offsets);
+
+    cached->next = cache->responses;
+    cache->responses = cached;
+
+    return cached;
+}
+
+sl_cache_response *sl_cache_get_response(sl_cache *cache, sl_string *key, sl_compress_encoding encoding)
+{
+    sl_cache_response *identity = NULL;
+
+    for (sl_cache_response *cached = cache->responses; cached != NULL; cached = cached->next) {
+        if (sl_view_equal(&cached->key, key) == false) {
+            continue;
+        }
+
+        if (cached->encoding == encoding) {
+            return cached;
+        }
+
+        if (cached->encoding == SL_COMPRESS_ENCODING_IDENTITY) {
+            identity = cached;
+        }
+    }
+
+    return identity;
+}
+
+size_t sl_cache_prepare_response(sl_cache *cache, sl_cache_response *response, uint16_t request_id, struct iovec *iovecs)
+{
+    if (request_id != response->request_id) {
+        uint16_t network_request_id = htons(request_id);
+
+        for (size_t n = 0; n < response->records; n ++) {
+            memcpy(response->buffer + response->request_id_offsets[n], &network_request_id, sizeof(uint16_t));
+        }
+
+        response->request_id = request_id;
+    }
+
+    cache->hits ++;
+
+    if (response->date_offset == SL_CACHE_NO_DATE) {
+        iovecs[0] = (struct iovec) {response->buffer, response->length};
+        return 1;
+    }
+
+    size_t tail_offset = response->date_offset + SL_CACHE_DATE_LINE_LENGTH;
+
+    iovecs[0] = (struct iovec) {response->buffer, response->date_offset};
+    iovecs[1] = (struct iovec) {cache->date_line, SL_CACHE_DATE_LINE_LENGTH};
+    iovecs[2] = (struct iovec) {response->buffer + tail_offset, response->length - tail_offset};
+
+    return SL_CACHE_RESPONSE_IOVECS;
+}
@@ -0,0 +1,49 @@
+#ifndef SL_CACHE_H
+#define SL_CACHE_H
+
+#include <stdint.h>
+#include <time.h>
+#include <sys/uio.h>
+
+#include "sl_arena.h"
+#include "sl_string.h"
+#include "sl_fcgi.h"
+#include "sl_compress.h"
+
+#define SL_CACHE_DATE_LENGTH      29
+#define SL_CACHE_DATE_LINE_LENGTH (sizeof("Date: ") - 1 + SL_CACHE_DATE_LENGTH + 2)
+#define SL_CACHE_RESPONSE_IOVECS  3
+
+typedef struct sl_cache_response sl_cache_response;
+typedef struct sl_cache sl_cache;
+
+struct sl_cache_response {
+    sl_cache_response *next;
+    sl_string key;
+    sl_compress_encoding encoding;
+    uint8_t *buffer;
+    size_t length;
+    size_t date_offset;
+    size_t *request_id_offsets;
+    size_t records;
+    uint16_t request_id;
+};
+
+struct sl_cache {
+    sl_arena *arena;
+    time_t date_time;
+    char date_line[SL_CACHE_DATE_LINE_LENGTH];
+    sl_string date;
+    sl_cache_response *responses;
+    size_t hits;
+};
+
+void sl_cache_init(sl_cache *cache, sl_arena *arena);
+void sl_cache_update_date(sl_cache *cache, time_t now);
+sl_string *sl_cache_create_header(sl_cache *cache, char *name, char *value);
+
+sl_cache_response *sl_cache_register_response(sl_cache *cache, sl_string *key, sl_compress_encoding encoding, sl_fcgi_response *response);
+sl_cache_response *sl_cache_get_response(sl_cache *cache, sl_string *key, sl_compress_encoding encoding);
+size_t sl_cache_prepare_response(sl_cache *cache, sl_cache_response *response, uint16_t request_id, struct iovec *iovecs);
+
+#endif
@@ -0,0 +1,173 @@
+#include "sl_capture.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+
+#include <arpa/inet.h>
+
+static uint64_t sl_capture_clock(clockid_t clock)
+{
+    struct timespec timestamp;
+
+    clock_gettime(clock, &timestamp);
+
+    return (uint64_t) timestamp.tv_sec * 1000000000 + timestamp.tv_nsec;
+}
+
+int sl_capture_open(sl_capture *capture, char *path, size_t sample_rate, size_t limit)
+{
+    *capture = (sl_capture) {0};
+
+    capture->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (capture->fd == -1) {
+        return -1;
+    }
+
+    capture->buffer = malloc(SL_CAPTURE_BUFFER_SIZE);
+    if (capture->buffer == NULL) {
+        close(capture->fd);
+        return -1;
+    }
+
+    sl_capture_header header = {
+        .version = SL_CAPTURE_VERSION,
+        .sample_rate = sample_rate,
+        .started = sl_capture_clock(CLOCK_REALTIME),
+        .pid = getpid()
+    };
+
+    memcpy(header.magic, SL_CAPTURE_MAGIC, SL_CAPTURE_MAGIC_SIZE);
+    memcpy(capture->buffer, &header, sizeof(header));
+
+    capture->used = sizeof(header);
+    capture->limit = limit;
+    capture->sample_rate = sample_rate;
+    capture->base = sl_capture_clock(CLOCK_MONOTONIC);
+
+    return 0;
+}
+
+static bool sl_capture_full(sl_capture *capture, size_t length)
+{
+    return capture->limit > 0 && capture->written + capture->used + length > capture->limit;
+}
+
+static void sl_capture_append(sl_capture *capture, sl_capture_record *record, uint8_t *payload, size_t length)
+{
+    size_t size = sizeof(sl_capture_record) + length;
+
+    if (size > SL_CAPTURE_BUFFER_SIZE) {
+        capture->dropped ++;
+        return;
+    }
+
+    if (size > SL_CAPTURE_BUFFER_SIZE - capture->used && sl_capture_flush(capture) == -1) {
+        capture->dropped ++;
+        return;
+    }
+
+    record->length = length;
+    record->timestamp = sl_capture_clock(CLOCK_MONOTONIC) - capture->base;
+
+    memcpy(capture->buffer + capture->used, record, sizeof(sl_capture_record));
+
+    if (length > 0) {
+        memcpy(capture->buffer + capture->used + sizeof(sl_capture_record), payload, length);
+    }
+
+    capture->used += size;
+    capture->records ++;
+    capture->bytes += length;
+}
+
+uint32_t sl_capture_accept(sl_capture *capture, struct sockaddr_in *address)
+{
+    if (capture->sample_rate == 0 || ++ capture->sample_counter < capture->sample_rate) {
+        return 0;
+    }
+
+    capture->sample_counter = 0;
+
+    if (capture->truncated == true) {
+        return 0;
+    }
+
+    if (sl_capture_full(capture, sizeof(sl_capture_record)) == true) {
+        sl_capture_record marker = {
+            .type = SL_CAPTURE_RECORD_TRUNCATED
+        };
+
+        sl_capture_append(capture, &marker, NULL, 0);
+        capture->truncated = true;
+
+        return 0;
+    }
+
+    sl_capture_record record = {
+        .type = SL_CAPTURE_RECORD_OPEN,
+        .port = ntohs(address->sin_port),
+        .connection = ++ capture->next_connection,
+        .address = ntohl(address->sin_addr.s_addr)
+    };
+
+    sl_capture_append(capture, &record, NULL, 0);
+    capture->connections ++;
+
+    return record.connection;
+}
+
+inline void sl_capture_recv(sl_capture *capture, uint32_t connection, uint8_t *buffer, size_t length)
+{
+    sl_capture_record record = {
+        .type = SL_CAPTURE_RECORD_DATA,
+        .connection = connection
+    };
+
+    sl_capture_append(capture, &record, buffer, length);
+}
+
+void sl_capture_close(sl_capture *capture, uint32_t connection)
+{
+    sl_capture_record record = {
+        .type = SL_CAPTURE_RECORD_CLOSE,
+        .connection = connection
+    };
+
+    sl_capture_append(capture, &record, NULL, 0);
+}
+
+int sl_capture_flush(sl_capture *capture)
+{
+    size_t offset = 0;
+
+    while (offset < capture->used) {
+        ssize_t written = write(capture->fd, capture->buffer + offset, capture->used - offset);
+        if (written == -1 && errno == EINTR) {
+            continue;
+        } else if (written == -1) {
+            capture->used = 0;
+            return -1;
+        }
+
+        offset += written;
+    }
+
+    capture->written += capture->used;
+    capture->used = 0;
+
+    return 0;
+}
+
+void sl_capture_destroy(sl_capture *capture)
+{
+    sl_capture_flush(capture);
+    close(capture->fd);
+
+    free(capture->buffer);
+    capture->buffer = NULL;
+    capture->sample_rate = 0;
+}
@@ -0,0 +1,70 @@
+#ifndef SL_CAPTURE_H
+#define SL_CAPTURE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <netinet/in.h>
+
+#define SL_CAPTURE_MAGIC       "SLCAPTR1"
+#define SL_CAPTURE_MAGIC_SIZE  8
+#define SL_CAPTURE_VERSION     1
+#define SL_CAPTURE_BUFFER_SIZE (256 * 1024)
+
+typedef enum sl_capture_record_type sl_capture_record_type;
+
+typedef struct sl_capture_header sl_capture_header;
+typedef struct sl_capture_record sl_capture_record;
+typedef struct sl_capture sl_capture;
+
+enum sl_capture_record_type {
+    SL_CAPTURE_RECORD_OPEN,
+    SL_CAPTURE_RECORD_DATA,
+    SL_CAPTURE_RECORD_CLOSE,
+    SL_CAPTURE_RECORD_TRUNCATED
+};
+
+struct sl_capture_header {
+    char magic[SL_CAPTURE_MAGIC_SIZE];
+    uint32_t version;
+    uint32_t sample_rate;
+    uint64_t started;
+    uint32_t pid;
+    uint32_t reserved;
+};
+
+struct sl_capture_record {
+    uint32_t length;
+    uint8_t type;
+    uint8_t reserved;
+    uint16_t port;
+    uint32_t connection;
+    uint32_t address;
+    uint64_t timestamp;
+};
+
+struct sl_capture {
+    int fd;
+    char *buffer;
+    size_t used;
+    size_t written;
+    size_t limit;
+    size_t sample_rate;
+    size_t sample_counter;
+    uint32_t next_connection;
+    uint64_t base;
+    bool truncated;
+    size_t connections;
+    size_t records;
+    size_t bytes;
+    size_t dropped;
+};
+
+int sl_capture_open(sl_capture *capture, char *path, size_t sample_rate, size_t limit);
+uint32_t sl_capture_accept(sl_capture *capture, struct sockaddr_in *address);
+void sl_capture_recv(sl_capture *capture, uint32_t connection, uint8_t *buffer, size_t length);
+void sl_capture_close(sl_capture *capture, uint32_t connection);
+int sl_capture_flush(sl_capture *capture);
+void sl_capture_destroy(sl_capture *capture);
+
+#endif
@@ -0,0 +1,202 @@
+#include "sl_compress.h"
+
+#include <string.h>
+#include <strings.h>
+
+#define SL_COMPRESS_MEMORY_LEVEL 8
+#define SL_COMPRESS_WINDOW_BITS  15
+#define SL_COMPRESS_GZIP_BITS    16
+
+static sl_string sl_compress_encoding_headers[SL_COMPRESS_ENCODINGS] = {
+    [SL_COMPRESS_ENCODING_DEFLATE] = {sizeof("Content-Encoding: deflate\r\n") - 1, sizeof("Content-Encoding: deflate\r\n") - 1, "Content-Encoding: deflate\r\n"},
+    [SL_COMPRESS_ENCODING_GZIP] = {sizeof("Content-Encoding: gzip\r\n") - 1, sizeof("Content-Encoding: gzip\r\n") - 1, "Content-Encoding: gzip\r\n"}
+};
+
+static sl_string sl_compress_vary_header = {sizeof("Vary: Accept-Encoding\r\n") - 1, sizeof("Vary: Accept-Encoding\r\n") - 1, "Vary: Accept-Encoding\r\n"};
+
+void sl_compress_init(sl_compress *compress, int level, size_t min_size)
+{
+    *compress = (sl_compress) {0};
+
+    compress->level = level;
+    compress->min_size = min_size;
+}
+
+void sl_compress_destroy(sl_compress *compress)
+{
+    for (int n = 0; n < SL_COMPRESS_ENCODINGS; n ++) {
+        if (compress->initialized[n] == true) {
+            deflateEnd(&compress->streams[n]);
+        }
+    }
+
+    sl_compress_init(compress, compress->level, compress->min_size);
+}
+
+static bool sl_compress_parse_quality(char *buffer, char *end)
+{
+    if (buffer == end || *buffer != '0') {
+        return true;
+    }
+
+    for (buffer ++; buffer < end && *buffer != ',' && *buffer != ';' && *buffer != ' '; buffer ++) {
+        if (*buffer != '.' && *buffer != '0') {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+sl_compress_encoding sl_compress_negotiate(sl_string *accept_encoding)
+{
+    int accepted[SL_COMPRESS_ENCODINGS] = {0};
+    int wildcard = 0;
+
+    if (accept_encoding == NULL) {
+        return SL_COMPRESS_ENCODING_IDENTITY;
+    }
+
+    char *buffer = accept_encoding->buffer, *end = buffer + accept_encoding->length;
+
+    while (buffer < end) {
+        while (buffer < end && (*buffer == ' ' || *buffer == '\t' || *buffer == ',')) {
+            buffer ++;
+        }
+
+        char *token = buffer;
+
+        while (buffer < end && *buffer != ',' && *buffer != ';' && *buffer != ' ' && *buffer != '\t') {
+            buffer ++;
+        }
+
+        size_t token_length = buffer - token;
+        int acceptable = 1;
+
+        while (buffer < end && *buffer != ',') {
+            if ((*buffer == 'q' || *buffer == 'Q') && buffer + 1 < end && buffer[1] == '=') {
+                acceptable = sl_compress_parse_quality(buffer + 2, end) == true ? 1 : -1;
+            }
+
+            buffer ++;
+        }
+
+        if (token_length == 1 && *token == '*') {
+            wildcard = acceptable;
+        } else if ((token_length == 4 && strncasecmp(token, "gzip", 4) == 0) || (token_length == 6 && strncasecmp(token, "x-gzip", 6) == 0)) {
+            accepted[SL_COMPRESS_ENCODING_GZIP] = acceptable;
+        } else if (token_length == 7 && strncasecmp(token, "deflate", 7) == 0) {
+            accepted[SL_COMPRESS_ENCODING_DEFLATE] = acceptable;
+        }
+    }
+
+    for (int n = SL_COMPRESS_ENCODINGS - 1; n > SL_COMPRESS_ENCODING_IDENTITY; n --) {
+        if (accepted[n] == 1 || (accepted[n] == 0 && wildcard == 1)) {
+            return n;
+        }
+    }
+
+    return SL_COMPRESS_ENCODING_IDENTITY;
+}
+
+static z_stream *sl_compress_get_stream(sl_compress *compress, sl_compress_encoding encoding)
+{
+    z_stream *stream = &compress->streams[encoding];
+
+    if (compress->initialized[encoding] == true) {
+        return deflateReset(stream) == Z_OK ? stream : NULL;
+    }
+
+    int window_bits = encoding == SL_COMPRESS_ENCODING_GZIP ? SL_COMPRESS_WINDOW_BITS + SL_COMPRESS_GZIP_BITS : SL_COMPRESS_WINDOW_BITS;
+
+    *stream = (z_stream) {0};
+
+    if (deflateInit2(stream, compress->level, Z_DEFLATED, window_bits, SL_COMPRESS_MEMORY_LEVEL, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return NULL;
+    }
+
+    compress->initialized[encoding] = true;
+
+    return stream;
+}
+
+static int sl_compress_next_chunk(sl_rope *output, z_stream *stream, uint8_t **chunk)
+{
+    if (*chunk != NULL && sl_rope_commit(output, SL_COMPRESS_CHUNK_SIZE - stream->avail_out) == -1) {
+        return -1;
+    }
+
+    *chunk = sl_rope_reserve(output, SL_COMPRESS_CHUNK_SIZE);
+    if (*chunk == NULL) {
+        return -1;
+    }
+
+    stream->next_out = *chunk;
+    stream->avail_out = SL_COMPRESS_CHUNK_SIZE;
+
+    return 0;
+}
+
+int sl_compress_response(sl_compress *compress, sl_fcgi_response *response, sl_compress_encoding encoding)
+{
+    if (encoding == SL_COMPRESS_ENCODING_IDENTITY || compress->level == 0 || response->output.count == 0 || response->output.length < compress->min_size) {
+        return 0;
+    }
+
+    z_stream *stream = sl_compress_get_stream(compress, encoding);
+    if (stream == NULL) {
+        return -1;
+    }
+
+    sl_rope input = response->output, *output = &response->output;
+    uint8_t *chunk = NULL;
+
+    sl_rope_init(output, response->arena);
+
+    output->mappings = input.mappings;
+
+    if (sl_compress_next_chunk(output, stream, &chunk) == -1) {
+        return -1;
+    }
+
+    for (size_t n = 0; n < input.count; n ++) {
+        int flush = n + 1 == input.count ? Z_FINISH : Z_NO_FLUSH, result;
+
+        stream->next_in = input.segments[n].iov_base;
+        stream->avail_in = input.segments[n].iov_len;
+
+        do {
+            if (stream->avail_out == 0 && sl_compress_next_chunk(output, stream, &chunk) == -1) {
+                return -1;
+            }
+
+            result = deflate(stream, flush);
+            if (result == Z_STREAM_ERROR) {
+                return -1;
+            }
+        } while (stream->avail_in > 0 || stream->avail_out == 0 || (flush == Z_FINISH && result != Z_STREAM_END));
+    }
+
+    if (sl_rope_commit(output, SL_COMPRESS_CHUNK_SIZE - stream->avail_out) == -1) {
+        return -1;
+    }
+
+    if (output->length >= input.length) {
+        response->output = input;
+
+        compress->skipped ++;
+
+        return 0;
+    }
+
+    if (sl_fcgi_response_append_header_line(response, &sl_compress_encoding_headers[encoding]) == -1 ||
+        sl_fcgi_response_append_header_line(response, &sl_compress_vary_header) == -1) {
+        return -1;
+    }
+
+    compress->responses ++;
+    compress->bytes_in += input.length;
+    compress->bytes_out += output->length;
+
+    return 1;
+}
@@ -0,0 +1,42 @@
+#ifndef SL_COMPRESS_H
+#define SL_COMPRESS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <zlib.h>
+
+#include "sl_string.h"
+#include "sl_fcgi.h"
+
+#define SL_COMPRESS_CHUNK_SIZE       16384
+#define SL_COMPRESS_DEFAULT_LEVEL    6
+#define SL_COMPRESS_DEFAULT_MIN_SIZE 256
+
+typedef enum sl_compress_encoding sl_compress_encoding;
+
+typedef struct sl_compress sl_compress;
+
+enum sl_compress_encoding {
+    SL_COMPRESS_ENCODING_IDENTITY,
+    SL_COMPRESS_ENCODING_DEFLATE,
+    SL_COMPRESS_ENCODING_GZIP,
+    SL_COMPRESS_ENCODINGS
+};
+
+struct sl_compress {
+    int level;
+    size_t min_size;
+    bool initialized[SL_COMPRESS_ENCODINGS];
+    z_stream streams[SL_COMPRESS_ENCODINGS];
+    size_t responses;
+    size_t skipped;
+    size_t bytes_in;
+    size_t bytes_out;
+};
+
+void sl_compress_init(sl_compress *compress, int level, size_t min_size);
+void sl_compress_destroy(sl_compress *compress);
+sl_compress_encoding sl_compress_negotiate(sl_string *accept_encoding);
+int sl_compress_response(sl_compress *compress, sl_fcgi_response *response, sl_compress_encoding encoding);
+
+#endif
@@ -0,0 +1,43 @@
+#include "sl_cpu.h"
+
+static sl_cpu_level sl_cpu_level_detected = SL_CPU_MAX;
+static sl_cpu_level sl_cpu_level_current = SL_CPU_MAX;
+
+sl_cpu_level sl_cpu_detect(void)
+{
+    if (sl_cpu_level_detected != SL_CPU_MAX) {
+        return sl_cpu_level_detected;
+    }
+
+    sl_cpu_level_detected = SL_CPU_SCALAR;
+
+#ifdef SL_CPU_X86
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("sse2")) {
+        sl_cpu_level_detected = SL_CPU_SSE2;
+    }
+
+    if (__builtin_cpu_supports("avx2")) {
+        sl_cpu_level_detected = SL_CPU_AVX2;
+    }
+#endif
+
+    return sl_cpu_level_detected;
+}
+
+sl_cpu_level sl_cpu_get_level(void)
+{
+    if (sl_cpu_level_current == SL_CPU_MAX) {
+        sl_cpu_level_current = sl_cpu_detect();
+    }
+
+    return sl_cpu_level_current;
+}
+
+void sl_cpu_set_level(sl_cpu_level level)
+{
+    sl_cpu_level detected = sl_cpu_detect();
+
+    sl_cpu_level_current = level < detected ? level : detected;
+}
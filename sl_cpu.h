@@ -0,0 +1,21 @@
+#ifndef SL_CPU_H
+#define SL_CPU_H
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SL_CPU_X86 1
+#endif
+
+typedef enum sl_cpu_level sl_cpu_level;
+
+enum sl_cpu_level {
+    SL_CPU_SCALAR,
+    SL_CPU_SSE2,
+    SL_CPU_AVX2,
+    SL_CPU_MAX
+};
+
+sl_cpu_level sl_cpu_detect(void);
+sl_cpu_level sl_cpu_get_level(void);
+void sl_cpu_set_level(sl_cpu_level level);
+
+#endif
@@ -0,0 +1,576 @@
+#include "sl_encode.h"
+#include "sl_cpu.h"
+
+#include <string.h>
+
+#ifdef SL_CPU_X86
+#include <immintrin.h>
+#endif
+
+#define SL_ENCODE_ENTITY(entity) {sizeof(entity) - 1, sizeof(entity) - 1, entity "\0\0\0"}
+
+#define SL_ENCODE_ENTITY_MAX_LENGTH 8
+
+#define SL_ENCODE_UTF8_INVALID SIZE_MAX
+
+#define SL_ENCODE_UTF8_TOO_SHORT      (1 << 0)
+#define SL_ENCODE_UTF8_TOO_LONG       (1 << 1)
+#define SL_ENCODE_UTF8_OVERLONG_3     (1 << 2)
+#define SL_ENCODE_UTF8_TOO_LARGE      (1 << 3)
+#define SL_ENCODE_UTF8_SURROGATE      (1 << 4)
+#define SL_ENCODE_UTF8_OVERLONG_2     (1 << 5)
+#define SL_ENCODE_UTF8_TOO_LARGE_1000 (1 << 6)
+#define SL_ENCODE_UTF8_OVERLONG_4     (1 << 6)
+#define SL_ENCODE_UTF8_TWO_CONTS      (1 << 7)
+#define SL_ENCODE_UTF8_CARRY          (SL_ENCODE_UTF8_TOO_SHORT | SL_ENCODE_UTF8_TOO_LONG | SL_ENCODE_UTF8_TWO_CONTS)
+
+static sl_string sl_encode_entities[SL_ENCODE_CONTEXTS][256] = {
+    [SL_ENCODE_CONTEXT_HTML] = {
+        ['&'] = SL_ENCODE_ENTITY("&amp;"),
+        ['<'] = SL_ENCODE_ENTITY("&lt;"),
+        ['>'] = SL_ENCODE_ENTITY("&gt;"),
+        ['"'] = SL_ENCODE_ENTITY("&quot;"),
+        ['\''] = SL_ENCODE_ENTITY("&#39;")
+    },
+    [SL_ENCODE_CONTEXT_ATTRIBUTE] = {
+        ['&'] = SL_ENCODE_ENTITY("&amp;"),
+        ['<'] = SL_ENCODE_ENTITY("&lt;"),
+        ['>'] = SL_ENCODE_ENTITY("&gt;"),
+        ['"'] = SL_ENCODE_ENTITY("&quot;"),
+        ['\''] = SL_ENCODE_ENTITY("&#39;"),
+        ['`'] = SL_ENCODE_ENTITY("&#96;"),
+        ['='] = SL_ENCODE_ENTITY("&#61;")
+    }
+};
+
+static size_t sl_encode_html_find_scalar(char *buffer, size_t length, sl_encode_context context)
+{
+    sl_string *entities = sl_encode_entities[context];
+
+    for (size_t n = 0; n < length; n ++) {
+        if (entities[(uint8_t) buffer[n]].length != 0) {
+            return n;
+        }
+    }
+
+    return length;
+}
+
+static size_t sl_encode_html_window_scalar(char *buffer, size_t length, size_t *position, char *output, size_t available, sl_encode_context context)
+{
+    sl_string *entities = sl_encode_entities[context];
+    size_t n = *position, written = 0;
+
+    for (; n < length && available - written >= SL_ENCODE_ENTITY_MAX_LENGTH; n ++) {
+        sl_string *entity = &entities[(uint8_t) buffer[n]];
+
+        if (entity->length == 0) {
+            output[written ++] = buffer[n];
+        } else {
+            memcpy(output + written, entity->buffer, SL_ENCODE_ENTITY_MAX_LENGTH);
+            written += entity->length;
+        }
+    }
+
+    *position = n;
+
+    return written;
+}
+
+static size_t sl_encode_utf8_sequence(uint8_t *buffer, size_t length, size_t n)
+{
+    uint8_t c = buffer[n], low = 0x80, high = 0xbf;
+    size_t continuations;
+
+    if (c < 0x80) {
+        return n + 1;
+    } else if (c >= 0xc2 && c <= 0xdf) {
+        continuations = 1;
+    } else if (c == 0xe0) {
+        continuations = 2;
+        low = 0xa0;
+    } else if (c == 0xed) {
+        continuations = 2;
+        high = 0x9f;
+    } else if (c >= 0xe1 && c <= 0xef) {
+        continuations = 2;
+    } else if (c == 0xf0) {
+        continuations = 3;
+        low = 0x90;
+    } else if (c == 0xf4) {
+        continuations = 3;
+        high = 0x8f;
+    } else if (c >= 0xf1 && c <= 0xf3) {
+        continuations = 3;
+    } else {
+        return SL_ENCODE_UTF8_INVALID;
+    }
+
+    if (length - n - 1 < continuations || buffer[n + 1] < low || buffer[n + 1] > high) {
+        return SL_ENCODE_UTF8_INVALID;
+    }
+
+    for (size_t k = 2; k <= continuations; k ++) {
+        if ((buffer[n + k] & 0xc0) != 0x80) {
+            return SL_ENCODE_UTF8_INVALID;
+        }
+    }
+
+    return n + continuations + 1;
+}
+
+static bool sl_encode_utf8_is_valid_scalar(char *buffer, size_t length)
+{
+    uint8_t *data = (uint8_t *) buffer;
+    size_t n = 0;
+
+    while (n < length) {
+        if (n + 8 <= length) {
+            uint64_t chunk;
+
+            memcpy(&chunk, data + n, sizeof(chunk));
+
+            if ((chunk & 0x8080808080808080) == 0) {
+                n += 8;
+                continue;
+            }
+        }
+
+        n = sl_encode_utf8_sequence(data, length, n);
+        if (n == SL_ENCODE_UTF8_INVALID) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+#ifdef SL_CPU_X86
+__attribute__((target("sse2")))
+static inline int sl_encode_html_mask_sse2(__m128i chunk, sl_encode_context context)
+{
+    __m128i backticks = _mm_set1_epi8(context == SL_ENCODE_CONTEXT_ATTRIBUTE ? '`' : '&');
+    __m128i equals = _mm_set1_epi8(context == SL_ENCODE_CONTEXT_ATTRIBUTE ? '=' : '&');
+
+    __m128i matches = _mm_or_si128(
+        _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('&')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('<'))),
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('>')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('"')))),
+        _mm_or_si128(
+            _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\'')),
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, backticks), _mm_cmpeq_epi8(chunk, equals))));
+
+    return _mm_movemask_epi8(matches);
+}
+
+__attribute__((target("sse2")))
+static size_t sl_encode_html_find_sse2(char *buffer, size_t length, sl_encode_context context)
+{
+    size_t n = 0;
+
+    for (; n + 16 <= length; n += 16) {
+        int mask = sl_encode_html_mask_sse2(_mm_loadu_si128((__m128i *) (buffer + n)), context);
+        if (mask != 0) {
+            return n + __builtin_ctz(mask);
+        }
+    }
+
+    return n + sl_encode_html_find_scalar(buffer + n, length - n, context);
+}
+
+__attribute__((target("sse2")))
+static size_t sl_encode_html_window_sse2(char *buffer, size_t length, size_t *position, char *output, size_t available, sl_encode_context context)
+{
+    sl_string *entities = sl_encode_entities[context];
+    size_t n = *position, written = 0;
+
+    while (n + 16 <= length && available - written >= 16 * SL_ENCODE_ENTITY_MAX_LENGTH) {
+        __m128i chunk = _mm_loadu_si128((__m128i *) (buffer + n));
+        int mask = sl_encode_html_mask_sse2(chunk, context);
+
+        if (mask == 0) {
+            _mm_storeu_si128((__m128i *) (output + written), chunk);
+            written += 16;
+            n += 16;
+            continue;
+        }
+
+        size_t start = 0;
+
+        while (mask != 0) {
+            size_t offset = __builtin_ctz(mask);
+            sl_string *entity = &entities[(uint8_t) buffer[n + offset]];
+
+            memcpy(output + written, buffer + n + start, offset - start);
+            written += offset - start;
+
+            memcpy(output + written, entity->buffer, SL_ENCODE_ENTITY_MAX_LENGTH);
+            written += entity->length;
+
+            start = offset + 1;
+            mask &= mask - 1;
+        }
+
+        memcpy(output + written, buffer + n + start, 16 - start);
+        written += 16 - start;
+        n += 16;
+    }
+
+    *position = n;
+
+    return written + sl_encode_html_window_scalar(buffer, length, position, output + written, available - written, context);
+}
+
+__attribute__((target("sse2")))
+static bool sl_encode_utf8_is_valid_sse2(char *buffer, size_t length)
+{
+    uint8_t *data = (uint8_t *) buffer;
+    size_t n = 0;
+
+    while (n + 16 <= length) {
+        __m128i chunk = _mm_loadu_si128((__m128i *) (data + n));
+
+        if (_mm_movemask_epi8(chunk) == 0) {
+            n += 16;
+            continue;
+        }
+
+        for (size_t end = n + 16; n < end; ) {
+            n = sl_encode_utf8_sequence(data, length, n);
+            if (n == SL_ENCODE_UTF8_INVALID) {
+                return false;
+            }
+        }
+    }
+
+    return sl_encode_utf8_is_valid_scalar(buffer + n, length - n);
+}
+
+__attribute__((target("avx2")))
+static inline uint32_t sl_encode_html_mask_avx2(__m256i chunk, sl_encode_context context)
+{
+    __m256i backticks = _mm256_set1_epi8(context == SL_ENCODE_CONTEXT_ATTRIBUTE ? '`' : '&');
+    __m256i equals = _mm256_set1_epi8(context == SL_ENCODE_CONTEXT_ATTRIBUTE ? '=' : '&');
+
+    __m256i matches = _mm256_or_si256(
+        _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('&')), _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('<'))),
+            _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('>')), _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('"')))),
+        _mm256_or_si256(
+            _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\'')),
+            _mm256_or_si256(_mm256_cmpeq_epi8(chunk, backticks), _mm256_cmpeq_epi8(chunk, equals))));
+
+    return (uint32_t) _mm256_movemask_epi8(matches);
+}
+
+__attribute__((target("avx2")))
+static inline int sl_encode_html_mask_avx2_half(__m128i chunk, sl_encode_context context)
+{
+    __m128i backticks = _mm_set1_epi8(context == SL_ENCODE_CONTEXT_ATTRIBUTE ? '`' : '&');
+    __m128i equals = _mm_set1_epi8(context == SL_ENCODE_CONTEXT_ATTRIBUTE ? '=' : '&');
+
+    __m128i matches = _mm_or_si128(
+        _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('&')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('<'))),
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('>')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('"')))),
+        _mm_or_si128(
+            _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\'')),
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, backticks), _mm_cmpeq_epi8(chunk, equals))));
+
+    return _mm_movemask_epi8(matches);
+}
+
+__attribute__((target("avx2")))
+static size_t sl_encode_html_find_avx2(char *buffer, size_t length, sl_encode_context context)
+{
+    size_t n = 0;
+
+    for (; n + 32 <= length; n += 32) {
+        uint32_t mask = sl_encode_html_mask_avx2(_mm256_loadu_si256((__m256i *) (buffer + n)), context);
+        if (mask != 0) {
+            return n + __builtin_ctz(mask);
+        }
+    }
+
+    if (n + 16 <= length) {
+        int mask = sl_encode_html_mask_avx2_half(_mm_loadu_si128((__m128i *) (buffer + n)), context);
+        if (mask != 0) {
+            return n + __builtin_ctz(mask);
+        }
+
+        n += 16;
+    }
+
+    return n + sl_encode_html_find_scalar(buffer + n, length - n, context);
+}
+
+__attribute__((target("avx2")))
+static size_t sl_encode_html_window_avx2(char *buffer, size_t length, size_t *position, char *output, size_t available, sl_encode_context context)
+{
+    sl_string *entities = sl_encode_entities[context];
+    size_t n = *position, written = 0;
+
+    while (n + 32 <= length && available - written >= 32 * SL_ENCODE_ENTITY_MAX_LENGTH) {
+        __m256i chunk = _mm256_loadu_si256((__m256i *) (buffer + n));
+        uint32_t mask = sl_encode_html_mask_avx2(chunk, context);
+
+        if (mask == 0) {
+            _mm256_storeu_si256((__m256i *) (output + written), chunk);
+            written += 32;
+            n += 32;
+            continue;
+        }
+
+        size_t start = 0;
+
+        while (mask != 0) {
+            size_t offset = __builtin_ctz(mask);
+            sl_string *entity = &entities[(uint8_t) buffer[n + offset]];
+
+            memcpy(output + written, buffer + n + start, offset - start);
+            written += offset - start;
+
+            memcpy(output + written, entity->buffer, SL_ENCODE_ENTITY_MAX_LENGTH);
+            written += entity->length;
+
+            start = offset + 1;
+            mask &= mask - 1;
+        }
+
+        memcpy(output + written, buffer + n + start, 32 - start);
+        written += 32 - start;
+        n += 32;
+    }
+
+    *position = n;
+
+    _mm256_zeroupper();
+
+    return written + sl_encode_html_window_scalar(buffer, length, position, output + written, available - written, context);
+}
+
+#define SL_ENCODE_UTF8_PREVIOUS(input, previous, n) \
+    _mm256_alignr_epi8(input, _mm256_permute2x128_si256(previous, input, 0x21), 16 - (n))
+
+#define SL_ENCODE_UTF8_TABLE(...) _mm256_setr_epi8(__VA_ARGS__, __VA_ARGS__)
+
+__attribute__((target("avx2")))
+static inline __m256i sl_encode_utf8_errors_avx2(__m256i input, __m256i previous)
+{
+    __m256i nibble = _mm256_set1_epi8(0x0f);
+    __m256i previous_1 = SL_ENCODE_UTF8_PREVIOUS(input, previous, 1);
+
+    __m256i byte_1_high = _mm256_shuffle_epi8(SL_ENCODE_UTF8_TABLE(
+        SL_ENCODE_UTF8_TOO_LONG, SL_ENCODE_UTF8_TOO_LONG, SL_ENCODE_UTF8_TOO_LONG, SL_ENCODE_UTF8_TOO_LONG,
+        SL_ENCODE_UTF8_TOO_LONG, SL_ENCODE_UTF8_TOO_LONG, SL_ENCODE_UTF8_TOO_LONG, SL_ENCODE_UTF8_TOO_LONG,
+        (char) SL_ENCODE_UTF8_TWO_CONTS, (char) SL_ENCODE_UTF8_TWO_CONTS, (char) SL_ENCODE_UTF8_TWO_CONTS, (char) SL_ENCODE_UTF8_TWO_CONTS,
+        SL_ENCODE_UTF8_TOO_SHORT | SL_ENCODE_UTF8_OVERLONG_2,
+        SL_ENCODE_UTF8_TOO_SHORT,
+        SL_ENCODE_UTF8_TOO_SHORT | SL_ENCODE_UTF8_OVERLONG_3 | SL_ENCODE_UTF8_SURROGATE,
+        SL_ENCODE_UTF8_TOO_SHORT | SL_ENCODE_UTF8_TOO_LARGE | SL_ENCODE_UTF8_TOO_LARGE_1000 | SL_ENCODE_UTF8_OVERLONG_4),
+        _mm256_and_si256(_mm256_srli_epi16(previous_1, 4), nibble));
+
+    __m256i byte_1_low = _mm256_shuffle_epi8(SL_ENCODE_UTF8_TABLE(
+        (char) (SL_ENCODE_UTF8_CARRY | SL_ENCODE_UTF8_OVERLONG_3 | SL_ENCODE_UTF8_OVERLONG_2 | SL_ENCODE_UTF8_OVERLONG_4),
+        (char) (SL_ENCODE_UTF8_CARRY | SL_ENCODE_UTF8_OVERLONG_2),
+        (char) SL_ENCODE_UTF8_CARRY,
+        (char) SL_ENCODE_UTF8_CARRY,
+        (char) (SL_ENCODE_UTF8_CARRY | SL_ENCODE_UTF8_TOO_LARGE),
+        (char) (SL_ENCODE_UTF8_CARRY | SL_ENCODE_UTF8_TOO_LARGE | SL_ENCODE_UTF8_TOO_LARGE_1000),
+        (char) (SL_ENCODE_UTF8_CARRY | SL_ENCODE_UTF8_TOO_LARGE | SL_ENCODE_UTF8_TOO_LARGE_1000),
+        (char) (SL_ENCODE_UTF8_CARRY | SL_ENCODE_UTF8_TOO_LARGE | SL_ENCODE_UTF8_TOO_LARGE_1000),
+        (char) (SL_ENCODE_UTF8_CARRY | SL_ENCODE_UTF8_TOO_LARGE | SL_ENCODE_UTF8_TOO_LARGE_1000),
+        (char) (SL_ENCODE_UTF8_CARRY | SL_ENCODE_UTF8_TOO_LARGE | SL_ENCODE_UTF8_TOO_LARGE_1000),
+        (char) (SL_ENCODE_UTF8_CARRY | SL_ENCODE_UTF8_TOO_LARGE | SL_ENCODE_UTF8_TOO_LARGE_1000),
+        (char) (SL_ENCODE_UTF8_CARRY | SL_ENCODE_UTF8_TOO_LARGE | SL_ENCODE_UTF8_TOO_LARGE_1000),
+        (char) (SL_ENCODE_UTF8_CARRY | SL_ENCODE_UTF8_TOO_LARGE | SL_ENCODE_UTF8_TOO_LARGE_1000),
+        (char) (SL_ENCODE_UTF8_CARRY | SL_ENCODE_UTF8_TOO_LARGE | SL_ENCODE_UTF8_TOO_LARGE_1000 | SL_ENCODE_UTF8_SURROGATE),
+        (char) (SL_ENCODE_UTF8_CARRY | SL_ENCODE_UTF8_TOO_LARGE | SL_ENCODE_UTF8_TOO_LARGE_1000),
+        (char) (SL_ENCODE_UTF8_CARRY | SL_ENCODE_UTF8_TOO_LARGE | SL_ENCODE_UTF8_TOO_LARGE_1000)),
+        _mm256_and_si256(previous_1, nibble));
+
+    __m256i byte_2_high = _mm256_shuffle_epi8(SL_ENCODE_UTF8_TABLE(
+        SL_ENCODE_UTF8_TOO_SHORT, SL_ENCODE_UTF8_TOO_SHORT, SL_ENCODE_UTF8_TOO_SHORT, SL_ENCODE_UTF8_TOO_SHORT,
+        SL_ENCODE_UTF8_TOO_SHORT, SL_ENCODE_UTF8_TOO_SHORT, SL_ENCODE_UTF8_TOO_SHORT, SL_ENCODE_UTF8_TOO_SHORT,
+        (char) (SL_ENCODE_UTF8_TOO_LONG | SL_ENCODE_UTF8_OVERLONG_2 | SL_ENCODE_UTF8_TWO_CONTS | SL_ENCODE_UTF8_OVERLONG_3 | SL_ENCODE_UTF8_TOO_LARGE_1000 | SL_ENCODE_UTF8_OVERLONG_4),
+        (char) (SL_ENCODE_UTF8_TOO_LONG | SL_ENCODE_UTF8_OVERLONG_2 | SL_ENCODE_UTF8_TWO_CONTS | SL_ENCODE_UTF8_OVERLONG_3 | SL_ENCODE_UTF8_TOO_LARGE),
+        (char) (SL_ENCODE_UTF8_TOO_LONG | SL_ENCODE_UTF8_OVERLONG_2 | SL_ENCODE_UTF8_TWO_CONTS | SL_ENCODE_UTF8_SURROGATE | SL_ENCODE_UTF8_TOO_LARGE),
+        (char) (SL_ENCODE_UTF8_TOO_LONG | SL_ENCODE_UTF8_OVERLONG_2 | SL_ENCODE_UTF8_TWO_CONTS | SL_ENCODE_UTF8_SURROGATE | SL_ENCODE_UTF8_TOO_LARGE),
+        SL_ENCODE_UTF8_TOO_SHORT, SL_ENCODE_UTF8_TOO_SHORT, SL_ENCODE_UTF8_TOO_SHORT, SL_ENCODE_UTF8_TOO_SHORT),
+        _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble));
+
+    __m256i special_cases = _mm256_and_si256(_mm256_and_si256(byte_1_high, byte_1_low), byte_2_high);
+
+    __m256i third = _mm256_subs_epu8(SL_ENCODE_UTF8_PREVIOUS(input, previous, 2), _mm256_set1_epi8(0xe0 - 0x80));
+    __m256i fourth = _mm256_subs_epu8(SL_ENCODE_UTF8_PREVIOUS(input, previous, 3), _mm256_set1_epi8(0xf0 - 0x80));
+    __m256i continuations = _mm256_and_si256(_mm256_or_si256(third, fourth), _mm256_set1_epi8((char) 0x80));
+
+    return _mm256_xor_si256(continuations, special_cases);
+}
+
+__attribute__((target("avx2")))
+static bool sl_encode_utf8_is_valid_avx2(char *buffer, size_t length)
+{
+    __m256i limits = _mm256_setr_epi8(
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, (char) 0xef, (char) 0xdf, (char) 0xbf);
+    __m256i previous = _mm256_setzero_si256();
+    __m256i incomplete = _mm256_setzero_si256();
+    __m256i errors = _mm256_setzero_si256();
+    uint8_t tail[32] = {0};
+    size_t n = 0;
+
+    while (n < length) {
+        __m256i input;
+
+        if (n + 32 <= length) {
+            input = _mm256_loadu_si256((__m256i *) (buffer + n));
+        } else {
+            memcpy(tail, buffer + n, length - n);
+            input = _mm256_loadu_si256((__m256i *) tail);
+        }
+
+        if (_mm256_movemask_epi8(input) == 0) {
+            errors = _mm256_or_si256(errors, incomplete);
+            incomplete = _mm256_setzero_si256();
+        } else {
+            errors = _mm256_or_si256(errors, sl_encode_utf8_errors_avx2(input, previous));
+            incomplete = _mm256_subs_epu8(input, limits);
+        }
+
+        previous = input;
+        n += 32;
+
+        if ((n & 1023) == 0 && _mm256_testz_si256(errors, errors) == 0) {
+            return false;
+        }
+    }
+
+    errors = _mm256_or_si256(errors, incomplete);
+
+    return _mm256_testz_si256(errors, errors) != 0;
+}
+#endif
+
+size_t sl_encode_html_find(char *buffer, size_t length, sl_encode_context context)
+{
+    switch (sl_cpu_get_level()) {
+#ifdef SL_CPU_X86
+        case SL_CPU_AVX2:
+            return sl_encode_html_find_avx2(buffer, length, context);
+        case SL_CPU_SSE2:
+            return sl_encode_html_find_sse2(buffer, length, context);
+#endif
+        default:
+            return sl_encode_html_find_scalar(buffer, length, context);
+    }
+}
+
+size_t sl_encode_html_length(char *buffer, size_t length, sl_encode_context context)
+{
+    size_t position = 0, escaped = 0;
+
+    while (position < length) {
+        size_t clean = sl_encode_html_find(buffer + position, length - position, context);
+
+        position += clean;
+        escaped += clean;
+
+        if (position == length) {
+            break;
+        }
+
+        escaped += sl_encode_entities[context][(uint8_t) buffer[position ++]].length;
+    }
+
+    return escaped;
+}
+
+static size_t sl_encode_html_window(char *buffer, size_t length, size_t *position, char *output, size_t available, sl_encode_context context)
+{
+    switch (sl_cpu_get_level()) {
+#ifdef SL_CPU_X86
+        case SL_CPU_AVX2:
+            return sl_encode_html_window_avx2(buffer, length, position, output, available, context);
+        case SL_CPU_SSE2:
+            return sl_encode_html_window_sse2(buffer, length, position, output, available, context);
+#endif
+        default:
+            return sl_encode_html_window_scalar(buffer, length, position, output, available, context);
+    }
+}
+
+int sl_encode_html_builder(sl_string_builder *builder, char *buffer, size_t length, sl_encode_context context)
+{
+    size_t position = 0, available;
+
+    while (position < length) {
+        if (sl_string_builder_reserve(builder, length - position + SL_ENCODE_ENTITY_MAX_LENGTH) == -1) {
+            return -1;
+        }
+
+        char *output = sl_string_builder_tail(builder, &available);
+
+        sl_string_builder_commit(builder, sl_encode_html_window(buffer, length, &position, output, available, context));
+    }
+
+    return 0;
+}
+
+int sl_encode_html_rope(sl_rope *rope, char *buffer, size_t length, sl_encode_context context)
+{
+    size_t position = 0;
+
+    while (position < length) {
+        char *output = sl_rope_reserve(rope, SL_ENCODE_ENTITY_MAX_LENGTH);
+        if (output == NULL) {
+            return -1;
+        }
+
+        size_t available = rope->chunk_allocated - rope->chunk_used;
+
+        if (sl_rope_commit(rope, sl_encode_html_window(buffer, length, &position, output, available, context)) == -1) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+sl_string *sl_encode_html_string(sl_arena *arena, sl_string *string, sl_encode_context context)
+{
+    size_t clean = sl_encode_html_find(string->buffer, string->length, context);
+
+    if (clean == string->length) {
+        return string;
+    }
+
+    size_t length = clean + sl_encode_html_length(string->buffer + clean, string->length - clean, context);
+
+    char *buffer = sl_arena_allocate(arena, length + SL_ENCODE_ENTITY_MAX_LENGTH);
+    if (buffer == NULL) {
+        return NULL;
+    }
+
+    size_t position = 0;
+
+    sl_encode_html_window(string->buffer, string->length, &position, buffer, length + SL_ENCODE_ENTITY_MAX_LENGTH, context);
+
+    buffer[length] = 0;
+
+    return sl_string_create_with_buffer(arena, buffer, length);
+}
+
+bool sl_encode_utf8_is_valid(char *buffer, size_t length)
+{
+    switch (sl_cpu_get_level()) {
+#ifdef SL_CPU_X86
+        case SL_CPU_AVX2:
+            return sl_encode_utf8_is_valid_avx2(buffer, length);
+        case SL_CPU_SSE2:
+            return sl_encode_utf8_is_valid_sse2(buffer, length);
+#endif
+        default:
+            return sl_encode_utf8_is_valid_scalar(buffer, length);
+    }
+}
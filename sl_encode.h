@@ -0,0 +1,28 @@
+#ifndef SL_ENCODE_H
+#define SL_ENCODE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "sl_arena.h"
+#include "sl_string.h"
+#include "sl_rope.h"
+
+typedef enum sl_encode_context sl_encode_context;
+
+enum sl_encode_context {
+    SL_ENCODE_CONTEXT_HTML,
+    SL_ENCODE_CONTEXT_ATTRIBUTE,
+    SL_ENCODE_CONTEXTS
+};
+
+size_t sl_encode_html_find(char *buffer, size_t length, sl_encode_context context);
+size_t sl_encode_html_length(char *buffer, size_t length, sl_encode_context context);
+int sl_encode_html_builder(sl_string_builder *builder, char *buffer, size_t length, sl_encode_context context);
+int sl_encode_html_rope(sl_rope *rope, char *buffer, size_t length, sl_encode_context context);
+sl_string *sl_encode_html_string(sl_arena *arena, sl_string *string, sl_encode_context context);
+
+bool sl_encode_utf8_is_valid(char *buffer, size_t length);
+
+#endif
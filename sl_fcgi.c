@@ -1,19 +1,38 @@
 #include "sl_fcgi.h"
 #include "sl_string.h"
+#include "sl_probe.h"
 
 #include <stdio.h>
+#include <arpa/inet.h>
 
 #define SL_FCGI_RESPONSE_HEADER_PREALLOCATE 64
+#define SL_FCGI_RESPONSE_IOVEC_PREALLOCATE 8
 
-void sl_fcgi_parser_init(sl_fcgi_parser *parser, sl_arena *arena, sl_log *log)
+void sl_fcgi_parser_init(sl_fcgi_parser *parser, sl_arena *arena, sl_slab *param_slab, sl_log *log)
 {
     *parser = (sl_fcgi_parser) {0};
 
     parser->state = SL_FGI_PARSER_STATE_VERSION;
     parser->arena = arena;
+    parser->param_slab = param_slab;
     parser->log = log;
 }
 
+void sl_fcgi_parser_release_params(sl_fcgi_parser *parser)
+{
+    if (parser->param_slab != NULL) {
+        sl_fcgi_msg_param *next = NULL;
+
+        for (sl_fcgi_msg_param *param = parser->first_param; param != NULL; param = next) {
+            next = param->next;
+            sl_slab_free(parser->param_slab, param);
+        }
+    }
+
+    parser->first_param = NULL;
+    parser->last_param = NULL;
+}
+
 sl_fcgi_parser_state sl_fcgi_parser_dispatch_type(uint8_t type)
 {
     switch (type) {
@@ -74,7 +93,12 @@ void sl_fcgi_parser_parse_params(sl_fcgi_parser *parser, uint8_t octet)
     while (1) {
         switch (parser->state) {
             case SL_FCGI_PARSER_STATE_PARAM_NAME_LENGTH_B3:
-                param = sl_arena_allocate(parser->arena, sizeof(sl_fcgi_msg_param));
+                if (parser->param_slab != NULL) {
+                    param = sl_slab_allocate(parser->param_slab);
+                } else {
+                    param = sl_arena_allocate(parser->arena, sizeof(sl_fcgi_msg_param));
+                }
+
                 if (param == NULL) {
                     parser->state = SL_FCGI_PARSER_STATE_ERROR;
                     return;
@@ -178,7 +202,7 @@ void sl_fcgi_parser_parse_params(sl_fcgi_parser *parser, uint8_t octet)
 
                     sl_string parameter_name = sl_string_init_with_buffer((char *) parser->last_param->name, parser->last_param->name_length);
                     sl_string parameter_value = sl_string_init_with_buffer((char *) parser->last_param->value, parser->last_param->value_length);
-                    sl_log_write_format(parser->arena, parser->log, SL_LOG_DEBUG, "FCGI parameter: %S=%S", &parameter_name, &parameter_value);
+                    SL_LOG_WRITE_FORMAT(parser->log, SL_LOG_DEBUG, "FCGI parameter: %S=%S", &parameter_name, &parameter_value);
 
                     if (parser->message_size == parser->message_header.content_length) {
                         if (parser->message_header.padding_length == 0) {
@@ -217,7 +241,7 @@ void sl_fcgi_parser_parse_stdin(sl_fcgi_parser *parser, uint8_t octet)
             case SL_FCGI_PARSER_STATE_STDIN_DATA:
                 if (parser->stdin_stream.data == NULL) {
                     parser->stdin_stream.length = parser->message_header.content_length;
-                    parser->stdin_stream.data = sl_arena_allocate(parser->arena, parser->stdin_stream.length + 1);
+                    parser->stdin_stream.data = sl_arena_allocate(parser->arena, sl_arena_pow2_size(parser->stdin_stream.length + 1));
                     if (parser->stdin_stream.data == NULL) {
                         parser->state = SL_FCGI_PARSER_STATE_ERROR;
                         return;
@@ -231,7 +255,7 @@ void sl_fcgi_parser_parse_stdin(sl_fcgi_parser *parser, uint8_t octet)
                     parser->stdin_stream.data[parser->stdin_stream.length] = 0;
 
                     sl_string stdin = sl_string_init_with_buffer((char *) parser->stdin_stream.data, parser->stdin_stream.length);
-                    sl_log_write_format(parser->arena, parser->log, SL_LOG_DEBUG, "FCGI stdin: %S", &stdin);
+                    SL_LOG_WRITE_FORMAT(parser->log, SL_LOG_DEBUG, "FCGI stdin: %S", &stdin);
 
                     if (parser->message_header.padding_length > 0) {
                         parser->read_counter = parser->message_header.padding_length;
@@ -240,7 +264,7 @@ void sl_fcgi_parser_parse_stdin(sl_fcgi_parser *parser, uint8_t octet)
                     }
 
                     parser->state = SL_FCGI_PARSER_STATE_FINISHED;
-                    continue;
+                    return;
                 }
 
                 parser->stdin_stream.data[parser->stdin_stream.length - parser->read_counter] = octet;
@@ -358,15 +382,73 @@ void sl_fcgi_request_init(sl_fcgi_request *request, sl_arena *arena, sl_log *log
     request->log = log;
 
     sl_hashtable_init(&request->parameters, request->arena, param_hashtable_size, true);
+    sl_query_init(&request->query, request->arena, SL_QUERY_TYPE_QUERY_STRING);
+    sl_query_init(&request->cookies, request->arena, SL_QUERY_TYPE_COOKIE);
 }
 
-static void sl_fcgi_request_append_param(sl_fcgi_request *request, sl_fcgi_parser *parser)
+static int sl_fcgi_request_store_params(sl_fcgi_request *request, sl_fcgi_parser *parser)
 {
     for (sl_fcgi_msg_param *parameter = parser->first_param; parameter != NULL; parameter = parameter->next) {
+        if (request->parameters.count >= SL_FCGI_MAX_PARAMS) {
+            SL_LOG_WRITE_LIMITED(request->log, SL_LOG_ERROR, "Too many FCGI parameters");
+            return -1;
+        }
+
         sl_string *name = sl_string_create_from_buffer(request->arena, (char *) parameter->name, parameter->name_length, parameter->name_length);
-        sl_string *value = sl_string_create_from_buffer(request->arena, (char *) parameter->value, parameter->value_length, parameter->value_length);;
-        sl_hashtable_set(&request->parameters, name, value);
+        sl_string *value = sl_string_create_from_buffer(request->arena, (char *) parameter->value, parameter->value_length, parameter->value_length);
+        if (name == NULL || value == NULL) {
+            return -1;
+        }
+
+        if (sl_hashtable_set(&request->parameters, name, value) == -1) {
+            SL_LOG_WRITE_LIMITED(request->log, SL_LOG_ERROR, "Unable to store FCGI parameter");
+            return -1;
+        }
     }
+
+    return 0;
+}
+
+static void sl_fcgi_request_append_param(sl_fcgi_request *request, sl_fcgi_parser *parser)
+{
+    if (sl_fcgi_request_store_params(request, parser) == -1) {
+        request->state = SL_FCGI_REQUEST_STATE_ERROR;
+    }
+
+    sl_fcgi_parser_release_params(parser);
+}
+
+static int sl_fcgi_request_reserve_stdin(sl_fcgi_request *request)
+{
+    sl_string content_length_name = sl_string_init_with_cstring("CONTENT_LENGTH");
+    sl_string *content_length = sl_hashtable_get(&request->parameters, &content_length_name);
+    size_t length = 0;
+
+    if (content_length == NULL) {
+        return 0;
+    }
+
+    for (size_t n = 0; n < content_length->length; n ++) {
+        if (content_length->buffer[n] < '0' || content_length->buffer[n] > '9' || length > (SIZE_MAX - 9) / 10) {
+            return 0;
+        }
+
+        length = length * 10 + content_length->buffer[n] - '0';
+    }
+
+    if (length == 0) {
+        return 0;
+    }
+
+    request->stdin.buffer = sl_arena_allocate(request->arena, length);
+    if (request->stdin.buffer == NULL) {
+        SL_LOG_WRITE_LIMITED(request->log, SL_LOG_ERROR, "Unable to reserve FCGI stdin");
+        return -1;
+    }
+
+    request->stdin.allocated = length;
+
+    return 0;
 }
 
 static void sl_fcgi_request_append_stdin(sl_fcgi_request *request, sl_fcgi_parser *parser)
@@ -375,10 +457,17 @@ static void sl_fcgi_request_append_stdin(sl_fcgi_request *request, sl_fcgi_parse
         return;
     }
 
+    if (request->stdin.allocated == 0 && sl_fcgi_request_reserve_stdin(request) == -1) {
+        request->state = SL_FCGI_REQUEST_STATE_ERROR;
+        return;
+    }
+
     if (sl_string_append_with_buffer(request->arena, &request->stdin, (char *) parser->stdin_stream.data, parser->stdin_stream.length) == -1) {
         request->state = SL_FCGI_REQUEST_STATE_ERROR;
         return;
     }
+
+    sl_arena_free(parser->arena, parser->stdin_stream.data, sl_arena_pow2_size(parser->stdin_stream.length + 1));
 }
 
 void sl_fcgi_request_process(sl_fcgi_request *request, sl_fcgi_parser *parser)
@@ -388,6 +477,8 @@ void sl_fcgi_request_process(sl_fcgi_request *request, sl_fcgi_parser *parser)
         return;
     }
 
+    SL_PROBE4(record__parsed, request, parser->message_header.type, parser->message_header.request_id, parser->message_header.content_length);
+
     switch (request->state) {
         case SL_FCGI_REQUEST_STATE_BEGIN:
             if (parser->message_header.type != SL_FCGI_TYPE_BEGIN_REQUEST) {
@@ -447,6 +538,38 @@ void sl_fcgi_request_process(sl_fcgi_request *request, sl_fcgi_parser *parser)
         case SL_FCGI_REQUEST_STATE_ERROR:
             break;
     }
+
+    if (request->state == SL_FCGI_REQUEST_STATE_FINISHED) {
+        SL_PROBE5(request__finished, request, request->arena, request->request_id, request->parameters.count, request->stdin.length);
+    }
+}
+
+static int sl_fcgi_request_get_decoded(sl_fcgi_request *request, sl_query *query, char *parameter, sl_string *name, sl_string **value)
+{
+    *value = NULL;
+
+    if (query->is_decoded == false) {
+        sl_string parameter_name = sl_string_init_with_cstring(parameter);
+
+        if (sl_query_decode(query, sl_hashtable_get(&request->parameters, &parameter_name)) == -1) {
+            SL_LOG_WRITE_LIMITED(request->log, SL_LOG_ERROR, "Unable to decode FCGI parameter");
+            return -1;
+        }
+    }
+
+    *value = sl_query_get(query, name);
+
+    return 0;
+}
+
+inline int sl_fcgi_request_get_query(sl_fcgi_request *request, sl_string *name, sl_string **value)
+{
+    return sl_fcgi_request_get_decoded(request, &request->query, "QUERY_STRING", name, value);
+}
+
+inline int sl_fcgi_request_get_cookie(sl_fcgi_request *request, sl_string *name, sl_string **value)
+{
+    return sl_fcgi_request_get_decoded(request, &request->cookies, "HTTP_COOKIE", name, value);
 }
 
 void sl_fcgi_response_init(sl_fcgi_response *response, sl_arena *arena, sl_log *log, size_t header_hashtable_size)
@@ -457,6 +580,12 @@ void sl_fcgi_response_init(sl_fcgi_response *response, sl_arena *arena, sl_log *
     response->log = log;
 
     sl_hashtable_init(&response->headers, response->arena, header_hashtable_size, true);
+    sl_rope_init(&response->output, arena);
+}
+
+inline void sl_fcgi_response_release(sl_fcgi_response *response)
+{
+    sl_rope_release(&response->output);
 }
 
 inline int sl_fcgi_response_append_header(sl_fcgi_response *response, sl_string *name, sl_string *value)
@@ -464,44 +593,165 @@ inline int sl_fcgi_response_append_header(sl_fcgi_response *response, sl_string
     return sl_hashtable_set(&response->headers, name, value);
 }
 
+static int sl_fcgi_response_push_iovec(sl_fcgi_response *response, struct iovec **iovecs, size_t *count, size_t *allocated, void *buffer, size_t length)
+{
+    if (*count == *allocated) {
+        size_t new_allocated = *allocated == 0 ? SL_FCGI_RESPONSE_IOVEC_PREALLOCATE : *allocated << 1;
+
+        struct iovec *new_iovecs = sl_arena_allocate(response->arena, new_allocated * sizeof(struct iovec));
+        if (new_iovecs == NULL) {
+            return -1;
+        }
+
+        if (*count > 0) {
+            memcpy(new_iovecs, *iovecs, *count * sizeof(struct iovec));
+        }
+
+        sl_arena_free(response->arena, *iovecs, *allocated * sizeof(struct iovec));
+
+        *iovecs = new_iovecs;
+        *allocated = new_allocated;
+    }
+
+    (*iovecs)[(*count) ++] = (struct iovec) {buffer, length};
+
+    return 0;
+}
+
+int sl_fcgi_response_append_header_line(sl_fcgi_response *response, sl_string *line)
+{
+    if (sl_fcgi_response_push_iovec(response, &response->header_lines, &response->header_line_count, &response->header_line_allocated, line->buffer, line->length) == -1) {
+        return -1;
+    }
+
+    response->header_lines_length += line->length;
+
+    return 0;
+}
+
 inline int sl_fcgi_response_append_output(sl_fcgi_response *response, sl_string *output)
 {
-    return sl_string_append_with_string(response->arena, &response->stdout, output);
+    return sl_fcgi_response_append_buffer(response, output->buffer, output->length);
+}
+
+inline int sl_fcgi_response_append_buffer(sl_fcgi_response *response, void *buffer, size_t length)
+{
+    return sl_rope_append_reference(&response->output, buffer, length);
+}
+
+inline int sl_fcgi_response_append_copy(sl_fcgi_response *response, void *buffer, size_t length)
+{
+    return sl_rope_append_copy(&response->output, buffer, length);
 }
 
-sl_string *sl_fcgi_response_process(sl_fcgi_response *response)
+static inline void sl_fcgi_response_add_iovec(sl_fcgi_response *response, void *buffer, size_t length)
 {
-    sl_string *output = sl_arena_allocate(response->arena, sizeof(sl_string));
-    if (output == NULL) {
-        return NULL;
+    response->iovecs[response->iovec_count ++] = (struct iovec) {buffer, length};
+    response->length += length;
+}
+
+static void sl_fcgi_response_add_record(sl_fcgi_response *response, sl_fcgi_msg_header *header, uint8_t type, uint16_t request_id, uint16_t length)
+{
+    *header = (sl_fcgi_msg_header) {
+        .version = SL_FCGI_VERSION,
+        .type = type,
+        .request_id = htons(request_id),
+        .content_length = htons(length),
+        .padding_length = 0,
+        .reserved = 0
+    };
+
+    response->copied += sizeof(sl_fcgi_msg_header);
+
+    sl_fcgi_response_add_iovec(response, header, sizeof(sl_fcgi_msg_header));
+}
+
+int sl_fcgi_response_serialize(sl_fcgi_response *response, uint16_t request_id, uint8_t protocol_status)
+{
+    sl_hashtable_entry *entry;
+    size_t position = 0, count = 0, length = response->header_lines_length + response->output.length + 2;
+    size_t pieces = response->header_line_count + response->headers.count * 4 + 1 + response->output.count;
+
+    struct iovec *content = sl_arena_allocate(response->arena, pieces * sizeof(struct iovec));
+    if (content == NULL) {
+        return -1;
+    }
+
+    for (size_t n = 0; n < response->header_line_count; n ++) {
+        content[count ++] = response->header_lines[n];
+    }
+
+    while ((entry = sl_hashtable_next(&response->headers, &position)) != NULL) {
+        content[count ++] = (struct iovec) {entry->key->buffer, entry->key->length};
+        content[count ++] = (struct iovec) {": ", 2};
+        content[count ++] = (struct iovec) {entry->value->buffer, entry->value->length};
+        content[count ++] = (struct iovec) {"\r\n", 2};
+
+        length += entry->key->length + entry->value->length + 4;
+    }
+
+    content[count ++] = (struct iovec) {"\r\n", 2};
+
+    for (size_t n = 0; n < response->output.count; n ++) {
+        content[count ++] = response->output.segments[n];
     }
 
-    *output = (sl_string) {0};
+    size_t records = (length + SL_FCGI_MAX_CONTENT_LENGTH - 1) / SL_FCGI_MAX_CONTENT_LENGTH;
 
-    for (size_t n = 0; n < response->headers.size; n ++) {
-        sl_hashtable_bucket *bucket = response->headers.buckets[n];
-        if (bucket == NULL) {
-            continue;
+    sl_fcgi_msg_header *headers = sl_arena_allocate(response->arena, (records + 2) * sizeof(sl_fcgi_msg_header));
+    sl_fcgi_msg_end *end_message = sl_arena_allocate(response->arena, sizeof(sl_fcgi_msg_end));
+
+    response->iovecs = sl_arena_allocate(response->arena, (count + records * 2 + 3) * sizeof(struct iovec));
+    response->iovec_count = 0;
+    response->length = 0;
+    response->copied = response->output.copied;
+
+    if (headers == NULL || end_message == NULL || response->iovecs == NULL) {
+        return -1;
+    }
+
+    size_t piece = 0, offset = 0;
+
+    for (size_t record = 0; record < records; record ++) {
+        size_t remaining = length - record * SL_FCGI_MAX_CONTENT_LENGTH;
+
+        if (remaining > SL_FCGI_MAX_CONTENT_LENGTH) {
+            remaining = SL_FCGI_MAX_CONTENT_LENGTH;
         }
 
-        for (sl_hashtable_bucket *node = bucket; node != NULL; node = node->next) {
-            sl_string *header = sl_string_format(response->arena, "%S: %S\r\n", node->key, node->value);
-            if (header == NULL) {
-                return NULL;
+        sl_fcgi_response_add_record(response, &headers[record], SL_FCGI_TYPE_STDOUT, request_id, remaining);
+
+        while (remaining > 0) {
+            size_t chunk = content[piece].iov_len - offset;
+
+            if (chunk > remaining) {
+                chunk = remaining;
             }
-            if (sl_string_append_with_string(response->arena, output, header) == -1) {
-                return NULL;
+
+            if (chunk > 0) {
+                sl_fcgi_response_add_iovec(response, (uint8_t *) content[piece].iov_base + offset, chunk);
+            }
+
+            remaining -= chunk;
+            offset += chunk;
+
+            if (offset == content[piece].iov_len) {
+                piece ++;
+                offset = 0;
             }
         }
     }
 
-    if (sl_string_append_with_buffer(response->arena, output, "\r\n", 2) == -1) {
-        return NULL;
-    }
+    *end_message = (sl_fcgi_msg_end) {
+        .app_status = 0,
+        .protocol_status = protocol_status
+    };
 
-    if (sl_string_append_with_string(response->arena, output, &response->stdout) == -1) {
-        return NULL;
-    }
+    sl_fcgi_response_add_record(response, &headers[records], SL_FCGI_TYPE_STDOUT, request_id, 0);
+    sl_fcgi_response_add_record(response, &headers[records + 1], SL_FCGI_TYPE_END_REQUEST, request_id, sizeof(sl_fcgi_msg_end));
+    sl_fcgi_response_add_iovec(response, end_message, sizeof(sl_fcgi_msg_end));
+
+    response->copied += sizeof(sl_fcgi_msg_end);
 
-    return output;
+    return 0;
 }
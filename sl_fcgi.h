@@ -2,22 +2,33 @@
 #define SL_FGI_H
 
 #include <string.h>
+#include <sys/uio.h>
 
 #include "sl_arena.h"
+#include "sl_slab.h"
 #include "sl_log.h"
 #include "sl_string.h"
 #include "sl_hashtable.h"
+#include "sl_query.h"
+#include "sl_rope.h"
+#include "sl_trace.h"
 
 #define SL_FCGI_VERSION 1
 
 #define SL_FCGI_FLAG_KEEP_CONN 1
 
+#define SL_FCGI_MAX_PARAMS 512
+#define SL_FCGI_MAX_CONTENT_LENGTH 65535
+
 #define SL_FCGI_TYPE_BEGIN_REQUEST 1
 #define SL_FCGI_TYPE_END_REQUEST   3
 #define SL_FCGI_TYPE_PARAMS        4
 #define SL_FCGI_TYPE_STDIN         5
 #define SL_FCGI_TYPE_STDOUT        6
 
+#define SL_FCGI_PROTOCOL_STATUS_REQUEST_COMPLETE 0
+#define SL_FCGI_PROTOCOL_STATUS_OVERLOADED       2
+
 typedef enum sl_fcgi_parser_state sl_fcgi_parser_state;
 typedef enum sl_fcgi_request_state sl_fcgi_request_state;
 
@@ -117,6 +128,7 @@ struct sl_fcgi_parser {
     size_t read_counter;
     size_t message_size;
     sl_arena *arena;
+    sl_slab *param_slab;
     sl_log *log;
     sl_fcgi_msg_header message_header;
     sl_fcgi_msg_begin begin_message;
@@ -131,26 +143,45 @@ struct sl_fcgi_request {
     sl_log *log;
     uint16_t request_id;
     uint8_t flags;
+    size_t bytes_sent;
     sl_hashtable parameters;
     sl_string stdin;
+    sl_query query;
+    sl_query cookies;
+    sl_trace_span trace;
 };
 
 struct sl_fcgi_response {
     sl_arena *arena;
     sl_log *log;
     sl_hashtable headers;
-    sl_string stdout;
+    struct iovec *header_lines;
+    size_t header_line_count;
+    size_t header_line_allocated;
+    size_t header_lines_length;
+    sl_rope output;
+    struct iovec *iovecs;
+    size_t iovec_count;
+    size_t length;
+    size_t copied;
 };
 
-void sl_fcgi_parser_init(sl_fcgi_parser *parser, sl_arena *arena, sl_log *log);
+void sl_fcgi_parser_init(sl_fcgi_parser *parser, sl_arena *arena, sl_slab *param_slab, sl_log *log);
+void sl_fcgi_parser_release_params(sl_fcgi_parser *parser);
 ssize_t sl_fcgi_parser_parse(sl_fcgi_parser *parser, uint8_t *buffer, size_t length);
 
 void sl_fcgi_request_init(sl_fcgi_request *request, sl_arena *arena, sl_log *log, size_t param_hashtable_size);
 void sl_fcgi_request_process(sl_fcgi_request *request, sl_fcgi_parser *parser);
+int sl_fcgi_request_get_query(sl_fcgi_request *request, sl_string *name, sl_string **value);
+int sl_fcgi_request_get_cookie(sl_fcgi_request *request, sl_string *name, sl_string **value);
 
 void sl_fcgi_response_init(sl_fcgi_response *response, sl_arena *arena, sl_log *log, size_t header_hashtable_size);
+void sl_fcgi_response_release(sl_fcgi_response *response);
 int sl_fcgi_response_append_header(sl_fcgi_response *response, sl_string *name, sl_string *value);
+int sl_fcgi_response_append_header_line(sl_fcgi_response *response, sl_string *line);
 int sl_fcgi_response_append_output(sl_fcgi_response *response, sl_string *output);
-sl_string *sl_fcgi_response_process(sl_fcgi_response *response);
+int sl_fcgi_response_append_buffer(sl_fcgi_response *response, void *buffer, size_t length);
+int sl_fcgi_response_append_copy(sl_fcgi_response *response, void *buffer, size_t length);
+int sl_fcgi_response_serialize(sl_fcgi_response *response, uint16_t request_id, uint8_t protocol_status);
 
 #endif
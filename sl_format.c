@@ -0,0 +1,514 @@
+#include "sl_format.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+
+#define SL_FORMAT_DEFAULT_PRECISION 6
+#define SL_FORMAT_MAX_FIXED_DOUBLE  1e18
+
+typedef struct sl_format_output sl_format_output;
+
+struct sl_format_output {
+    char *buffer;
+    size_t size;
+    size_t length;
+};
+
+static const char sl_format_digits[200] = "00010203040506070809101112131415161718192021222324252627282930313233343536373839404142434445464748495051525354555657585960616263646566676869707172737475767778798081828384858687888990919293949596979899";
+static const char sl_format_hex_lower[16] = "0123456789abcdef";
+static const char sl_format_hex_upper[16] = "0123456789ABCDEF";
+static const uint64_t sl_format_powers[SL_FORMAT_MAX_PRECISION + 1] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+
+static inline size_t sl_format_count_digits(uint64_t value)
+{
+    size_t digits = 1;
+
+    while (true) {
+        if (value < 10) {
+            return digits;
+        }
+
+        if (value < 100) {
+            return digits + 1;
+        }
+
+        if (value < 1000) {
+            return digits + 2;
+        }
+
+        if (value < 10000) {
+            return digits + 3;
+        }
+
+        value /= 10000;
+        digits += 4;
+    }
+}
+
+size_t sl_format_unsigned(uint64_t value, char *buffer)
+{
+    size_t length = sl_format_count_digits(value);
+    char *end = buffer + length;
+
+    while (value >= 100) {
+        size_t index = (value % 100) << 1;
+
+        value /= 100;
+
+        *--end = sl_format_digits[index + 1];
+        *--end = sl_format_digits[index];
+    }
+
+    if (value >= 10) {
+        *--end = sl_format_digits[(value << 1) + 1];
+        *--end = sl_format_digits[value << 1];
+    } else {
+        *--end = '0' + value;
+    }
+
+    return length;
+}
+
+size_t sl_format_signed(int64_t value, char *buffer)
+{
+    if (value >= 0) {
+        return sl_format_unsigned(value, buffer);
+    }
+
+    *buffer = '-';
+
+    return sl_format_unsigned(0 - (uint64_t) value, buffer + 1) + 1;
+}
+
+size_t sl_format_hex(uint64_t value, char *buffer, int uppercase)
+{
+    const char *digits = uppercase != 0 ? sl_format_hex_upper : sl_format_hex_lower;
+    size_t length = (64 - __builtin_clzl(value | 1) + 3) >> 2;
+
+    for (char *end = buffer + length; end > buffer; value >>= 4) {
+        *--end = digits[value & 0xf];
+    }
+
+    return length;
+}
+
+size_t sl_format_double(double value, int precision, char *buffer)
+{
+    char *start = buffer;
+
+    if (isnan(value)) {
+        memcpy(buffer, "nan", 3);
+        return 3;
+    }
+
+    if (signbit(value)) {
+        *buffer ++ = '-';
+        value = -value;
+    }
+
+    if (isinf(value)) {
+        memcpy(buffer, "inf", 3);
+        return buffer + 3 - start;
+    }
+
+    if (precision < 0) {
+        precision = SL_FORMAT_DEFAULT_PRECISION;
+    }
+
+    if (precision > SL_FORMAT_MAX_PRECISION || value >= SL_FORMAT_MAX_FIXED_DOUBLE) {
+        return 0;
+    }
+
+    uint64_t integer = (uint64_t) value;
+    double scaled = (value - integer) * sl_format_powers[precision];
+    uint64_t fraction = (uint64_t) scaled;
+    double remainder = scaled - fraction;
+
+    if (remainder > 0.5 || (remainder == 0.5 && ((precision > 0 ? fraction : integer) & 1) != 0)) {
+        fraction ++;
+    }
+
+    if (fraction >= sl_format_powers[precision]) {
+        fraction -= sl_format_powers[precision];
+        integer ++;
+    }
+
+    buffer += sl_format_unsigned(integer, buffer);
+
+    if (precision > 0) {
+        size_t digits = sl_format_count_digits(fraction);
+
+        *buffer ++ = '.';
+
+        memset(buffer, '0', precision - digits);
+        sl_format_unsigned(fraction, buffer + precision - digits);
+
+        buffer += precision;
+    }
+
+    return buffer - start;
+}
+
+static inline void sl_format_emit(sl_format_output *output, const char *buffer, size_t length)
+{
+    if (output->length < output->size) {
+        size_t available = output->size - output->length;
+
+        memcpy(output->buffer + output->length, buffer, length < available ? length : available);
+    }
+
+    output->length += length;
+}
+
+static inline void sl_format_pad(sl_format_output *output, char padding, size_t length)
+{
+    if (output->length < output->size) {
+        size_t available = output->size - output->length;
+
+        memset(output->buffer + output->length, padding, length < available ? length : available);
+    }
+
+    output->length += length;
+}
+
+static void sl_format_emit_field(sl_format_output *output, const char *buffer, size_t length, size_t width, bool left, bool zero)
+{
+    size_t padding = width > length ? width - length : 0;
+
+    if (padding == 0) {
+        sl_format_emit(output, buffer, length);
+        return;
+    }
+
+    if (left == true) {
+        sl_format_emit(output, buffer, length);
+        sl_format_pad(output, ' ', padding);
+        return;
+    }
+
+    if (zero == true && length > 0 && buffer[0] == '-') {
+        sl_format_emit(output, buffer, 1);
+        buffer ++;
+        length --;
+    }
+
+    sl_format_pad(output, zero == true ? '0' : ' ', padding);
+    sl_format_emit(output, buffer, length);
+}
+
+static void sl_format_emit_double(sl_format_output *output, double value, int precision, size_t width, bool left, bool zero)
+{
+    char *format = left == true ? "%-*.*f" : (zero == true ? "%0*.*f" : "%*.*f");
+    size_t available = output->length < output->size ? output->size - output->length : 0;
+
+    int length = snprintf(available > 0 ? output->buffer + output->length : NULL, available > 0 ? available + 1 : 0, format, (int) width, precision, value);
+    if (length > 0) {
+        output->length += length;
+    }
+}
+
+size_t sl_format_buffer(char *buffer, size_t size, char *format, size_t length, va_list arguments)
+{
+    sl_format_output output = {buffer, size > 0 ? size - 1 : 0, 0};
+    char *end = format + length;
+    char number[SL_FORMAT_MAX_NUMBER_LENGTH];
+
+    while (format < end) {
+        char *literal = memchr(format, '%', end - format);
+        if (literal == NULL) {
+            sl_format_emit(&output, format, end - format);
+            break;
+        }
+
+        if (literal > format) {
+            sl_format_emit(&output, format, literal - format);
+        }
+
+        format = literal + 1;
+
+        bool left = false, zero = false, wide = false;
+        size_t width = 0, number_length = 0;
+        int precision = -1;
+
+        for (; format < end && (*format == '-' || *format == '0'); format ++) {
+            if (*format == '-') {
+                left = true;
+            } else {
+                zero = true;
+            }
+        }
+
+        if (format < end && *format == '*') {
+            int argument = va_arg(arguments, int);
+
+            if (argument < 0) {
+                left = true;
+                argument = -argument;
+            }
+
+            width = argument;
+            format ++;
+        } else {
+            for (; format < end && *format >= '0' && *format <= '9'; format ++) {
+                width = width * 10 + (*format - '0');
+            }
+        }
+
+        if (format < end && *format == '.') {
+            precision = 0;
+            format ++;
+
+            if (format < end && *format == '*') {
+                precision = va_arg(arguments, int);
+                format ++;
+            } else {
+                for (; format < end && *format >= '0' && *format <= '9'; format ++) {
+                    precision = precision * 10 + (*format - '0');
+                }
+            }
+        }
+
+        if (format < end && *format == 'l') {
+            wide = true;
+            format ++;
+
+            if (format < end && *format == 'l') {
+                format ++;
+            }
+        } else if (format + 1 < end && *format == 'z' && (format[1] == 'd' || format[1] == 'u' || format[1] == 'x' || format[1] == 'X')) {
+            wide = true;
+            format ++;
+        }
+
+        if (format >= end) {
+            break;
+        }
+
+        switch (*format ++) {
+            case 'z':
+                number_length = sl_format_unsigned(va_arg(arguments, size_t), number);
+                sl_format_emit_field(&output, number, number_length, width, left, zero);
+                break;
+            case 'd':
+            case 'i':
+                number_length = sl_format_signed(wide == true ? va_arg(arguments, long) : va_arg(arguments, int), number);
+                sl_format_emit_field(&output, number, number_length, width, left, zero);
+                break;
+            case 'u':
+                number_length = sl_format_unsigned(wide == true ? va_arg(arguments, unsigned long) : va_arg(arguments, unsigned int), number);
+                sl_format_emit_field(&output, number, number_length, width, left, zero);
+                break;
+            case 'x':
+            case 'X':
+                number_length = sl_format_hex(wide == true ? va_arg(arguments, unsigned long) : va_arg(arguments, unsigned int), number, format[-1] == 'X');
+                sl_format_emit_field(&output, number, number_length, width, left, zero);
+                break;
+            case 'p':
+                memcpy(number, "0x", 2);
+                number_length = sl_format_hex((uintptr_t) va_arg(arguments, void *), number + 2, 0) + 2;
+                sl_format_emit_field(&output, number, number_length, width, left, false);
+                break;
+            case 'f':
+                double arg_double = va_arg(arguments, double);
+                number_length = sl_format_double(arg_double, precision, number);
+                if (number_length == 0) {
+                    sl_format_emit_double(&output, arg_double, precision < 0 ? SL_FORMAT_DEFAULT_PRECISION : precision, width, left, zero);
+                    break;
+                }
+
+                sl_format_emit_field(&output, number, number_length, width, left, zero);
+                break;
+            case 'c':
+                number[0] = (char) va_arg(arguments, int);
+                sl_format_emit_field(&output, number, 1, width, left, false);
+                break;
+            case 's':
+                char *arg_cstring = va_arg(arguments, char *);
+                if (arg_cstring == NULL) {
+                    break;
+                }
+
+                sl_format_emit_field(&output, arg_cstring, precision >= 0 ? strnlen(arg_cstring, precision) : strlen(arg_cstring), width, left, false);
+                break;
+            case 'S':
+                sl_string *arg_string = va_arg(arguments, sl_string *);
+                if (arg_string == NULL) {
+                    break;
+                }
+
+                sl_format_emit_field(&output, arg_string->buffer, precision >= 0 && (size_t) precision < arg_string->length ? (size_t) precision : arg_string->length, width, left, false);
+                break;
+            case '%':
+                sl_format_emit(&output, "%", 1);
+                break;
+            default:
+                break;
+        }
+    }
+
+    if (size > 0) {
+        buffer[output.length < output.size ? output.length : output.size] = '\0';
+    }
+
+    return output.length;
+}
+
+size_t sl_format(char *buffer, size_t size, char *format, ...)
+{
+    va_list arguments;
+
+    va_start(arguments, format);
+    size_t length = sl_format_buffer(buffer, size, format, strlen(format), arguments);
+    va_end(arguments);
+
+    return length;
+}
+
+size_t sl_format_arguments(char *format, size_t length, uint8_t *arguments, size_t max)
+{
+    char *end = format + length;
+    size_t count = 0;
+
+    while (format < end) {
+        char *literal = memchr(format, '%', end - format);
+        if (literal == NULL) {
+            break;
+        }
+
+        format = literal + 1;
+
+        uint8_t pending[3];
+        size_t pending_count = 0;
+        bool wide = false;
+
+        while (format < end && (*format == '-' || *format == '0')) {
+            format ++;
+        }
+
+        if (format < end && *format == '*') {
+            pending[pending_count ++] = SL_FORMAT_ARGUMENT_INT;
+            format ++;
+        } else {
+            while (format < end && *format >= '0' && *format <= '9') {
+                format ++;
+            }
+        }
+
+        if (format < end && *format == '.') {
+            format ++;
+
+            if (format < end && *format == '*') {
+                pending[pending_count ++] = SL_FORMAT_ARGUMENT_INT;
+                format ++;
+            } else {
+                while (format < end && *format >= '0' && *format <= '9') {
+                    format ++;
+                }
+            }
+        }
+
+        if (format < end && *format == 'l') {
+            wide = true;
+            format ++;
+
+            if (format < end && *format == 'l') {
+                format ++;
+            }
+        } else if (format + 1 < end && *format == 'z' && (format[1] == 'd' || format[1] == 'u' || format[1] == 'x' || format[1] == 'X')) {
+            wide = true;
+            format ++;
+        }
+
+        if (format >= end) {
+            break;
+        }
+
+        switch (*format ++) {
+            case 'z':
+                pending[pending_count ++] = SL_FORMAT_ARGUMENT_SIZE;
+                break;
+            case 'c':
+                pending[pending_count ++] = SL_FORMAT_ARGUMENT_INT;
+                break;
+            case 'd':
+            case 'i':
+                pending[pending_count ++] = wide == true ? SL_FORMAT_ARGUMENT_LONG : SL_FORMAT_ARGUMENT_INT;
+                break;
+            case 'u':
+            case 'x':
+            case 'X':
+                pending[pending_count ++] = wide == true ? SL_FORMAT_ARGUMENT_UNSIGNED_LONG : SL_FORMAT_ARGUMENT_UNSIGNED;
+                break;
+            case 'p':
+                pending[pending_count ++] = SL_FORMAT_ARGUMENT_POINTER;
+                break;
+            case 'f':
+                pending[pending_count ++] = SL_FORMAT_ARGUMENT_DOUBLE;
+                break;
+            case 's':
+                pending[pending_count ++] = SL_FORMAT_ARGUMENT_CSTRING;
+                break;
+            case 'S':
+                pending[pending_count ++] = SL_FORMAT_ARGUMENT_STRING;
+                break;
+            default:
+                break;
+        }
+
+        if (count + pending_count > max) {
+            return SIZE_MAX;
+        }
+
+        memcpy(arguments + count, pending, pending_count);
+        count += pending_count;
+    }
+
+    return count;
+}
+
+inline size_t sl_format_length(char *format, size_t length, va_list arguments)
+{
+    return sl_format_buffer(NULL, 0, format, length, arguments);
+}
+
+int sl_format_builder(sl_string_builder *builder, char *format, ...)
+{
+    va_list arguments;
+
+    va_start(arguments, format);
+    int result = sl_format_builder_buffer(builder, format, strlen(format), arguments);
+    va_end(arguments);
+
+    return result;
+}
+
+int sl_format_builder_buffer(sl_string_builder *builder, char *format, size_t length, va_list arguments)
+{
+    va_list retry_arguments;
+    size_t available;
+
+    va_copy(retry_arguments, arguments);
+
+    char *tail = sl_string_builder_tail(builder, &available);
+    size_t formatted_length = sl_format_buffer(tail, available, format, length, arguments);
+
+    if (formatted_length >= available) {
+        if (sl_string_builder_reserve(builder, formatted_length + 1) == -1) {
+            va_end(retry_arguments);
+            return -1;
+        }
+
+        tail = sl_string_builder_tail(builder, &available);
+        sl_format_buffer(tail, available, format, length, retry_arguments);
+    }
+
+    va_end(retry_arguments);
+
+    sl_string_builder_commit(builder, formatted_length);
+
+    return 0;
+}
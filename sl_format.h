@@ -0,0 +1,40 @@
+#ifndef SL_FORMAT_H
+#define SL_FORMAT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+
+#include "sl_string.h"
+
+/* sl_format_double() returns 0 above SL_FORMAT_MAX_PRECISION digits or for magnitudes of 1e18 and up; sl_format() falls back to snprintf() for them. */
+#define SL_FORMAT_MAX_NUMBER_LENGTH 32
+#define SL_FORMAT_MAX_PRECISION      9
+
+typedef enum sl_format_argument sl_format_argument;
+
+enum sl_format_argument {
+    SL_FORMAT_ARGUMENT_INT,
+    SL_FORMAT_ARGUMENT_LONG,
+    SL_FORMAT_ARGUMENT_UNSIGNED,
+    SL_FORMAT_ARGUMENT_UNSIGNED_LONG,
+    SL_FORMAT_ARGUMENT_SIZE,
+    SL_FORMAT_ARGUMENT_POINTER,
+    SL_FORMAT_ARGUMENT_DOUBLE,
+    SL_FORMAT_ARGUMENT_CSTRING,
+    SL_FORMAT_ARGUMENT_STRING
+};
+
+size_t sl_format_unsigned(uint64_t value, char *buffer);
+size_t sl_format_signed(int64_t value, char *buffer);
+size_t sl_format_hex(uint64_t value, char *buffer, int uppercase);
+size_t sl_format_double(double value, int precision, char *buffer);
+
+size_t sl_format(char *buffer, size_t size, char *format, ...);
+size_t sl_format_buffer(char *buffer, size_t size, char *format, size_t length, va_list arguments);
+size_t sl_format_arguments(char *format, size_t length, uint8_t *arguments, size_t max);
+size_t sl_format_length(char *format, size_t length, va_list arguments);
+int sl_format_builder(sl_string_builder *builder, char *format, ...);
+int sl_format_builder_buffer(sl_string_builder *builder, char *format, size_t length, va_list arguments);
+
+#endif
@@ -1,126 +1,306 @@
 #include "sl_hashtable.h"
+#include "sl_view.h"
+#include "sl_probe.h"
 
-static bool sl_hashtable_are_keys_equal(sl_string *key_a, sl_string *key_b)
+#include <string.h>
+#include <sys/random.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define SL_HASHTABLE_NOT_FOUND ((size_t) -1)
+
+#define SL_HASHTABLE_SECRET_0 0x2d358dccaa6c78a5ull
+#define SL_HASHTABLE_SECRET_1 0x8bb84b93962eacc9ull
+#define SL_HASHTABLE_SECRET_2 0x4b33a62ed433d4a3ull
+#define SL_HASHTABLE_SECRET_3 0x4d5a2da51de1aa47ull
+
+static uint64_t sl_hashtable_seed = SL_HASHTABLE_SECRET_3;
+
+static inline uint64_t sl_hashtable_mix(uint64_t a, uint64_t b)
 {
-    if (key_a->length != key_b->length) {
-        return false;
-    }
+    __uint128_t product = (__uint128_t) a * b;
+
+    return (uint64_t) product ^ (uint64_t) (product >> 64);
+}
+
+static inline uint64_t sl_hashtable_read64(uint8_t *buffer)
+{
+    uint64_t value;
 
-    for (size_t n = 0; n < key_a->length; n ++) {
-        if (key_a->buffer[n] != key_b->buffer[n]) {
-            return false;
+    memcpy(&value, buffer, sizeof(value));
+
+    return value;
+}
+
+static inline uint64_t sl_hashtable_read32(uint8_t *buffer)
+{
+    uint32_t value;
+
+    memcpy(&value, buffer, sizeof(value));
+
+    return value;
+}
+
+sl_hashtable_hash sl_hashtable_hash_default(char *buffer, size_t length, uint64_t seed)
+{
+    uint8_t *data = (uint8_t *) buffer;
+    uint64_t a, b;
+
+    seed ^= sl_hashtable_mix(seed ^ SL_HASHTABLE_SECRET_0, SL_HASHTABLE_SECRET_1);
+
+    if (length <= 16) {
+        if (length >= 4) {
+            size_t offset = (length >> 3) << 2;
+
+            a = (sl_hashtable_read32(data) << 32) | sl_hashtable_read32(data + offset);
+            b = (sl_hashtable_read32(data + length - 4) << 32) | sl_hashtable_read32(data + length - 4 - offset);
+        } else if (length > 0) {
+            a = ((uint64_t) data[0] << 16) | ((uint64_t) data[length >> 1] << 8) | data[length - 1];
+            b = 0;
+        } else {
+            a = b = 0;
         }
+    } else {
+        size_t remaining = length;
+
+        if (remaining > 48) {
+            uint64_t seed_1 = seed, seed_2 = seed;
+
+            do {
+                seed = sl_hashtable_mix(sl_hashtable_read64(data) ^ SL_HASHTABLE_SECRET_1, sl_hashtable_read64(data + 8) ^ seed);
+                seed_1 = sl_hashtable_mix(sl_hashtable_read64(data + 16) ^ SL_HASHTABLE_SECRET_2, sl_hashtable_read64(data + 24) ^ seed_1);
+                seed_2 = sl_hashtable_mix(sl_hashtable_read64(data + 32) ^ SL_HASHTABLE_SECRET_3, sl_hashtable_read64(data + 40) ^ seed_2);
+                data += 48;
+                remaining -= 48;
+            } while (remaining > 48);
+
+            seed ^= seed_1 ^ seed_2;
+        }
+
+        while (remaining > 16) {
+            seed = sl_hashtable_mix(sl_hashtable_read64(data) ^ SL_HASHTABLE_SECRET_1, sl_hashtable_read64(data + 8) ^ seed);
+            data += 16;
+            remaining -= 16;
+        }
+
+        a = sl_hashtable_read64(data + remaining - 16);
+        b = sl_hashtable_read64(data + remaining - 8);
     }
 
-    return true;
+    __uint128_t product = (__uint128_t) (a ^ SL_HASHTABLE_SECRET_1) * (b ^ seed);
+
+    a = (uint64_t) product;
+    b = (uint64_t) (product >> 64);
+
+    return sl_hashtable_mix(a ^ SL_HASHTABLE_SECRET_0 ^ length, b ^ SL_HASHTABLE_SECRET_1);
 }
 
-static sl_hashtable_hash sl_hashtable_compute_hash(sl_string *key)
+void sl_hashtable_set_seed(uint64_t seed)
 {
-    sl_hashtable_hash hash = 0;
+    sl_hashtable_seed = seed;
+}
 
-    for (size_t n = 0; n < key->length; n ++) {
-        hash = key->buffer[n] + (hash << 5) - hash;
+int sl_hashtable_init_seed(void)
+{
+    uint64_t seed;
+
+    if (getrandom(&seed, sizeof(seed), 0) != sizeof(seed)) {
+        return -1;
     }
 
-    return hash;
+    sl_hashtable_set_seed(seed);
+
+    return 0;
 }
 
-static sl_hashtable_bucket *sl_hashtable_create_bucket(sl_arena *arena, sl_hashtable_hash hash, sl_string *key, sl_string *value)
+static inline sl_hashtable_hash sl_hashtable_compute_hash(sl_hashtable *hashtable, sl_string *key)
 {
-    sl_hashtable_bucket *bucket = sl_arena_allocate(arena, sizeof(sl_hashtable_bucket));
-    if (bucket == NULL) {
-        return NULL;
+    return hashtable->hash_function(key->buffer, key->length, sl_hashtable_seed);
+}
+
+static inline int8_t sl_hashtable_control(sl_hashtable_hash hash)
+{
+    return (int8_t) (hash & 0x7f);
+}
+
+static inline size_t sl_hashtable_first_group(sl_hashtable *hashtable, sl_hashtable_hash hash)
+{
+    return (hash >> 7) & (hashtable->size / SL_HASHTABLE_GROUP_SIZE - 1);
+}
+
+static inline size_t sl_hashtable_next_group(sl_hashtable *hashtable, size_t group, size_t step)
+{
+    return (group + step) & (hashtable->size / SL_HASHTABLE_GROUP_SIZE - 1);
+}
+
+#ifdef __SSE2__
+static inline uint32_t sl_hashtable_match(int8_t *controls, int8_t control)
+{
+    __m128i group = _mm_loadu_si128((__m128i *) controls);
+
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(control)));
+}
+
+static inline uint32_t sl_hashtable_match_free(int8_t *controls)
+{
+    return _mm_movemask_epi8(_mm_loadu_si128((__m128i *) controls));
+}
+#else
+static inline uint32_t sl_hashtable_match(int8_t *controls, int8_t control)
+{
+    uint32_t mask = 0;
+
+    for (size_t n = 0; n < SL_HASHTABLE_GROUP_SIZE; n ++) {
+        mask |= (uint32_t) (controls[n] == control) << n;
     }
 
-    bucket->next = NULL;
-    bucket->hash = hash;
-    bucket->key = key;
-    bucket->value = value;
+    return mask;
+}
+
+static inline uint32_t sl_hashtable_match_free(int8_t *controls)
+{
+    uint32_t mask = 0;
+
+    for (size_t n = 0; n < SL_HASHTABLE_GROUP_SIZE; n ++) {
+        mask |= (uint32_t) (controls[n] < 0) << n;
+    }
 
-    return bucket;
+    return mask;
 }
+#endif
 
-static int sl_hashtable_allocate(sl_hashtable *hashtable, size_t size)
+static size_t sl_hashtable_find(sl_hashtable *hashtable, sl_hashtable_hash hash, sl_string *key)
 {
-    size_t new_pow2_size = sl_arena_pow2_size(size);
-    size_t new_size = new_pow2_size < hashtable->preallocate ? hashtable->preallocate : new_pow2_size;
+    if (hashtable->size == 0) {
+        return SL_HASHTABLE_NOT_FOUND;
+    }
 
-    sl_hashtable_bucket **buckets = sl_arena_allocate(hashtable->arena, sizeof(sl_hashtable_bucket*) * new_size);
-    if (buckets == NULL) {
-        return -1;
+    int8_t control = sl_hashtable_control(hash);
+    size_t groups = hashtable->size / SL_HASHTABLE_GROUP_SIZE;
+    size_t group = sl_hashtable_first_group(hashtable, hash);
+
+    for (size_t step = 1; step <= groups; step ++) {
+        int8_t *controls = hashtable->controls + group * SL_HASHTABLE_GROUP_SIZE;
+
+        for (uint32_t mask = sl_hashtable_match(controls, control); mask != 0; mask &= mask - 1) {
+            size_t slot = group * SL_HASHTABLE_GROUP_SIZE + __builtin_ctz(mask);
+            sl_hashtable_entry *entry = &hashtable->entries[slot];
+
+            if (entry->hash == hash && sl_view_equal(entry->key, key) == true) {
+                return slot;
+            }
+        }
+
+        if (sl_hashtable_match(controls, SL_HASHTABLE_CONTROL_EMPTY) != 0) {
+            return SL_HASHTABLE_NOT_FOUND;
+        }
+
+        group = sl_hashtable_next_group(hashtable, group, step);
     }
 
-    hashtable->buckets = buckets;
-    hashtable->size = new_size;
-    hashtable->count = 0;
+    return SL_HASHTABLE_NOT_FOUND;
+}
 
-    for (size_t n = 0; n < hashtable->size; n ++) {
-        hashtable->buckets[n] = NULL;
+static size_t sl_hashtable_find_free(sl_hashtable *hashtable, sl_hashtable_hash hash, size_t max_probe_groups)
+{
+    size_t groups = hashtable->size / SL_HASHTABLE_GROUP_SIZE;
+    size_t group = sl_hashtable_first_group(hashtable, hash);
+
+    for (size_t step = 1; step <= groups && step <= max_probe_groups; step ++) {
+        uint32_t mask = sl_hashtable_match_free(hashtable->controls + group * SL_HASHTABLE_GROUP_SIZE);
+        if (mask != 0) {
+            return group * SL_HASHTABLE_GROUP_SIZE + __builtin_ctz(mask);
+        }
+
+        group = sl_hashtable_next_group(hashtable, group, step);
     }
 
-    return 0;
+    return SL_HASHTABLE_NOT_FOUND;
 }
 
-static int sl_hashtable_resize(sl_hashtable *hashtable, size_t size)
+static size_t sl_hashtable_storage_size(size_t size)
 {
-    size_t new_pow2_size = sl_arena_pow2_size(size);
-    if (new_pow2_size <= hashtable->size) {
-        return 0;
+    return size * sizeof(int8_t) + size * sizeof(sl_hashtable_entry);
+}
+
+static void sl_hashtable_release(sl_hashtable *hashtable, int8_t *controls, size_t size)
+{
+    if (controls == NULL) {
+        return;
     }
 
-    sl_hashtable_bucket **new_buckets = sl_arena_allocate(hashtable->arena, sizeof(sl_hashtable_bucket*) * new_pow2_size);
-    if (new_buckets == NULL) {
-        return -1;
+    if (hashtable->arena != NULL) {
+        sl_arena_free(hashtable->arena, controls, sl_hashtable_storage_size(size));
+    } else {
+        free(controls);
     }
+}
+
+static int sl_hashtable_allocate(sl_hashtable *hashtable, size_t size)
+{
+    size_t new_pow2_size = sl_arena_pow2_size(size);
+    size_t new_size = new_pow2_size < SL_HASHTABLE_GROUP_SIZE ? SL_HASHTABLE_GROUP_SIZE : new_pow2_size;
+
+    int8_t *old_controls = hashtable->controls;
+    sl_hashtable_entry *old_entries = hashtable->entries;
+    size_t old_size = hashtable->size;
 
-    for (size_t n = 0; n < new_pow2_size; n ++) {
-        new_buckets[n] = NULL;
+    size_t storage_size = sl_hashtable_storage_size(new_size);
+    int8_t *controls = hashtable->arena != NULL ? sl_arena_allocate(hashtable->arena, storage_size) : malloc(storage_size);
+    if (controls == NULL) {
+        return -1;
     }
 
-    for (size_t n = 0; n < hashtable->size; n ++) {
-        sl_hashtable_bucket *bucket = hashtable->buckets[n];
-        if (bucket == NULL) {
+    memset(controls, SL_HASHTABLE_CONTROL_EMPTY, new_size);
+
+    hashtable->controls = controls;
+    hashtable->entries = (sl_hashtable_entry *) (controls + new_size);
+    hashtable->size = new_size;
+    hashtable->deleted = 0;
+
+    size_t groups = new_size / SL_HASHTABLE_GROUP_SIZE;
+
+    for (size_t n = 0; n < old_size; n ++) {
+        if (old_controls[n] < 0) {
             continue;
         }
 
-        for (sl_hashtable_bucket *node = bucket; node != NULL; node = node->next) {
-            sl_hashtable_hash original_hash = node->hash;
-            sl_hashtable_hash hash = original_hash & (new_pow2_size - 1);
+        size_t slot = sl_hashtable_find_free(hashtable, old_entries[n].hash, groups);
 
-            sl_hashtable_bucket *new_bucket = new_buckets[hash];
-            if (new_bucket == NULL) {
-                new_buckets[hash] = sl_hashtable_create_bucket(hashtable->arena, node->hash, node->key, node->value);
-                if (new_buckets[hash] == NULL) {
-                    return -1;
-                }
+        hashtable->controls[slot] = old_controls[n];
+        hashtable->entries[slot] = old_entries[n];
+    }
 
-                hashtable->wasted += sizeof(sl_hashtable_bucket);
-                continue;
-            }
+    sl_hashtable_release(hashtable, old_controls, old_size);
 
-            sl_hashtable_bucket *new_node;
-            for (new_node = new_bucket; new_node->next != NULL; new_node = new_node->next);
+    return 0;
+}
 
-            new_node->next = sl_hashtable_create_bucket(hashtable->arena, node->hash, node->key, node->value);
-            if (new_node->next == NULL) {
-                return -1;
-            }
+static int sl_hashtable_reserve(sl_hashtable *hashtable)
+{
+    if (hashtable->size == 0) {
+        return sl_hashtable_allocate(hashtable, hashtable->preallocate);
+    }
 
-            hashtable->wasted += sizeof(sl_hashtable_bucket);
-        }
+    if ((hashtable->count + hashtable->deleted + 1) * 100 <= hashtable->size * SL_HASHTABLE_MAX_LOAD) {
+        return 0;
+    }
+
+    if ((hashtable->count + 1) * 100 <= hashtable->size * SL_HASHTABLE_MAX_LOAD / 2) {
+        return sl_hashtable_allocate(hashtable, hashtable->size);
+    }
+
+    if (hashtable->resize == false) {
+        return (hashtable->count + 1) * 100 <= hashtable->size * SL_HASHTABLE_MAX_LOAD ? sl_hashtable_allocate(hashtable, hashtable->size) : -1;
     }
 
     hashtable->resizes ++;
-    hashtable->wasted += hashtable->size * sizeof(sl_hashtable_bucket*);
-    hashtable->buckets = new_buckets;
-    hashtable->size = new_pow2_size;
 
-    return 0;
-}
+    SL_PROBE4(hashtable__resize, hashtable, hashtable->size, hashtable->size << 1, hashtable->count);
 
-static bool sl_hashtable_needs_resize(sl_hashtable *hashtable) {
-    return hashtable->resize == true && hashtable->count * 100 / hashtable->size >= SL_HASHTABLE_MAX_LOAD;
+    return sl_hashtable_allocate(hashtable, hashtable->size << 1);
 }
 
 void sl_hashtable_init(sl_hashtable *hashtable, sl_arena *arena, size_t preallocate, bool resize)
@@ -128,81 +308,103 @@ void sl_hashtable_init(sl_hashtable *hashtable, sl_arena *arena, size_t prealloc
     *hashtable = (sl_hashtable) {0};
 
     hashtable->arena = arena;
+    hashtable->hash_function = sl_hashtable_hash_default;
+    hashtable->max_probe_groups = SL_HASHTABLE_MAX_PROBE_GROUPS;
     hashtable->preallocate = sl_arena_pow2_size(preallocate);
     hashtable->resize = resize;
 }
 
-sl_string *sl_hashtable_get(sl_hashtable *hashtable, sl_string *key)
+void sl_hashtable_destroy(sl_hashtable *hashtable)
 {
-    sl_hashtable_hash original_hash = sl_hashtable_compute_hash(key);
+    sl_hashtable_hash_function hash_function = hashtable->hash_function;
+    size_t max_probe_groups = hashtable->max_probe_groups;
 
-    for (size_t n = 0; n < hashtable->size; n ++) {
-        sl_hashtable_bucket *bucket = hashtable->buckets[n];
-        if (bucket == NULL) {
-            continue;
-        }
+    sl_hashtable_release(hashtable, hashtable->controls, hashtable->size);
+    sl_hashtable_init(hashtable, hashtable->arena, hashtable->preallocate, hashtable->resize);
 
-        for (sl_hashtable_bucket *node = bucket; node != NULL; node = node->next) {
-            if (node->hash == original_hash && sl_hashtable_are_keys_equal(node->key, key) == true) {
-
-                return node->value;
-            }
-        }
-    }
+    hashtable->hash_function = hash_function;
+    hashtable->max_probe_groups = max_probe_groups;
+}
 
-    return NULL;
+void sl_hashtable_set_hash_function(sl_hashtable *hashtable, sl_hashtable_hash_function hash_function)
+{
+    hashtable->hash_function = hash_function;
 }
 
-int sl_hashtable_set(sl_hashtable *hashtable, sl_string *key, sl_string *value)
+sl_string *sl_hashtable_get(sl_hashtable *hashtable, sl_string *key)
 {
-    if (hashtable->size == 0 && sl_hashtable_allocate(hashtable, hashtable->preallocate) == -1) {
-        return -1;
+    size_t slot = sl_hashtable_find(hashtable, sl_hashtable_compute_hash(hashtable, key), key);
+    if (slot == SL_HASHTABLE_NOT_FOUND) {
+        return NULL;
     }
 
-    sl_hashtable_hash original_hash = sl_hashtable_compute_hash(key);
-    sl_hashtable_hash hash = original_hash & (hashtable->size - 1);
-
-    sl_hashtable_bucket *bucket = hashtable->buckets[hash];
-    if (bucket == NULL) {
-        bucket = sl_hashtable_create_bucket(hashtable->arena, original_hash, key, value);
-        if (bucket == NULL) {
-            return -1;
-        }
+    return hashtable->entries[slot].value;
+}
 
-        hashtable->buckets[hash] = bucket;
-        hashtable->count ++;
+int sl_hashtable_set(sl_hashtable *hashtable, sl_string *key, sl_string *value)
+{
+    sl_hashtable_hash hash = sl_hashtable_compute_hash(hashtable, key);
 
-        if (sl_hashtable_needs_resize(hashtable) && sl_hashtable_resize(hashtable, hashtable->size << 1) == -1) {
-            return -1;
-        }
+    size_t slot = sl_hashtable_find(hashtable, hash, key);
+    if (slot != SL_HASHTABLE_NOT_FOUND) {
+        hashtable->entries[slot].key = key;
+        hashtable->entries[slot].value = value;
 
         return 0;
     }
 
-    sl_hashtable_bucket *last_bucket = bucket;
-
-    for (sl_hashtable_bucket *node = bucket; node != NULL; node = node->next) {
-        last_bucket = node;
-        if (node->hash != original_hash || sl_hashtable_are_keys_equal(node->key, key) == false) {
-            continue;
-        }
-
-        node->key = key;
-        node->value = value;
-
-        return 0;
+    if (sl_hashtable_reserve(hashtable) == -1) {
+        return -1;
     }
 
-    last_bucket->next = sl_hashtable_create_bucket(hashtable->arena, original_hash, key, value);
-    if (last_bucket->next == NULL) {
+    slot = sl_hashtable_find_free(hashtable, hash, hashtable->max_probe_groups);
+    if (slot == SL_HASHTABLE_NOT_FOUND) {
+        hashtable->rejected ++;
         return -1;
     }
 
+    if (hashtable->controls[slot] == SL_HASHTABLE_CONTROL_DELETED) {
+        hashtable->deleted --;
+    }
+
+    hashtable->controls[slot] = sl_hashtable_control(hash);
+    hashtable->entries[slot] = (sl_hashtable_entry) {hash, key, value};
     hashtable->count ++;
 
-    if (sl_hashtable_needs_resize(hashtable) && sl_hashtable_resize(hashtable, hashtable->size << 1) == -1) {
+    return 0;
+}
+
+int sl_hashtable_delete(sl_hashtable *hashtable, sl_string *key)
+{
+    size_t slot = sl_hashtable_find(hashtable, sl_hashtable_compute_hash(hashtable, key), key);
+    if (slot == SL_HASHTABLE_NOT_FOUND) {
         return -1;
     }
 
+    int8_t *controls = hashtable->controls + slot / SL_HASHTABLE_GROUP_SIZE * SL_HASHTABLE_GROUP_SIZE;
+
+    if (sl_hashtable_match(controls, SL_HASHTABLE_CONTROL_EMPTY) != 0) {
+        hashtable->controls[slot] = SL_HASHTABLE_CONTROL_EMPTY;
+    } else {
+        hashtable->controls[slot] = SL_HASHTABLE_CONTROL_DELETED;
+        hashtable->deleted ++;
+    }
+
+    hashtable->count --;
+
     return 0;
 }
+
+sl_hashtable_entry *sl_hashtable_next(sl_hashtable *hashtable, size_t *position)
+{
+    for (size_t n = *position; n < hashtable->size; n ++) {
+        if (hashtable->controls[n] >= 0) {
+            *position = n + 1;
+            return &hashtable->entries[n];
+        }
+    }
+
+    *position = hashtable->size;
+
+    return NULL;
+}
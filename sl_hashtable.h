@@ -2,38 +2,56 @@
 #define SL_HASHTABLE_H
 
 #include <stdlib.h>
+#include <stdint.h>
 #include <stdbool.h>
 
 #include "sl_arena.h"
 #include "sl_string.h"
 
-#define SL_HASHTABLE_MAX_LOAD 75
+#define SL_HASHTABLE_MAX_LOAD          75
+#define SL_HASHTABLE_GROUP_SIZE        16
+#define SL_HASHTABLE_MAX_PROBE_GROUPS   8
+
+#define SL_HASHTABLE_CONTROL_EMPTY   ((int8_t) -128)
+#define SL_HASHTABLE_CONTROL_DELETED ((int8_t) -2)
 
 typedef size_t sl_hashtable_hash;
+typedef sl_hashtable_hash (*sl_hashtable_hash_function)(char *buffer, size_t length, uint64_t seed);
 
-typedef struct sl_hashtable_bucket sl_hashtable_bucket;
+typedef struct sl_hashtable_entry sl_hashtable_entry;
 typedef struct sl_hashtable sl_hashtable;
 
-struct sl_hashtable_bucket {
-    sl_hashtable_bucket *next;
+struct sl_hashtable_entry {
     sl_hashtable_hash hash;
     sl_string *key;
     sl_string *value;
 };
 
 struct sl_hashtable {
-    sl_hashtable_bucket **buckets;
+    int8_t *controls;
+    sl_hashtable_entry *entries;
     sl_arena *arena;
+    sl_hashtable_hash_function hash_function;
     bool resize;
+    size_t max_probe_groups;
     size_t preallocate;
     size_t size;
     size_t count;
+    size_t deleted;
     size_t resizes;
-    size_t wasted;
+    size_t rejected;
 };
 
+sl_hashtable_hash sl_hashtable_hash_default(char *buffer, size_t length, uint64_t seed);
+void sl_hashtable_set_seed(uint64_t seed);
+int sl_hashtable_init_seed(void);
+
 void sl_hashtable_init(sl_hashtable *hashtable, sl_arena *arena, size_t preallocate, bool resize);
+void sl_hashtable_destroy(sl_hashtable *hashtable);
+void sl_hashtable_set_hash_function(sl_hashtable *hashtable, sl_hashtable_hash_function hash_function);
 sl_string *sl_hashtable_get(sl_hashtable *hashtable, sl_string *key);
 int sl_hashtable_set(sl_hashtable *hashtable, sl_string *key, sl_string *value);
+int sl_hashtable_delete(sl_hashtable *hashtable, sl_string *key);
+sl_hashtable_entry *sl_hashtable_next(sl_hashtable *hashtable, size_t *position);
 
 #endif
@@ -5,31 +5,34 @@
 #include <unistd.h>
 #include <string.h>
 #include <errno.h>
+#include <limits.h>
 #include <time.h>
 
+#include <sys/uio.h>
 #include <arpa/inet.h>
 
-#include "sl_string.h"
+#include "sl_format.h"
 
 static char *sl_log_levels[SL_LOG_MAX] = {
     "[debug] ", "[info] ", "[error] "
 };
 
+static sl_log_site sl_log_raw_site = {.format = "%S"};
+
+static time_t sl_log_date_time = -1;
+static char sl_log_date[SL_LOG_MAX_DATE_LENGTH];
+static size_t sl_log_date_length;
+
 static void sl_log_itoa(uint32_t value, char *buffer, size_t length)
 {
-    size_t value_length = 0;
+    char digits[SL_FORMAT_MAX_NUMBER_LENGTH];
 
-    while (value > 0 && length-- > 0) {
-        uint8_t digit = '0' + (value % 10);
-        buffer[length] = digit;
-        value /= 10;
-        value_length ++;
-    }
-
-    for (size_t n = 0; n < value_length; n ++) {
-        buffer[n] = buffer[n + length];
+    size_t value_length = sl_format_unsigned(value, digits);
+    if (value_length >= length) {
+        value_length = length - 1;
     }
 
+    memcpy(buffer, digits, value_length);
     buffer[value_length] = 0;
 }
 
@@ -45,6 +48,297 @@ static void sl_log_append(char *dest, size_t dest_size, char *src, size_t src_si
     return;
 }
 
+int sl_log_ring_init(sl_log_ring *ring, size_t size, sl_log_overflow overflow, int log_fd)
+{
+    *ring = (sl_log_ring) {0};
+
+    ring->size = sl_arena_pow2_size(size < SL_LOG_MAX_MESSAGE_LENGTH ? SL_LOG_MAX_MESSAGE_LENGTH : size);
+    ring->entry_size = ring->size / SL_LOG_RING_ENTRY_SIZE;
+    ring->overflow = overflow;
+    ring->log_fd = log_fd;
+
+    ring->buffer = malloc(ring->size);
+    if (ring->buffer == NULL) {
+        return -1;
+    }
+
+    ring->entries = malloc(ring->entry_size * sizeof(uint16_t));
+    if (ring->entries == NULL) {
+        free(ring->buffer);
+        ring->buffer = NULL;
+        return -1;
+    }
+
+    return 0;
+}
+
+int sl_log_ring_flush(sl_log_ring *ring)
+{
+    int saved_errno = errno;
+
+    while (ring->entry_tail != ring->entry_head) {
+        size_t pending = 0, entries = 0;
+
+        while (ring->entry_tail + entries != ring->entry_head) {
+            size_t length = ring->entries[(ring->entry_tail + entries) & (ring->entry_size - 1)];
+            if (pending + length > PIPE_BUF) {
+                break;
+            }
+
+            pending += length;
+            entries ++;
+        }
+
+        size_t written = 0;
+
+        while (written < pending) {
+            size_t offset = (ring->tail + written) & (ring->size - 1), remaining = pending - written;
+            size_t first = remaining < ring->size - offset ? remaining : ring->size - offset;
+
+            struct iovec buffers[2] = {
+                {ring->buffer + offset, first},
+                {ring->buffer, remaining - first}
+            };
+
+            ssize_t result = writev(ring->log_fd, buffers, remaining > first ? 2 : 1);
+            if (result == -1 && errno == EINTR) {
+                continue;
+            } else if (result == -1) {
+                break;
+            }
+
+            written += result;
+        }
+
+        if (written < pending) {
+            if (written > 0) {
+                ring->tail += pending;
+                ring->entry_tail += entries;
+                ring->dropped += entries;
+            }
+
+            errno = saved_errno;
+            return -1;
+        }
+
+        ring->tail += pending;
+        ring->entry_tail += entries;
+    }
+
+    ring->flushes ++;
+    errno = saved_errno;
+
+    return 0;
+}
+
+void sl_log_ring_destroy(sl_log_ring *ring)
+{
+    sl_log_ring_flush(ring);
+
+    free(ring->buffer);
+    free(ring->entries);
+    ring->buffer = NULL;
+    ring->entries = NULL;
+}
+
+static void sl_log_ring_push(sl_log_ring *ring, char *buffer, size_t length)
+{
+    if (length > ring->size - (ring->head - ring->tail) || ring->entry_head - ring->entry_tail == ring->entry_size) {
+        if (ring->overflow == SL_LOG_OVERFLOW_DROP || sl_log_ring_flush(ring) == -1) {
+            ring->dropped ++;
+            return;
+        }
+    }
+
+    size_t offset = ring->head & (ring->size - 1);
+    size_t first = length < ring->size - offset ? length : ring->size - offset;
+
+    memcpy(ring->buffer + offset, buffer, first);
+    memcpy(ring->buffer, buffer + first, length - first);
+
+    ring->entries[ring->entry_head & (ring->entry_size - 1)] = length;
+    ring->entry_head ++;
+    ring->head += length;
+    ring->lines ++;
+}
+
+static void sl_log_emit(sl_log *log, char *buffer, size_t length)
+{
+    if (log->ring != NULL) {
+        sl_log_ring_push(log->ring, buffer, length);
+        return;
+    }
+
+    write(log->log_fd, buffer, length);
+}
+
+static void sl_log_site_init(sl_log_site *site)
+{
+    site->format_length = strlen(site->format);
+    site->id = sl_log_site_id(site->format, site->format_length);
+
+    size_t count = sl_format_arguments(site->format, site->format_length, site->arguments, SL_LOG_MAX_ARGUMENTS);
+    site->count = count == SIZE_MAX ? UINT8_MAX : count;
+}
+
+static void sl_log_write_record_header(sl_log *log, sl_log_level level, sl_log_record_type type, sl_log_site *site, char *buffer, size_t length, size_t suppressed)
+{
+    struct timespec timestamp;
+
+    clock_gettime(CLOCK_REALTIME_COARSE, &timestamp);
+
+    sl_log_record record = {
+        .length = length,
+        .type = type,
+        .level = level,
+        .count = site->count,
+        .id = site->id,
+        .pid = log->process_id,
+        .timestamp = (uint64_t) timestamp.tv_sec * 1000000000 + timestamp.tv_nsec,
+        .address = log->address,
+        .port = log->port,
+        .error = type == SL_LOG_RECORD_EVENT && level == SL_LOG_ERROR ? errno : 0,
+        .suppressed = suppressed < UINT32_MAX ? suppressed : UINT32_MAX
+    };
+
+    memcpy(record.magic, SL_LOG_RECORD_MAGIC, SL_LOG_RECORD_MAGIC_SIZE);
+    memcpy(buffer, &record, sizeof(record));
+}
+
+static void sl_log_write_record_define(sl_log *log, sl_log_level level, sl_log_site *site)
+{
+    char buffer[SL_LOG_MAX_MESSAGE_LENGTH];
+    size_t length = sizeof(sl_log_record);
+
+    size_t format_length = site->format_length;
+    if (format_length > sizeof(buffer) - length - site->count) {
+        format_length = sizeof(buffer) - length - site->count;
+    }
+
+    memcpy(buffer + length, site->arguments, site->count);
+    length += site->count;
+
+    memcpy(buffer + length, site->format, format_length);
+    length += format_length;
+
+    sl_log_write_record_header(log, level, SL_LOG_RECORD_DEFINE, site, buffer, length, 0);
+    sl_log_emit(log, buffer, length);
+
+    site->defined = true;
+}
+
+static void sl_log_write_record(sl_log *log, sl_log_level level, sl_log_site *site, size_t suppressed, va_list arguments)
+{
+    char buffer[SL_LOG_MAX_MESSAGE_LENGTH];
+    size_t length = sizeof(sl_log_record);
+
+    if (site->defined == false) {
+        sl_log_write_record_define(log, level, site);
+    }
+
+    for (size_t n = 0; n < site->count; n ++) {
+        uint64_t value = 0;
+        char *string = NULL;
+        size_t string_length = 0;
+
+        switch (site->arguments[n]) {
+            case SL_FORMAT_ARGUMENT_INT:
+                value = (int64_t) va_arg(arguments, int);
+                break;
+            case SL_FORMAT_ARGUMENT_LONG:
+                value = (int64_t) va_arg(arguments, long);
+                break;
+            case SL_FORMAT_ARGUMENT_UNSIGNED:
+                value = va_arg(arguments, unsigned int);
+                break;
+            case SL_FORMAT_ARGUMENT_UNSIGNED_LONG:
+                value = va_arg(arguments, unsigned long);
+                break;
+            case SL_FORMAT_ARGUMENT_SIZE:
+                value = va_arg(arguments, size_t);
+                break;
+            case SL_FORMAT_ARGUMENT_POINTER:
+                value = (uintptr_t) va_arg(arguments, void *);
+                break;
+            case SL_FORMAT_ARGUMENT_DOUBLE:
+                double number = va_arg(arguments, double);
+                memcpy(&value, &number, sizeof(value));
+                break;
+            case SL_FORMAT_ARGUMENT_CSTRING:
+                string = va_arg(arguments, char *);
+                string_length = string != NULL ? strlen(string) : 0;
+                break;
+            case SL_FORMAT_ARGUMENT_STRING:
+                sl_string *argument = va_arg(arguments, sl_string *);
+                if (argument != NULL) {
+                    string = argument->buffer;
+                    string_length = argument->length;
+                }
+                break;
+        }
+
+        if (site->arguments[n] != SL_FORMAT_ARGUMENT_CSTRING && site->arguments[n] != SL_FORMAT_ARGUMENT_STRING) {
+            if (length + sizeof(value) > sizeof(buffer)) {
+                return;
+            }
+
+            memcpy(buffer + length, &value, sizeof(value));
+            length += sizeof(value);
+            continue;
+        }
+
+        if (length + sizeof(uint32_t) > sizeof(buffer)) {
+            return;
+        }
+
+        if (string_length > sizeof(buffer) - length - sizeof(uint32_t)) {
+            string_length = sizeof(buffer) - length - sizeof(uint32_t);
+        }
+
+        uint32_t encoded_length = string_length;
+
+        memcpy(buffer + length, &encoded_length, sizeof(encoded_length));
+        memcpy(buffer + length + sizeof(encoded_length), string, string_length);
+        length += sizeof(encoded_length) + string_length;
+    }
+
+    sl_log_write_record_header(log, level, SL_LOG_RECORD_EVENT, site, buffer, length, suppressed);
+    sl_log_emit(log, buffer, length);
+
+    if (level == SL_LOG_ERROR) {
+        errno = 0;
+    }
+}
+
+static void sl_log_write_record_format(sl_log *log, sl_log_level level, sl_log_site *site, size_t suppressed, ...)
+{
+    va_list arguments;
+
+    if (site->id == 0) {
+        sl_log_site_init(site);
+    }
+
+    va_start(arguments, suppressed);
+    sl_log_write_record(log, level, site, suppressed, arguments);
+    va_end(arguments);
+}
+
+static void sl_log_update_date(void)
+{
+    time_t timestamp = time(NULL);
+
+    if (timestamp == sl_log_date_time) {
+        return;
+    }
+
+    struct tm local_time;
+
+    localtime_r(&timestamp, &local_time);
+
+    sl_log_date_length = strftime(sl_log_date, SL_LOG_MAX_DATE_LENGTH, "%D %T ", &local_time);
+    sl_log_date_time = timestamp;
+}
+
 void sl_log_init(sl_log *log, sl_log_level min_level, int log_fd)
 {
     *log = (sl_log) {0};
@@ -53,24 +347,112 @@ void sl_log_init(sl_log *log, sl_log_level min_level, int log_fd)
     log->log_fd = log_fd;
 }
 
+void sl_log_init_with_parent(sl_log *log, sl_log *parent)
+{
+    sl_log inherited = *parent;
+
+    sl_log_init(log, inherited.min_level, inherited.log_fd);
+
+    memcpy(log->pid, inherited.pid, SL_LOG_MAX_PID_LENGTH);
+    log->process_id = inherited.process_id;
+    log->mode = inherited.mode;
+    log->ring = inherited.ring;
+}
+
+inline void sl_log_set_ring(sl_log *log, sl_log_ring *ring)
+{
+    log->ring = ring;
+}
+
+inline void sl_log_set_mode(sl_log *log, sl_log_mode mode)
+{
+    log->mode = mode;
+}
+
+inline void sl_log_set_min_level(sl_log *log, sl_log_level min_level)
+{
+    log->min_level = min_level;
+}
+
+bool sl_log_limit_pass(sl_log_limit *limit, size_t *suppressed)
+{
+    time_t now = time(NULL);
+
+    if (limit->window != 0 && now - limit->window < SL_LOG_LIMIT_INTERVAL) {
+        limit->suppressed ++;
+        return false;
+    }
+
+    *suppressed = limit->suppressed;
+
+    limit->window = now;
+    limit->suppressed = 0;
+
+    return true;
+}
+
+uint32_t sl_log_site_id(char *format, size_t length)
+{
+    uint32_t hash = 2166136261u;
+
+    for (size_t n = 0; n < length; n ++) {
+        hash = (hash ^ (uint8_t) format[n]) * 16777619u;
+    }
+
+    return hash != 0 ? hash : 1;
+}
+
 inline void sl_log_write(sl_log *log, sl_log_level level, char *message)
 {
     sl_log_write_buffer(log, level, message, strlen(message));
 }
 
-void sl_log_write_format(sl_arena *arena, sl_log *log, sl_log_level level, char *format, ...)
+void sl_log_write_format(sl_log *log, sl_log_level level, char *format, ...)
 {
+    if (level < log->min_level) {
+        return;
+    }
+
     va_list arguments;
+    char message[SL_LOG_MAX_MESSAGE_LENGTH];
 
     va_start(arguments, format);
-    sl_string *message = sl_string_format_buffer(arena, format, strlen(format), arguments);
+    size_t length = sl_format_buffer(message, sizeof(message), format, strlen(format), arguments);
     va_end(arguments);
 
-    if (message != NULL) {
-        sl_log_write_buffer(log, level, message->buffer, message->length);
-    } else {
-        sl_log_write_buffer(log, level, format, strlen(format));
+    sl_log_write_buffer(log, level, message, length < sizeof(message) ? length : sizeof(message) - 1);
+}
+
+void sl_log_write_site(sl_log *log, sl_log_level level, sl_log_site *site, size_t suppressed, ...)
+{
+    if (level < log->min_level || level >= SL_LOG_MAX) {
+        return;
     }
+
+    va_list arguments;
+
+    if (site->id == 0) {
+        sl_log_site_init(site);
+    }
+
+    va_start(arguments, suppressed);
+
+    if (log->mode == SL_LOG_MODE_BINARY && site->count != UINT8_MAX) {
+        sl_log_write_record(log, level, site, suppressed, arguments);
+        va_end(arguments);
+        return;
+    }
+
+    char message[SL_LOG_MAX_MESSAGE_LENGTH];
+    size_t length = sl_format_buffer(message, sizeof(message), site->format, site->format_length, arguments);
+
+    va_end(arguments);
+
+    if (length < sizeof(message) && suppressed > 0) {
+        length += sl_format(message + length, sizeof(message) - length, " (%z similar messages suppressed)", suppressed);
+    }
+
+    sl_log_write_buffer(log, level, message, length < sizeof(message) ? length : sizeof(message) - 1);
 }
 
 void sl_log_write_buffer(sl_log *log, sl_log_level level, char *message, size_t length)
@@ -79,15 +461,19 @@ void sl_log_write_buffer(sl_log *log, sl_log_level level, char *message, size_t
         return;
     }
 
-    char log_buffer[SL_LOG_MAX_MESSAGE_LENGTH] = {0};
+    if (log->mode == SL_LOG_MODE_BINARY) {
+        sl_string string = sl_string_init_with_buffer(message, length);
+
+        sl_log_write_record_format(log, level, &sl_log_raw_site, 0, &string);
+        return;
+    }
+
+    char log_buffer[SL_LOG_MAX_MESSAGE_LENGTH];
     size_t log_buffer_size = 0;
 
-    time_t timestamp = time(NULL);
-    struct tm *local_time = localtime(&timestamp);
-    char date_buffer[SL_LOG_MAX_DATE_LENGTH];
-    size_t date_length = strftime(date_buffer, SL_LOG_MAX_DATE_LENGTH, "%D %T ", local_time);
+    sl_log_update_date();
 
-    sl_log_append(log_buffer, SL_LOG_MAX_MESSAGE_LENGTH, date_buffer, date_length, &log_buffer_size);
+    sl_log_append(log_buffer, SL_LOG_MAX_MESSAGE_LENGTH, sl_log_date, sl_log_date_length, &log_buffer_size);
     sl_log_append(log_buffer, SL_LOG_MAX_MESSAGE_LENGTH, sl_log_levels[level], strlen(sl_log_levels[level]), &log_buffer_size);
 
     if (log->pid[0] != 0) {
@@ -114,16 +500,19 @@ void sl_log_write_buffer(sl_log *log, sl_log_level level, char *message, size_t
 
     sl_log_append(log_buffer, SL_LOG_MAX_MESSAGE_LENGTH, "\n", 1, &log_buffer_size);
 
-    write(log->log_fd, log_buffer, log_buffer_size);
+    sl_log_emit(log, log_buffer, log_buffer_size);
 }
 
 void sl_log_set_pid(sl_log *log, pid_t pid)
 {
     sl_log_itoa(pid, log->pid, SL_LOG_MAX_PID_LENGTH);
+    log->process_id = pid;
 }
 
 void sl_log_set_ip_address_port(sl_log *log, struct sockaddr_in *address)
 {
     memcpy(log->ip_address, inet_ntoa(address->sin_addr), SL_LOG_MAX_IP_LENGTH - 1);
+    log->address = address->sin_addr.s_addr;
+    log->port = address->sin_port;
     sl_log_itoa(ntohs(address->sin_port), log->ip_port, SL_LOG_MAX_PORT_LENGTH);
 }
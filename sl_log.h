@@ -7,15 +7,55 @@
 #define SL_LOG_MAX_ARG_LENGTH       11
 #define SL_LOG_MAX_IP_LENGTH        16
 #define SL_LOG_MAX_PORT_LENGTH       6
+#define SL_LOG_RING_DEFAULT_SIZE (64 * 1024)
+#define SL_LOG_RING_ENTRY_SIZE      32
+#define SL_LOG_LIMIT_INTERVAL        1
+#define SL_LOG_MAX_ARGUMENTS        16
+#define SL_LOG_RECORD_MAGIC     "SLOG"
+#define SL_LOG_RECORD_MAGIC_SIZE     4
+
+#ifndef SL_LOG_COMPILE_LEVEL
+#define SL_LOG_COMPILE_LEVEL SL_LOG_DEBUG
+#endif
+
+#define SL_LOG_ENABLED(log, level) ((level) >= SL_LOG_COMPILE_LEVEL && (level) >= (log)->min_level)
+
+#define SL_LOG_WRITE(log, level, message) SL_LOG_WRITE_FORMAT(log, level, message)
+
+#define SL_LOG_WRITE_FORMAT(log, level, site_format, ...) do { \
+    static sl_log_site sl_log_site_format = {.format = site_format}; \
+    if (SL_LOG_ENABLED(log, level)) { \
+        sl_log_write_site(log, level, &sl_log_site_format, 0 __VA_OPT__(,) __VA_ARGS__); \
+    } \
+} while (0)
+
+#define SL_LOG_WRITE_LIMITED(log, level, message) do { \
+    static sl_log_site sl_log_site_limited = {.format = message}; \
+    static sl_log_limit sl_log_site_limit; \
+    size_t sl_log_suppressed; \
+    if (SL_LOG_ENABLED(log, level) && sl_log_limit_pass(&sl_log_site_limit, &sl_log_suppressed) == true) { \
+        sl_log_write_site(log, level, &sl_log_site_limited, sl_log_suppressed); \
+    } \
+} while (0)
 
 #include <stdarg.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
 #include <sys/types.h>
 #include <netinet/in.h>
 
 #include "sl_arena.h"
 
 typedef enum sl_log_level sl_log_level;
+typedef enum sl_log_overflow sl_log_overflow;
+typedef enum sl_log_mode sl_log_mode;
+typedef enum sl_log_record_type sl_log_record_type;
 
+typedef struct sl_log_ring sl_log_ring;
+typedef struct sl_log_limit sl_log_limit;
+typedef struct sl_log_site sl_log_site;
+typedef struct sl_log_record sl_log_record;
 typedef struct sl_log sl_log;
 
 enum sl_log_level {
@@ -25,17 +65,94 @@ enum sl_log_level {
     SL_LOG_MAX
 };
 
+enum sl_log_overflow {
+    SL_LOG_OVERFLOW_BLOCK,
+    SL_LOG_OVERFLOW_DROP
+};
+
+enum sl_log_mode {
+    SL_LOG_MODE_TEXT,
+    SL_LOG_MODE_BINARY
+};
+
+enum sl_log_record_type {
+    SL_LOG_RECORD_DEFINE,
+    SL_LOG_RECORD_EVENT
+};
+
+struct sl_log_ring {
+    char *buffer;
+    size_t size;
+    size_t head;
+    size_t tail;
+    uint16_t *entries;
+    size_t entry_size;
+    size_t entry_head;
+    size_t entry_tail;
+    sl_log_overflow overflow;
+    int log_fd;
+    size_t lines;
+    size_t flushes;
+    size_t dropped;
+};
+
+struct sl_log_limit {
+    time_t window;
+    size_t suppressed;
+};
+
+struct sl_log_site {
+    char *format;
+    size_t format_length;
+    uint32_t id;
+    uint8_t count;
+    bool defined;
+    uint8_t arguments[SL_LOG_MAX_ARGUMENTS];
+};
+
+struct sl_log_record {
+    char magic[SL_LOG_RECORD_MAGIC_SIZE];
+    uint32_t length;
+    uint8_t type;
+    uint8_t level;
+    uint16_t count;
+    uint32_t id;
+    uint32_t pid;
+    uint32_t address;
+    uint64_t timestamp;
+    uint16_t port;
+    uint8_t reserved[6];
+    int32_t error;
+    uint32_t suppressed;
+};
+
 struct sl_log {
     sl_log_level min_level;
+    sl_log_mode mode;
     int log_fd;
+    sl_log_ring *ring;
+    pid_t process_id;
+    uint32_t address;
+    uint16_t port;
     char pid[SL_LOG_MAX_PID_LENGTH];
     char ip_address[SL_LOG_MAX_IP_LENGTH];
     char ip_port[SL_LOG_MAX_PORT_LENGTH];
 };
 
+int sl_log_ring_init(sl_log_ring *ring, size_t size, sl_log_overflow overflow, int log_fd);
+int sl_log_ring_flush(sl_log_ring *ring);
+void sl_log_ring_destroy(sl_log_ring *ring);
+
 void sl_log_init(sl_log *log, sl_log_level min_level, int log_fd);
+void sl_log_init_with_parent(sl_log *log, sl_log *parent);
+void sl_log_set_ring(sl_log *log, sl_log_ring *ring);
+void sl_log_set_mode(sl_log *log, sl_log_mode mode);
+void sl_log_set_min_level(sl_log *log, sl_log_level min_level);
+bool sl_log_limit_pass(sl_log_limit *limit, size_t *suppressed);
+uint32_t sl_log_site_id(char *format, size_t length);
 void sl_log_write(sl_log *log, sl_log_level level, char *message);
-void sl_log_write_format(sl_arena *arena, sl_log *log, sl_log_level level, char *format, ...);
+void sl_log_write_format(sl_log *log, sl_log_level level, char *format, ...);
+void sl_log_write_site(sl_log *log, sl_log_level level, sl_log_site *site, size_t suppressed, ...);
 void sl_log_write_buffer(sl_log *log, sl_log_level level, char *message, size_t length);
 void sl_log_set_pid(sl_log *log, pid_t pid);
 void sl_log_set_ip_address_port(sl_log *log, struct sockaddr_in *address);
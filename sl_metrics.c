@@ -0,0 +1,241 @@
+#include "sl_metrics.h"
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <sys/mman.h>
+
+static char *sl_metrics_counter_names[SL_METRICS_COUNTERS] = {
+    "cpptrw_requests_total",
+    "cpptrw_requests_failed_total",
+    "cpptrw_requests_rejected_total",
+    "cpptrw_received_bytes_total",
+    "cpptrw_sent_bytes_total",
+    "cpptrw_connections_accepted_total",
+    "cpptrw_connections_refused_total",
+    "cpptrw_connections_reused_total",
+    "cpptrw_connections_closed_total",
+    "cpptrw_arena_allocations_total",
+    "cpptrw_arena_used_bytes_total",
+    "cpptrw_arena_allocated_bytes_total",
+    "cpptrw_arena_blocks_total",
+    "cpptrw_hashtable_resizes_total"
+};
+
+static char *sl_metrics_counter_help[SL_METRICS_COUNTERS] = {
+    "FastCGI requests finished.",
+    "FastCGI requests that failed to parse or execute.",
+    "FastCGI requests rejected for exceeding their memory budget.",
+    "Bytes received from FastCGI connections.",
+    "Bytes sent to FastCGI connections.",
+    "Connections accepted.",
+    "Connections closed right after accept because no slot was available.",
+    "Connections kept open for another request.",
+    "Connections closed.",
+    "Arena allocations made by requests.",
+    "Arena bytes used by requests.",
+    "Arena bytes reserved in blocks by requests.",
+    "Arena blocks used by requests.",
+    "Request parameter hashtable resizes."
+};
+
+static char *sl_metrics_gauge_names[SL_METRICS_GAUGES] = {
+    "cpptrw_connections_active",
+    "cpptrw_arena_pool_resident_bytes",
+    "cpptrw_arena_pool_pooled_bytes"
+};
+
+static char *sl_metrics_gauge_help[SL_METRICS_GAUGES] = {
+    "Connections currently open.",
+    "Arena pool bytes mapped for request blocks.",
+    "Arena pool bytes held in free blocks."
+};
+
+sl_metrics *sl_metrics_create(size_t worker_count)
+{
+    size_t size = sizeof(sl_metrics) + worker_count * sizeof(sl_metrics_worker);
+
+    sl_metrics *metrics = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (metrics == MAP_FAILED) {
+        return NULL;
+    }
+
+    metrics->size = size;
+    metrics->worker_count = worker_count;
+
+    return metrics;
+}
+
+void sl_metrics_destroy(sl_metrics *metrics)
+{
+    munmap(metrics, metrics->size);
+}
+
+sl_metrics_worker *sl_metrics_attach(sl_metrics *metrics, size_t worker, pid_t pid)
+{
+    if (worker >= metrics->worker_count) {
+        return NULL;
+    }
+
+    __atomic_store_n(&metrics->workers[worker].pid, (uint64_t) pid, __ATOMIC_RELAXED);
+
+    return &metrics->workers[worker];
+}
+
+inline void sl_metrics_add(sl_metrics_worker *worker, sl_metrics_counter counter, uint64_t value)
+{
+    __atomic_store_n(&worker->counters[counter], worker->counters[counter] + value, __ATOMIC_RELAXED);
+}
+
+inline void sl_metrics_set(sl_metrics_worker *worker, sl_metrics_gauge gauge, uint64_t value)
+{
+    __atomic_store_n(&worker->gauges[gauge], value, __ATOMIC_RELAXED);
+}
+
+inline void sl_metrics_adjust(sl_metrics_worker *worker, sl_metrics_gauge gauge, int64_t delta)
+{
+    __atomic_store_n(&worker->gauges[gauge], worker->gauges[gauge] + delta, __ATOMIC_RELAXED);
+}
+
+static size_t sl_metrics_latency_index(uint64_t duration_ns)
+{
+    uint64_t duration_us = (duration_ns + 999) / 1000;
+
+    if (duration_us <= 1) {
+        return 0;
+    }
+
+    size_t index = 64 - __builtin_clzll(duration_us - 1);
+
+    return index < SL_METRICS_LATENCY_BUCKETS ? index : SL_METRICS_LATENCY_BUCKETS;
+}
+
+void sl_metrics_record_latency(sl_metrics_worker *worker, uint64_t duration_ns)
+{
+    size_t index = sl_metrics_latency_index(duration_ns);
+
+    __atomic_store_n(&worker->latency_buckets[index], worker->latency_buckets[index] + 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&worker->latency_sum, worker->latency_sum + duration_ns, __ATOMIC_RELAXED);
+}
+
+static void sl_metrics_snapshot(sl_metrics_worker *worker, sl_metrics_worker *snapshot)
+{
+    for (size_t n = 0; n < SL_METRICS_COUNTERS; n ++) {
+        snapshot->counters[n] = __atomic_load_n(&worker->counters[n], __ATOMIC_RELAXED);
+    }
+
+    for (size_t n = 0; n < SL_METRICS_GAUGES; n ++) {
+        snapshot->gauges[n] = __atomic_load_n(&worker->gauges[n], __ATOMIC_RELAXED);
+    }
+
+    for (size_t n = 0; n <= SL_METRICS_LATENCY_BUCKETS; n ++) {
+        snapshot->latency_buckets[n] = __atomic_load_n(&worker->latency_buckets[n], __ATOMIC_RELAXED);
+    }
+
+    snapshot->latency_sum = __atomic_load_n(&worker->latency_sum, __ATOMIC_RELAXED);
+    snapshot->pid = __atomic_load_n(&worker->pid, __ATOMIC_RELAXED);
+}
+
+static int sl_metrics_printf(sl_rope *output, char *format, ...)
+{
+    va_list args;
+
+    char *line = sl_rope_reserve(output, SL_METRICS_MAX_LINE);
+    if (line == NULL) {
+        return -1;
+    }
+
+    va_start(args, format);
+    int length = vsnprintf(line, SL_METRICS_MAX_LINE, format, args);
+    va_end(args);
+
+    if (length < 0 || length >= SL_METRICS_MAX_LINE) {
+        return -1;
+    }
+
+    return sl_rope_commit(output, length);
+}
+
+static int sl_metrics_render_values(sl_rope *output, sl_metrics_worker *snapshots, size_t worker_count, char *name, char *help, char *type, size_t offset)
+{
+    if (sl_metrics_printf(output, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type) == -1) {
+        return -1;
+    }
+
+    for (size_t n = 0; n < worker_count; n ++) {
+        uint64_t value = *(uint64_t *) ((uint8_t *) &snapshots[n] + offset);
+
+        if (sl_metrics_printf(output, "%s{worker=\"%zu\"} %lu\n", name, n, value) == -1) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static int sl_metrics_render_latency(sl_rope *output, sl_metrics_worker *snapshots, size_t worker_count)
+{
+    char *name = "cpptrw_request_duration_seconds";
+
+    if (sl_metrics_printf(output, "# HELP %s FastCGI request latency from first byte received to response sent.\n# TYPE %s histogram\n", name, name) == -1) {
+        return -1;
+    }
+
+    for (size_t n = 0; n < worker_count; n ++) {
+        uint64_t cumulative = 0;
+
+        for (size_t bucket = 0; bucket < SL_METRICS_LATENCY_BUCKETS; bucket ++) {
+            cumulative += snapshots[n].latency_buckets[bucket];
+
+            if (sl_metrics_printf(output, "%s_bucket{worker=\"%zu\",le=\"%.6f\"} %lu\n", name, n, (double) ((uint64_t) 1 << bucket) / 1e6, cumulative) == -1) {
+                return -1;
+            }
+        }
+
+        cumulative += snapshots[n].latency_buckets[SL_METRICS_LATENCY_BUCKETS];
+
+        if (sl_metrics_printf(output, "%s_bucket{worker=\"%zu\",le=\"+Inf\"} %lu\n", name, n, cumulative) == -1 ||
+            sl_metrics_printf(output, "%s_sum{worker=\"%zu\"} %.9f\n", name, n, (double) snapshots[n].latency_sum / 1e9) == -1 ||
+            sl_metrics_printf(output, "%s_count{worker=\"%zu\"} %lu\n", name, n, cumulative) == -1) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+int sl_metrics_render(sl_metrics *metrics, sl_rope *output)
+{
+    size_t worker_count = metrics->worker_count;
+
+    sl_metrics_worker *snapshots = sl_arena_allocate_aligned(output->arena, worker_count * sizeof(sl_metrics_worker), SL_METRICS_CACHE_LINE_SIZE);
+    if (snapshots == NULL) {
+        return -1;
+    }
+
+    for (size_t n = 0; n < worker_count; n ++) {
+        sl_metrics_snapshot(&metrics->workers[n], &snapshots[n]);
+    }
+
+    if (sl_metrics_render_values(output, snapshots, worker_count, "cpptrw_worker_pid", "Process id of the worker.", "gauge", offsetof(sl_metrics_worker, pid)) == -1) {
+        return -1;
+    }
+
+    for (size_t n = 0; n < SL_METRICS_COUNTERS; n ++) {
+        size_t offset = offsetof(sl_metrics_worker, counters) + n * sizeof(uint64_t);
+
+        if (sl_metrics_render_values(output, snapshots, worker_count, sl_metrics_counter_names[n], sl_metrics_counter_help[n], "counter", offset) == -1) {
+            return -1;
+        }
+    }
+
+    for (size_t n = 0; n < SL_METRICS_GAUGES; n ++) {
+        size_t offset = offsetof(sl_metrics_worker, gauges) + n * sizeof(uint64_t);
+
+        if (sl_metrics_render_values(output, snapshots, worker_count, sl_metrics_gauge_names[n], sl_metrics_gauge_help[n], "gauge", offset) == -1) {
+            return -1;
+        }
+    }
+
+    return sl_metrics_render_latency(output, snapshots, worker_count);
+}
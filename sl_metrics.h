@@ -0,0 +1,71 @@
+#ifndef SL_METRICS_H
+#define SL_METRICS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <sys/types.h>
+
+#include "sl_rope.h"
+
+#define SL_METRICS_CACHE_LINE_SIZE 64
+#define SL_METRICS_LATENCY_BUCKETS 21
+#define SL_METRICS_MAX_LINE        256
+
+typedef enum sl_metrics_counter sl_metrics_counter;
+typedef enum sl_metrics_gauge sl_metrics_gauge;
+
+typedef struct sl_metrics_worker sl_metrics_worker;
+typedef struct sl_metrics sl_metrics;
+
+enum sl_metrics_counter {
+    SL_METRICS_REQUESTS,
+    SL_METRICS_REQUESTS_FAILED,
+    SL_METRICS_REQUESTS_REJECTED,
+    SL_METRICS_BYTES_RECEIVED,
+    SL_METRICS_BYTES_SENT,
+    SL_METRICS_CONNECTIONS_ACCEPTED,
+    SL_METRICS_CONNECTIONS_REFUSED,
+    SL_METRICS_CONNECTIONS_REUSED,
+    SL_METRICS_CONNECTIONS_CLOSED,
+    SL_METRICS_ARENA_ALLOCATIONS,
+    SL_METRICS_ARENA_BYTES_USED,
+    SL_METRICS_ARENA_BYTES_ALLOCATED,
+    SL_METRICS_ARENA_BLOCKS,
+    SL_METRICS_HASHTABLE_RESIZES,
+    SL_METRICS_COUNTERS
+};
+
+enum sl_metrics_gauge {
+    SL_METRICS_CONNECTIONS_ACTIVE,
+    SL_METRICS_ARENA_POOL_RESIDENT,
+    SL_METRICS_ARENA_POOL_POOLED,
+    SL_METRICS_GAUGES
+};
+
+struct sl_metrics_worker {
+    _Alignas(SL_METRICS_CACHE_LINE_SIZE) uint64_t counters[SL_METRICS_COUNTERS];
+    uint64_t gauges[SL_METRICS_GAUGES];
+    uint64_t latency_buckets[SL_METRICS_LATENCY_BUCKETS + 1];
+    uint64_t latency_sum;
+    uint64_t pid;
+};
+
+struct sl_metrics {
+    size_t size;
+    size_t worker_count;
+    sl_metrics_worker workers[];
+};
+
+sl_metrics *sl_metrics_create(size_t worker_count);
+void sl_metrics_destroy(sl_metrics *metrics);
+sl_metrics_worker *sl_metrics_attach(sl_metrics *metrics, size_t worker, pid_t pid);
+
+void sl_metrics_add(sl_metrics_worker *worker, sl_metrics_counter counter, uint64_t value);
+void sl_metrics_set(sl_metrics_worker *worker, sl_metrics_gauge gauge, uint64_t value);
+void sl_metrics_adjust(sl_metrics_worker *worker, sl_metrics_gauge gauge, int64_t delta);
+void sl_metrics_record_latency(sl_metrics_worker *worker, uint64_t duration_ns);
+
+int sl_metrics_render(sl_metrics *metrics, sl_rope *output);
+
+#endif
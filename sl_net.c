@@ -51,53 +51,68 @@ int sl_net_set_nonblocking_socket(int socket_fd)
     return 0;
 }
 
-void sl_net_init_connection(sl_net_connection *connection, sl_log *log, int socket_fd, struct sockaddr_in address, size_t arena_preallocate, size_t param_hashtable_size)
+sl_net_connection *sl_net_create_connection(sl_slab *connection_slab, sl_net_connection **connections)
+{
+    sl_net_connection *connection = sl_slab_allocate(connection_slab);
+    if (connection == NULL) {
+        return NULL;
+    }
+
+    *connection = (sl_net_connection) {0};
+
+    connection->next = *connections;
+
+    if (*connections != NULL) {
+        (*connections)->previous = connection;
+    }
+
+    *connections = connection;
+
+    return connection;
+}
+
+void sl_net_init_connection(sl_net_connection *connection, sl_log *log, int socket_fd, struct sockaddr_in address, sl_arena_pool *pool, sl_slab *param_slab, size_t arena_preallocate, size_t arena_limit, size_t param_hashtable_size)
 {
     connection->socket_fd = socket_fd;
     connection->address = address;
-    connection->is_busy = false;
 
-    sl_log_init(&connection->log, log->min_level, log->log_fd);
-    sl_log_set_pid(&connection->log, getpid());
+    sl_log_init_with_parent(&connection->log, log);
     sl_log_set_ip_address_port(&connection->log, &address);
 
     if (connection->arena.first == NULL) {
         sl_arena_init(&connection->arena, arena_preallocate);
+        sl_arena_set_pool(&connection->arena, pool);
+        sl_arena_set_limit(&connection->arena, arena_limit);
     } else {
         sl_arena_rewind(&connection->arena);
     }
 
-    sl_fcgi_parser_init(&connection->parser, &connection->arena, &connection->log);
+    sl_fcgi_parser_init(&connection->parser, &connection->arena, param_slab, &connection->log);
     sl_fcgi_request_init(&connection->request, &connection->arena, &connection->log, param_hashtable_size);
 }
 
-sl_net_connection *sl_net_find_connection(sl_net_connection *connections, size_t max_connections, int socket_fd)
+void sl_net_destroy_connection(sl_slab *connection_slab, sl_net_connection **connections, sl_net_connection *connection)
 {
-    for (size_t n = 0; n < max_connections; n ++) {
-        if (connections[n].socket_fd == socket_fd) {
-            return &connections[n];
-        }
-    }
+    sl_fcgi_parser_release_params(&connection->parser);
+    sl_arena_release(&connection->arena);
 
-    return NULL;
-}
+    if (connection->previous != NULL) {
+        connection->previous->next = connection->next;
+    } else {
+        *connections = connection->next;
+    }
 
-sl_net_connection *sl_net_find_free_connection(sl_net_connection *connections, size_t max_connections)
-{
-    for (size_t n = 0; n < max_connections; n ++) {
-        if (connections[n].is_busy == false) {
-            return &connections[n];
-        }
+    if (connection->next != NULL) {
+        connection->next->previous = connection->previous;
     }
 
-    return NULL;
+    sl_slab_free(connection_slab, connection);
 }
 
-void sl_net_destroy_connections(sl_net_connection *connections, size_t max_connections)
+void sl_net_destroy_connections(sl_slab *connection_slab, sl_net_connection **connections)
 {
-    for (size_t n = 0; n < max_connections; n ++) {
-        if (connections[n].arena.first != NULL) {
-            sl_arena_destroy(&connections[n].arena);
-        }
+    while (*connections != NULL) {
+        close((*connections)->socket_fd);
+        sl_net_destroy_connection(connection_slab, connections, *connections);
     }
 }
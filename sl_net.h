@@ -8,14 +8,17 @@
 
 #include "sl_log.h"
 #include "sl_arena.h"
+#include "sl_slab.h"
 #include "sl_fcgi.h"
 
 typedef struct sl_net_connection sl_net_connection;
 
 struct sl_net_connection {
+    sl_net_connection *previous;
+    sl_net_connection *next;
     int socket_fd;
+    uint32_t capture;
     struct sockaddr_in address;
-    bool is_busy;
     sl_arena arena;
     sl_log log;
     sl_fcgi_parser parser;
@@ -26,9 +29,9 @@ void sl_net_create_address(struct sockaddr_in *address, uint32_t ip_address, uin
 int sl_net_create_listen_socket(uint32_t ip_address, uint16_t port, int backlog);
 int sl_net_set_nonblocking_socket(int socket_fd);
 
-void sl_net_init_connection(sl_net_connection *connection, sl_log *log, int socket_fd, struct sockaddr_in address, size_t arena_preallocate, size_t param_hashtable_size);
-sl_net_connection *sl_net_find_connection(sl_net_connection *connections, size_t max_connections, int socket_fd);
-sl_net_connection *sl_net_find_free_connection(sl_net_connection *connections, size_t max_connections);
-void sl_net_destroy_connections(sl_net_connection *connections, size_t max_connections);
+sl_net_connection *sl_net_create_connection(sl_slab *connection_slab, sl_net_connection **connections);
+void sl_net_init_connection(sl_net_connection *connection, sl_log *log, int socket_fd, struct sockaddr_in address, sl_arena_pool *pool, sl_slab *param_slab, size_t arena_preallocate, size_t arena_limit, size_t param_hashtable_size);
+void sl_net_destroy_connection(sl_slab *connection_slab, sl_net_connection **connections, sl_net_connection *connection);
+void sl_net_destroy_connections(sl_slab *connection_slab, sl_net_connection **connections);
 
 #endif
@@ -0,0 +1,30 @@
+#ifndef SL_PROBE_H
+#define SL_PROBE_H
+
+#if !defined(SL_PROBE_DISABLE) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#define SL_PROBE_ENABLED 1
+#endif
+#endif
+
+#ifdef SL_PROBE_ENABLED
+
+#include <sys/sdt.h>
+
+#define SL_PROBE1(name, a)             DTRACE_PROBE1(cpptrw, name, a)
+#define SL_PROBE2(name, a, b)          DTRACE_PROBE2(cpptrw, name, a, b)
+#define SL_PROBE3(name, a, b, c)       DTRACE_PROBE3(cpptrw, name, a, b, c)
+#define SL_PROBE4(name, a, b, c, d)    DTRACE_PROBE4(cpptrw, name, a, b, c, d)
+#define SL_PROBE5(name, a, b, c, d, e) DTRACE_PROBE5(cpptrw, name, a, b, c, d, e)
+
+#else
+
+#define SL_PROBE1(name, a)             do { } while (0)
+#define SL_PROBE2(name, a, b)          do { } while (0)
+#define SL_PROBE3(name, a, b, c)       do { } while (0)
+#define SL_PROBE4(name, a, b, c, d)    do { } while (0)
+#define SL_PROBE5(name, a, b, c, d, e) do { } while (0)
+
+#endif
+
+#endif
@@ -0,0 +1,260 @@
+#include "sl_query.h"
+#include "sl_cpu.h"
+#include "sl_view.h"
+
+#include <string.h>
+
+#ifdef SL_CPU_X86
+#include <immintrin.h>
+#endif
+
+static size_t sl_query_find_special_scalar(char *buffer, size_t length, char separator, char plus)
+{
+    for (size_t n = 0; n < length; n ++) {
+        char c = buffer[n];
+        if (c == separator || c == '=' || c == '%' || c == plus) {
+            return n;
+        }
+    }
+
+    return length;
+}
+
+#ifdef SL_CPU_X86
+__attribute__((target("sse2")))
+static size_t sl_query_find_special_sse2(char *buffer, size_t length, char separator, char plus)
+{
+    __m128i separators = _mm_set1_epi8(separator);
+    __m128i equals = _mm_set1_epi8('=');
+    __m128i percents = _mm_set1_epi8('%');
+    __m128i pluses = _mm_set1_epi8(plus);
+    size_t n = 0;
+
+    for (; n + 16 <= length; n += 16) {
+        __m128i chunk = _mm_loadu_si128((__m128i *) (buffer + n));
+        __m128i matches = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, separators), _mm_cmpeq_epi8(chunk, equals)),
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, percents), _mm_cmpeq_epi8(chunk, pluses)));
+
+        int mask = _mm_movemask_epi8(matches);
+        if (mask != 0) {
+            return n + __builtin_ctz(mask);
+        }
+    }
+
+    return n + sl_query_find_special_scalar(buffer + n, length - n, separator, plus);
+}
+
+__attribute__((target("avx2")))
+static size_t sl_query_find_special_avx2(char *buffer, size_t length, char separator, char plus)
+{
+    __m256i separators = _mm256_set1_epi8(separator);
+    __m256i equals = _mm256_set1_epi8('=');
+    __m256i percents = _mm256_set1_epi8('%');
+    __m256i pluses = _mm256_set1_epi8(plus);
+    size_t n = 0;
+
+    for (; n + 32 <= length; n += 32) {
+        __m256i chunk = _mm256_loadu_si256((__m256i *) (buffer + n));
+        __m256i matches = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(chunk, separators), _mm256_cmpeq_epi8(chunk, equals)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(chunk, percents), _mm256_cmpeq_epi8(chunk, pluses)));
+
+        uint32_t mask = (uint32_t) _mm256_movemask_epi8(matches);
+        if (mask != 0) {
+            return n + __builtin_ctz(mask);
+        }
+    }
+
+    if (n + 16 <= length) {
+        __m128i chunk = _mm_loadu_si128((__m128i *) (buffer + n));
+        __m128i matches = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm256_castsi256_si128(separators)), _mm_cmpeq_epi8(chunk, _mm256_castsi256_si128(equals))),
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm256_castsi256_si128(percents)), _mm_cmpeq_epi8(chunk, _mm256_castsi256_si128(pluses))));
+
+        int mask = _mm_movemask_epi8(matches);
+        if (mask != 0) {
+            return n + __builtin_ctz(mask);
+        }
+
+        n += 16;
+    }
+
+    return n + sl_query_find_special_scalar(buffer + n, length - n, separator, plus);
+}
+#endif
+
+size_t sl_query_find_special(char *buffer, size_t length, char separator, char plus)
+{
+    switch (sl_cpu_get_level()) {
+#ifdef SL_CPU_X86
+        case SL_CPU_AVX2:
+            return sl_query_find_special_avx2(buffer, length, separator, plus);
+        case SL_CPU_SSE2:
+            return sl_query_find_special_sse2(buffer, length, separator, plus);
+#endif
+        default:
+            return sl_query_find_special_scalar(buffer, length, separator, plus);
+    }
+}
+
+static int sl_query_hex_value(char c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+
+    c |= 0x20;
+
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+
+    return -1;
+}
+
+static int sl_query_append_pair(sl_query *query, char *key, size_t key_length, char *value, size_t value_length)
+{
+    if (query->type == SL_QUERY_TYPE_COOKIE) {
+        while (key_length > 0 && *key == ' ') {
+            key ++;
+            key_length --;
+        }
+    }
+
+    if (key_length == 0 && value_length == 0) {
+        return 0;
+    }
+
+    if (query->count == query->allocated) {
+        size_t allocated = query->allocated == 0 ? SL_QUERY_PAIRS_PREALLOCATE : query->allocated << 1;
+
+        sl_query_pair *pairs = sl_arena_allocate(query->arena, sizeof(sl_query_pair) * allocated);
+        if (pairs == NULL) {
+            return -1;
+        }
+
+        if (query->count > 0) {
+            memcpy(pairs, query->pairs, sizeof(sl_query_pair) * query->count);
+        }
+
+        query->pairs = pairs;
+        query->allocated = allocated;
+    }
+
+    sl_query_pair *pair = &query->pairs[query->count++];
+
+    key[key_length] = 0;
+    value[value_length] = 0;
+
+    pair->key = sl_string_init_with_buffer(key, key_length);
+    pair->value = sl_string_init_with_buffer(value, value_length);
+
+    return 0;
+}
+
+void sl_query_init(sl_query *query, sl_arena *arena, sl_query_type type)
+{
+    *query = (sl_query) {0};
+
+    query->type = type;
+    query->arena = arena;
+}
+
+static int sl_query_decode_pairs(sl_query *query, sl_string *source)
+{
+
+    char separator = query->type == SL_QUERY_TYPE_COOKIE ? ';' : '&';
+    char plus = query->type == SL_QUERY_TYPE_COOKIE ? '%' : '+';
+
+    char *buffer = sl_arena_allocate(query->arena, source->length + 1);
+    if (buffer == NULL) {
+        return -1;
+    }
+
+    memcpy(buffer, source->buffer, source->length);
+
+    size_t length = source->length, read = 0, write = 0;
+    size_t key_start = 0, value_start = 0;
+    bool has_value = false;
+
+    while (read < length) {
+        size_t clean = sl_query_find_special(buffer + read, length - read, separator, plus);
+
+        if (write != read) {
+            memmove(buffer + write, buffer + read, clean);
+        }
+
+        read += clean;
+        write += clean;
+
+        if (read == length) {
+            break;
+        }
+
+        char c = buffer[read];
+
+        if (c == separator) {
+            char *value = has_value ? buffer + value_start : buffer + write;
+            size_t key_length = (has_value ? value_start - 1 : write) - key_start;
+            size_t value_length = has_value ? write - value_start : 0;
+
+            if (sl_query_append_pair(query, buffer + key_start, key_length, value, value_length) == -1) {
+                return -1;
+            }
+
+            read ++;
+            write ++;
+            key_start = write;
+            has_value = false;
+        } else if (c == '=' && has_value == false) {
+            read ++;
+            write ++;
+            value_start = write;
+            has_value = true;
+        } else if (c == '%' && read + 2 < length && sl_query_hex_value(buffer[read + 1]) != -1 && sl_query_hex_value(buffer[read + 2]) != -1) {
+            buffer[write++] = (char) ((sl_query_hex_value(buffer[read + 1]) << 4) | sl_query_hex_value(buffer[read + 2]));
+            read += 3;
+        } else if (c == '+' && query->type == SL_QUERY_TYPE_QUERY_STRING) {
+            buffer[write++] = ' ';
+            read ++;
+        } else {
+            buffer[write++] = c;
+            read ++;
+        }
+    }
+
+    char *value = has_value ? buffer + value_start : buffer + write;
+    size_t key_length = (has_value ? value_start - 1 : write) - key_start;
+    size_t value_length = has_value ? write - value_start : 0;
+
+    return sl_query_append_pair(query, buffer + key_start, key_length, value, value_length);
+}
+
+int sl_query_decode(sl_query *query, sl_string *source)
+{
+    query->is_decoded = false;
+    query->count = 0;
+
+    if (source != NULL && source->length > 0 && sl_query_decode_pairs(query, source) == -1) {
+        query->count = 0;
+        return -1;
+    }
+
+    query->is_decoded = true;
+
+    return 0;
+}
+
+sl_string *sl_query_get(sl_query *query, sl_string *key)
+{
+    for (size_t n = 0; n < query->count; n ++) {
+        sl_query_pair *pair = &query->pairs[n];
+
+        if (sl_view_equal(&pair->key, key) == true) {
+            return &pair->value;
+        }
+    }
+
+    return NULL;
+}
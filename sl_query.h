@@ -0,0 +1,42 @@
+#ifndef SL_QUERY_H
+#define SL_QUERY_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "sl_arena.h"
+#include "sl_string.h"
+
+#define SL_QUERY_PAIRS_PREALLOCATE 16
+
+typedef enum sl_query_type sl_query_type;
+
+typedef struct sl_query_pair sl_query_pair;
+typedef struct sl_query sl_query;
+
+enum sl_query_type {
+    SL_QUERY_TYPE_QUERY_STRING,
+    SL_QUERY_TYPE_COOKIE
+};
+
+struct sl_query_pair {
+    sl_string key;
+    sl_string value;
+};
+
+struct sl_query {
+    sl_query_type type;
+    sl_arena *arena;
+    bool is_decoded;
+    sl_query_pair *pairs;
+    size_t allocated;
+    size_t count;
+};
+
+size_t sl_query_find_special(char *buffer, size_t length, char separator, char plus);
+
+void sl_query_init(sl_query *query, sl_arena *arena, sl_query_type type);
+int sl_query_decode(sl_query *query, sl_string *source);
+sl_string *sl_query_get(sl_query *query, sl_string *key);
+
+#endif
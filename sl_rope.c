@@ -0,0 +1,186 @@
+#include "sl_rope.h"
+
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+static int sl_rope_push_segment(sl_rope *rope, void *buffer, size_t length)
+{
+    if (rope->count == rope->allocated) {
+        size_t allocated = rope->allocated == 0 ? SL_ROPE_SEGMENT_PREALLOCATE : rope->allocated << 1;
+
+        struct iovec *segments = sl_arena_allocate(rope->arena, allocated * sizeof(struct iovec));
+        if (segments == NULL) {
+            return -1;
+        }
+
+        if (rope->count > 0) {
+            memcpy(segments, rope->segments, rope->count * sizeof(struct iovec));
+        }
+
+        sl_arena_free(rope->arena, rope->segments, rope->allocated * sizeof(struct iovec));
+
+        rope->segments = segments;
+        rope->allocated = allocated;
+    }
+
+    rope->segments[rope->count ++] = (struct iovec) {buffer, length};
+    rope->length += length;
+
+    return 0;
+}
+
+static inline bool sl_rope_is_chunk_tail(sl_rope *rope)
+{
+    if (rope->count == 0 || rope->chunk == NULL) {
+        return false;
+    }
+
+    struct iovec *last = &rope->segments[rope->count - 1];
+
+    return (uint8_t *) last->iov_base + last->iov_len == rope->chunk + rope->chunk_used;
+}
+
+void sl_rope_init(sl_rope *rope, sl_arena *arena)
+{
+    *rope = (sl_rope) {0};
+
+    rope->arena = arena;
+}
+
+void sl_rope_release(sl_rope *rope)
+{
+    for (sl_rope_mapping *mapping = rope->mappings; mapping != NULL; mapping = mapping->next) {
+        munmap(mapping->address, mapping->length);
+    }
+
+    rope->mappings = NULL;
+}
+
+void *sl_rope_reserve(sl_rope *rope, size_t size)
+{
+    if (rope->chunk != NULL && rope->chunk_allocated - rope->chunk_used >= size) {
+        return rope->chunk + rope->chunk_used;
+    }
+
+    size_t allocated = size > SL_ROPE_CHUNK_SIZE ? size : SL_ROPE_CHUNK_SIZE;
+
+    uint8_t *chunk = sl_arena_allocate(rope->arena, allocated);
+    if (chunk == NULL) {
+        return NULL;
+    }
+
+    rope->chunk = chunk;
+    rope->chunk_used = 0;
+    rope->chunk_allocated = allocated;
+
+    return chunk;
+}
+
+int sl_rope_commit(sl_rope *rope, size_t length)
+{
+    if (length == 0) {
+        return 0;
+    }
+
+    if (sl_rope_is_chunk_tail(rope)) {
+        rope->segments[rope->count - 1].iov_len += length;
+        rope->length += length;
+    } else if (sl_rope_push_segment(rope, rope->chunk + rope->chunk_used, length) == -1) {
+        return -1;
+    }
+
+    rope->chunk_used += length;
+    rope->copied += length;
+
+    return 0;
+}
+
+int sl_rope_append_copy(sl_rope *rope, void *buffer, size_t length)
+{
+    if (length == 0) {
+        return 0;
+    }
+
+    void *destination = sl_rope_reserve(rope, length);
+    if (destination == NULL) {
+        return -1;
+    }
+
+    memcpy(destination, buffer, length);
+
+    return sl_rope_commit(rope, length);
+}
+
+int sl_rope_append_reference(sl_rope *rope, void *buffer, size_t length)
+{
+    if (length == 0) {
+        return 0;
+    }
+
+    if (length < SL_ROPE_COPY_THRESHOLD && sl_rope_is_chunk_tail(rope) && rope->chunk_allocated - rope->chunk_used >= length) {
+        return sl_rope_append_copy(rope, buffer, length);
+    }
+
+    return sl_rope_push_segment(rope, buffer, length);
+}
+
+inline int sl_rope_append_string(sl_rope *rope, sl_string *string)
+{
+    return sl_rope_append_copy(rope, string->buffer, string->length);
+}
+
+int sl_rope_append_rope(sl_rope *rope, sl_rope *other)
+{
+    for (size_t n = 0; n < other->count; n ++) {
+        if (sl_rope_append_reference(rope, other->segments[n].iov_base, other->segments[n].iov_len) == -1) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+int sl_rope_append_file(sl_rope *rope, int fd, off_t offset, size_t length)
+{
+    if (length == 0) {
+        return 0;
+    }
+
+    off_t page_offset = offset & ~((off_t) sysconf(_SC_PAGESIZE) - 1);
+    size_t delta = offset - page_offset;
+
+    sl_rope_mapping *mapping = sl_arena_allocate(rope->arena, sizeof(sl_rope_mapping));
+    if (mapping == NULL) {
+        return -1;
+    }
+
+    void *address = mmap(NULL, length + delta, PROT_READ, MAP_PRIVATE, fd, page_offset);
+    if (address == MAP_FAILED) {
+        return -1;
+    }
+
+    *mapping = (sl_rope_mapping) {
+        .next = rope->mappings,
+        .address = address,
+        .length = length + delta
+    };
+
+    rope->mappings = mapping;
+
+    return sl_rope_push_segment(rope, (uint8_t *) address + delta, length);
+}
+
+size_t sl_rope_flatten(sl_rope *rope, void *buffer, size_t size)
+{
+    size_t offset = 0;
+
+    for (size_t n = 0; n < rope->count && offset < size; n ++) {
+        size_t length = rope->segments[n].iov_len < size - offset ? rope->segments[n].iov_len : size - offset;
+
+        memcpy((uint8_t *) buffer + offset, rope->segments[n].iov_base, length);
+        offset += length;
+    }
+
+    return offset;
+}
@@ -0,0 +1,50 @@
+#ifndef SL_ROPE_H
+#define SL_ROPE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <sys/uio.h>
+#include <sys/types.h>
+
+#include "sl_arena.h"
+#include "sl_string.h"
+
+#define SL_ROPE_SEGMENT_PREALLOCATE 8
+#define SL_ROPE_CHUNK_SIZE          4096
+#define SL_ROPE_COPY_THRESHOLD      128
+
+typedef struct sl_rope_mapping sl_rope_mapping;
+typedef struct sl_rope sl_rope;
+
+struct sl_rope_mapping {
+    sl_rope_mapping *next;
+    void *address;
+    size_t length;
+};
+
+struct sl_rope {
+    sl_arena *arena;
+    struct iovec *segments;
+    size_t count;
+    size_t allocated;
+    size_t length;
+    uint8_t *chunk;
+    size_t chunk_used;
+    size_t chunk_allocated;
+    sl_rope_mapping *mappings;
+    size_t copied;
+};
+
+void sl_rope_init(sl_rope *rope, sl_arena *arena);
+void sl_rope_release(sl_rope *rope);
+int sl_rope_append_copy(sl_rope *rope, void *buffer, size_t length);
+int sl_rope_append_reference(sl_rope *rope, void *buffer, size_t length);
+int sl_rope_append_string(sl_rope *rope, sl_string *string);
+int sl_rope_append_rope(sl_rope *rope, sl_rope *other);
+int sl_rope_append_file(sl_rope *rope, int fd, off_t offset, size_t length);
+void *sl_rope_reserve(sl_rope *rope, size_t size);
+int sl_rope_commit(sl_rope *rope, size_t length);
+size_t sl_rope_flatten(sl_rope *rope, void *buffer, size_t size);
+
+#endif
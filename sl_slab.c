@@ -0,0 +1,121 @@
+#include "sl_slab.h"
+
+#include <string.h>
+
+static size_t sl_slab_object_size(size_t size)
+{
+    if (size < sizeof(sl_slab_object)) {
+        size = sizeof(sl_slab_object);
+    }
+
+    if (size <= SL_SLAB_CACHE_LINE_SIZE) {
+        size_t pow2_size = sizeof(sl_slab_object);
+
+        while (pow2_size < size) {
+            pow2_size <<= 1;
+        }
+
+        return pow2_size;
+    }
+
+    return (size + SL_SLAB_CACHE_LINE_SIZE - 1) & ~((size_t) SL_SLAB_CACHE_LINE_SIZE - 1);
+}
+
+static sl_slab_page *sl_slab_create_page(sl_slab *slab)
+{
+    size_t size = sizeof(sl_slab_page) + slab->object_size * slab->objects_per_page;
+    size = (size + SL_SLAB_CACHE_LINE_SIZE - 1) & ~((size_t) SL_SLAB_CACHE_LINE_SIZE - 1);
+
+    sl_slab_page *page = aligned_alloc(SL_SLAB_CACHE_LINE_SIZE, size);
+    if (page == NULL) {
+        return NULL;
+    }
+
+    page->next = slab->pages;
+    page->used = 0;
+
+    slab->pages = page;
+    slab->page_count ++;
+
+    return page;
+}
+
+#ifdef SL_SLAB_DEBUG
+static void sl_slab_check_poison(sl_slab *slab, sl_slab_object *object)
+{
+    uint8_t *bytes = (uint8_t *) object;
+
+    for (size_t n = sizeof(sl_slab_object); n < slab->object_size; n ++) {
+        if (bytes[n] != SL_SLAB_POISON) {
+            abort();
+        }
+    }
+}
+#endif
+
+void sl_slab_init(sl_slab *slab, size_t object_size, size_t objects_per_page)
+{
+    *slab = (sl_slab) {0};
+
+    slab->object_size = sl_slab_object_size(object_size);
+    slab->objects_per_page = objects_per_page > 0 ? objects_per_page : 1;
+}
+
+void sl_slab_destroy(sl_slab *slab)
+{
+    sl_slab_page *next = NULL;
+
+    for (sl_slab_page *page = slab->pages; page != NULL; page = next) {
+        next = page->next;
+        free(page);
+    }
+
+    sl_slab_init(slab, slab->object_size, slab->objects_per_page);
+}
+
+void *sl_slab_allocate(sl_slab *slab)
+{
+    sl_slab_object *object = slab->free;
+
+    if (object != NULL) {
+        slab->free = object->next;
+
+#ifdef SL_SLAB_DEBUG
+        sl_slab_check_poison(slab, object);
+#endif
+    } else {
+        sl_slab_page *page = slab->pages;
+
+        if (page == NULL || page->used == slab->objects_per_page) {
+            page = sl_slab_create_page(slab);
+            if (page == NULL) {
+                return NULL;
+            }
+        }
+
+        object = (sl_slab_object *) (page->objects + page->used * slab->object_size);
+        page->used ++;
+    }
+
+    slab->allocations ++;
+    slab->used ++;
+
+    return object;
+}
+
+void sl_slab_free(sl_slab *slab, void *object)
+{
+    if (object == NULL) {
+        return;
+    }
+
+#ifdef SL_SLAB_DEBUG
+    memset(object, SL_SLAB_POISON, slab->object_size);
+#endif
+
+    sl_slab_object *free_object = object;
+
+    free_object->next = slab->free;
+    slab->free = free_object;
+    slab->used --;
+}
@@ -0,0 +1,39 @@
+#ifndef SL_SLAB_H
+#define SL_SLAB_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#define SL_SLAB_CACHE_LINE_SIZE 64
+#define SL_SLAB_POISON          0xdb
+
+typedef struct sl_slab_object sl_slab_object;
+typedef struct sl_slab_page sl_slab_page;
+typedef struct sl_slab sl_slab;
+
+struct sl_slab_object {
+    sl_slab_object *next;
+};
+
+struct sl_slab_page {
+    sl_slab_page *next;
+    size_t used;
+    _Alignas(SL_SLAB_CACHE_LINE_SIZE) uint8_t objects[];
+};
+
+struct sl_slab {
+    sl_slab_page *pages;
+    sl_slab_object *free;
+    size_t object_size;
+    size_t objects_per_page;
+    size_t page_count;
+    size_t allocations;
+    size_t used;
+};
+
+void sl_slab_init(sl_slab *slab, size_t object_size, size_t objects_per_page);
+void sl_slab_destroy(sl_slab *slab);
+void *sl_slab_allocate(sl_slab *slab);
+void sl_slab_free(sl_slab *slab, void *object);
+
+#endif
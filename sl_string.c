@@ -1,9 +1,9 @@
 #include "sl_string.h"
+#include "sl_format.h"
 
 #include <string.h>
 
-#define SL_STRING_64BIT_DEC_DIGITS 20
-#define SL_STRING_64BIT_HEX_DIGITS 16
+#define SL_STRING_FORMAT_SCRATCH_SIZE 256
 
 inline sl_string sl_string_init_with_buffer(char *buffer, size_t length)
 {
@@ -54,28 +54,44 @@ sl_string *sl_string_create_with_buffer(sl_arena *arena, char *buffer, size_t le
     return string;
 }
 
-int sl_string_append_with_buffer(sl_arena *arena, sl_string *string, char *buffer, size_t length)
+int sl_string_reserve(sl_arena *arena, sl_string *string, size_t length)
 {
     if (string->length + length <= string->allocated) {
-        memcpy(string->buffer + string->length, buffer, length);
-        string->length += length;
-
         return 0;
     }
 
     size_t pow2_size = sl_arena_pow2_size((string->length + length) << 1);
+
+    if (string->buffer != NULL && sl_arena_extend(arena, string->buffer, string->allocated, pow2_size) == 0) {
+        string->allocated = pow2_size;
+        return 0;
+    }
+
     char *new_buffer = sl_arena_allocate(arena, pow2_size);
     if (new_buffer == NULL) {
         return -1;
     }
 
-    memcpy(new_buffer, string->buffer, string->length);
-    memcpy(new_buffer + string->length, buffer, length);
-    memset(new_buffer + string->length + length, 0, pow2_size - string->length - length);
+    if (string->length > 0) {
+        memcpy(new_buffer, string->buffer, string->length);
+    }
 
     string->buffer = new_buffer;
     string->allocated = pow2_size;
-    string->length += length;
+
+    return 0;
+}
+
+int sl_string_append_with_buffer(sl_arena *arena, sl_string *string, char *buffer, size_t length)
+{
+    if (sl_string_reserve(arena, string, length) == -1) {
+        return -1;
+    }
+
+    if (length > 0) {
+        memcpy(string->buffer + string->length, buffer, length);
+        string->length += length;
+    }
 
     return 0;
 }
@@ -95,20 +111,16 @@ inline int sl_string_append_with_string(sl_arena *arena, sl_string *destination,
     return sl_string_append_with_buffer(arena, destination, source->buffer, source->length);
 }
 
-size_t sl_string_itoa(uintptr_t value, char *buffer, size_t length)
+inline size_t sl_string_itoa(uintptr_t value, char *buffer, size_t length)
 {
-    size_t value_length = 0;
+    char digits[SL_FORMAT_MAX_NUMBER_LENGTH];
 
-    while (value > 0 && length-- > 0) {
-        uint8_t digit = '0' + (value % 10);
-        buffer[length] = digit;
-        value /= 10;
-        value_length ++;
+    size_t value_length = sl_format_unsigned(value, digits);
+    if (value_length > length) {
+        return 0;
     }
 
-    for (size_t n = 0; n < value_length; n ++) {
-        buffer[n] = buffer[n + length];
-    }
+    memcpy(buffer, digits, value_length);
 
     return value_length;
 }
@@ -126,56 +138,60 @@ sl_string *sl_string_format(sl_arena *arena, char *format, ...)
 
 sl_string *sl_string_format_buffer(sl_arena *arena, char *format, size_t length, va_list arguments)
 {
-    sl_string *string = sl_string_create_from_buffer(arena, "", 0, length << 1);
-    if (string == NULL) {
+    char scratch[SL_STRING_FORMAT_SCRATCH_SIZE];
+    va_list retry_arguments;
+
+    va_copy(retry_arguments, arguments);
+    size_t formatted_length = sl_format_buffer(scratch, sizeof(scratch), format, length, arguments);
+
+    sl_string *string = sl_arena_allocate(arena, sizeof(sl_string));
+    char *buffer = sl_arena_allocate(arena, formatted_length + 1);
+
+    if (string == NULL || buffer == NULL) {
+        va_end(retry_arguments);
         return NULL;
     }
 
-    while (length-- > 0) {
-        if (*format != '%') {
-            string->buffer[string->length++] = *format++;
-            continue;
-        }
-
-
-        switch (*(++format)) {
-            case 'z':
-                char buffer[SL_STRING_64BIT_DEC_DIGITS];
-
-                size_t arg_size = va_arg(arguments, size_t);
-                size_t arg_length = sl_string_itoa(arg_size, buffer, sizeof(buffer));
-
-                if (sl_string_append_with_buffer(arena, string, buffer, arg_length) == -1) {
-                    return NULL;
-                }
-                break;
-            case 's':
-                char *arg_cstring = va_arg(arguments, char *);
-                if (arg_cstring == NULL) {
-                    break;
-                }
-
-                if (sl_string_append_with_buffer(arena, string, arg_cstring, strlen(arg_cstring)) == -1) {
-                    return NULL;
-                }
-                break;
-            case 'S':
-                sl_string *arg_string = va_arg(arguments, sl_string*);
-                if (arg_string == NULL) {
-                    break;
-                }
-
-                if (sl_string_append_with_string(arena, string, arg_string) == -1) {
-                    return NULL;
-                }
-                break;
-            default:
-                break;
-        }
-
-        format ++;
-        length --;
+    if (formatted_length < sizeof(scratch)) {
+        memcpy(buffer, scratch, formatted_length + 1);
+    } else {
+        sl_format_buffer(buffer, formatted_length + 1, format, length, retry_arguments);
     }
 
+    va_end(retry_arguments);
+
+    string->buffer = buffer;
+    string->allocated = formatted_length + 1;
+    string->length = formatted_length;
+
     return string;
 }
+
+void sl_string_builder_init(sl_string_builder *builder, sl_arena *arena)
+{
+    *builder = (sl_string_builder) {0};
+
+    builder->arena = arena;
+}
+
+inline int sl_string_builder_reserve(sl_string_builder *builder, size_t length)
+{
+    return sl_string_reserve(builder->arena, &builder->string, length);
+}
+
+char *sl_string_builder_tail(sl_string_builder *builder, size_t *available)
+{
+    *available = builder->string.allocated - builder->string.length;
+
+    return builder->string.buffer + builder->string.length;
+}
+
+void sl_string_builder_commit(sl_string_builder *builder, size_t length)
+{
+    builder->string.length += length;
+}
+
+inline int sl_string_builder_append(sl_string_builder *builder, char *buffer, size_t length)
+{
+    return sl_string_append_with_buffer(builder->arena, &builder->string, buffer, length);
+}
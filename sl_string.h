@@ -7,6 +7,7 @@
 #include "sl_arena.h"
 
 typedef struct sl_string sl_string;
+typedef struct sl_string_builder sl_string_builder;
 
 struct sl_string {
     size_t allocated;
@@ -14,12 +15,18 @@ struct sl_string {
     char *buffer;
 };
 
+struct sl_string_builder {
+    sl_arena *arena;
+    sl_string string;
+};
+
 sl_string sl_string_init_with_buffer(char *buffer, size_t length);
 sl_string sl_string_init_with_cstring(char *cstring);
 
 sl_string *sl_string_create_from_buffer(sl_arena *arena, char *buffer, size_t length, size_t preallocate);
 sl_string *sl_string_create_with_buffer(sl_arena *arena, char *buffer, size_t length);
 int sl_string_append_with_buffer(sl_arena *arena, sl_string *string, char *buffer, size_t length);
+int sl_string_reserve(sl_arena *arena, sl_string *string, size_t length);
 
 sl_string *sl_string_create_from_string(sl_arena *arena, sl_string *string, size_t preallocate);
 sl_string *sl_string_create_with_string(sl_arena *arena, sl_string *string);
@@ -29,4 +36,10 @@ size_t sl_string_itoa(uintptr_t value, char *buffer, size_t length);
 sl_string *sl_string_format(sl_arena *arena, char *format, ...);
 sl_string *sl_string_format_buffer(sl_arena *arena, char *format, size_t length, va_list arguments);
 
+void sl_string_builder_init(sl_string_builder *builder, sl_arena *arena);
+int sl_string_builder_reserve(sl_string_builder *builder, size_t length);
+char *sl_string_builder_tail(sl_string_builder *builder, size_t *available);
+void sl_string_builder_commit(sl_string_builder *builder, size_t length);
+int sl_string_builder_append(sl_string_builder *builder, char *buffer, size_t length);
+
 #endif
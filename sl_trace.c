@@ -0,0 +1,282 @@
+#include "sl_trace.h"
+
+#include <string.h>
+#include <time.h>
+
+#include "sl_cpu.h"
+#include "sl_view.h"
+
+#ifdef SL_CPU_X86
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+
+static char *sl_trace_phase_names[SL_TRACE_PHASES] = {
+    "recv", "parse", "process", "execute", "send", "request"
+};
+
+static sl_trace_clock sl_trace_source = SL_TRACE_CLOCK_MONOTONIC_RAW;
+static uint64_t sl_trace_multiplier = (uint64_t) 1 << 32;
+
+static uint64_t sl_trace_monotonic_raw(void)
+{
+    struct timespec timestamp;
+
+    clock_gettime(CLOCK_MONOTONIC_RAW, &timestamp);
+
+    return (uint64_t) timestamp.tv_sec * 1000000000 + timestamp.tv_nsec;
+}
+
+#ifdef SL_CPU_X86
+static bool sl_trace_tsc_invariant(void)
+{
+    unsigned int eax, ebx, ecx, edx;
+
+    if (__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) == 0) {
+        return false;
+    }
+
+    return (edx & (1 << 8)) != 0;
+}
+
+static uint64_t sl_trace_cost(sl_trace_clock clock)
+{
+    uint64_t sink = 0, start = sl_trace_monotonic_raw();
+
+    for (size_t n = 0; n < 1000; n ++) {
+        sink += clock == SL_TRACE_CLOCK_TSC ? __rdtsc() : sl_trace_monotonic_raw();
+    }
+
+    __asm__ volatile("" : : "r"(sink));
+
+    return sl_trace_monotonic_raw() - start;
+}
+#endif
+
+void sl_trace_calibrate(void)
+{
+    sl_trace_source = SL_TRACE_CLOCK_MONOTONIC_RAW;
+    sl_trace_multiplier = (uint64_t) 1 << 32;
+
+#ifdef SL_CPU_X86
+    if (sl_trace_tsc_invariant() == false || sl_trace_cost(SL_TRACE_CLOCK_TSC) >= sl_trace_cost(SL_TRACE_CLOCK_MONOTONIC_RAW)) {
+        return;
+    }
+
+    uint64_t start_ns = sl_trace_monotonic_raw(), start_ticks = __rdtsc(), elapsed_ns;
+
+    do {
+        elapsed_ns = sl_trace_monotonic_raw() - start_ns;
+    } while (elapsed_ns < SL_TRACE_CALIBRATE_NS);
+
+    uint64_t elapsed_ticks = __rdtsc() - start_ticks;
+    if (elapsed_ticks == 0) {
+        return;
+    }
+
+    sl_trace_multiplier = (uint64_t) (((unsigned __int128) elapsed_ns << 32) / elapsed_ticks);
+    sl_trace_source = SL_TRACE_CLOCK_TSC;
+#endif
+}
+
+inline sl_trace_clock sl_trace_get_clock(void)
+{
+    return sl_trace_source;
+}
+
+uint64_t sl_trace_now(void)
+{
+#ifdef SL_CPU_X86
+    if (sl_trace_source == SL_TRACE_CLOCK_TSC) {
+        return __rdtsc();
+    }
+#endif
+
+    return sl_trace_monotonic_raw();
+}
+
+inline uint64_t sl_trace_to_ns(uint64_t ticks)
+{
+    return (uint64_t) (((unsigned __int128) ticks * sl_trace_multiplier) >> 32);
+}
+
+static size_t sl_trace_histogram_index(uint64_t value)
+{
+    if (value < SL_TRACE_SUB_BUCKETS) {
+        return value;
+    }
+
+    size_t shift = 63 - __builtin_clzll(value) - SL_TRACE_SUB_BUCKET_BITS;
+    size_t index = (shift + 1) * SL_TRACE_SUB_BUCKETS + (value >> shift) - SL_TRACE_SUB_BUCKETS;
+
+    return index < SL_TRACE_BUCKETS ? index : SL_TRACE_BUCKETS - 1;
+}
+
+static uint64_t sl_trace_histogram_upper(size_t index)
+{
+    if (index < SL_TRACE_SUB_BUCKETS) {
+        return index;
+    }
+
+    size_t shift = index / SL_TRACE_SUB_BUCKETS - 1;
+    uint64_t lower = (uint64_t) (SL_TRACE_SUB_BUCKETS + index % SL_TRACE_SUB_BUCKETS) << shift;
+
+    return lower + ((uint64_t) 1 << shift) - 1;
+}
+
+void sl_trace_histogram_record(sl_trace_histogram *histogram, uint64_t value)
+{
+    if (histogram->count == 0 || value < histogram->min) {
+        histogram->min = value;
+    }
+
+    if (value > histogram->max) {
+        histogram->max = value;
+    }
+
+    histogram->count ++;
+    histogram->sum += value;
+    histogram->buckets[sl_trace_histogram_index(value)] ++;
+}
+
+uint64_t sl_trace_histogram_percentile(sl_trace_histogram *histogram, double percentile)
+{
+    if (histogram->count == 0) {
+        return 0;
+    }
+
+    uint64_t target = (uint64_t) (percentile / 100.0 * histogram->count + 0.5), seen = 0;
+    if (target == 0) {
+        target = 1;
+    }
+
+    for (size_t n = 0; n < SL_TRACE_BUCKETS; n ++) {
+        seen += histogram->buckets[n];
+
+        if (seen >= target) {
+            uint64_t upper = sl_trace_histogram_upper(n);
+            return upper < histogram->max ? upper : histogram->max;
+        }
+    }
+
+    return histogram->max;
+}
+
+void sl_trace_init(sl_trace *trace, size_t sample_rate)
+{
+    memset(trace, 0, sizeof(*trace));
+
+    trace->sample_rate = sample_rate;
+    trace->route_names[SL_TRACE_ROUTE_OTHER] = sl_string_init_with_cstring("other");
+    trace->route_count = 1;
+}
+
+int sl_trace_register_route(sl_trace *trace, char *name)
+{
+    if (trace->route_count >= SL_TRACE_MAX_ROUTES) {
+        return -1;
+    }
+
+    trace->route_names[trace->route_count] = sl_string_init_with_cstring(name);
+
+    return trace->route_count ++;
+}
+
+size_t sl_trace_find_route(sl_trace *trace, sl_string *name)
+{
+    if (name == NULL) {
+        return SL_TRACE_ROUTE_OTHER;
+    }
+
+    for (size_t n = SL_TRACE_ROUTE_OTHER + 1; n < trace->route_count; n ++) {
+        if (sl_view_equal(&trace->route_names[n], name) == true) {
+            return n;
+        }
+    }
+
+    return SL_TRACE_ROUTE_OTHER;
+}
+
+void sl_trace_span_begin(sl_trace *trace, sl_trace_span *span, uint64_t start)
+{
+    if (span->start != 0) {
+        return;
+    }
+
+    span->start = start;
+
+    if (trace->sample_rate > 0 && ++ trace->sample_counter >= trace->sample_rate) {
+        trace->sample_counter = 0;
+        span->sampled = true;
+    }
+}
+
+inline void sl_trace_span_record(sl_trace_span *span, sl_trace_phase phase, uint64_t start)
+{
+    if (span->start == 0) {
+        return;
+    }
+
+    span->durations[phase] += sl_trace_now() - start;
+    span->phases |= 1 << phase;
+}
+
+uint64_t sl_trace_span_finish(sl_trace *trace, sl_trace_span *span, sl_log *log)
+{
+    if (span->start == 0) {
+        return 0;
+    }
+
+    uint64_t durations[SL_TRACE_PHASES];
+
+    span->durations[SL_TRACE_PHASE_REQUEST] = sl_trace_now() - span->start;
+    span->phases |= 1 << SL_TRACE_PHASE_REQUEST;
+
+    for (size_t n = 0; n < SL_TRACE_PHASES; n ++) {
+        durations[n] = sl_trace_to_ns(span->durations[n]);
+
+        if ((span->phases & (1 << n)) != 0) {
+            sl_trace_histogram_record(&trace->phases[n], durations[n]);
+        }
+    }
+
+    sl_trace_histogram_record(&trace->routes[span->route], durations[SL_TRACE_PHASE_REQUEST]);
+    trace->requests ++;
+
+    if (span->sampled == true) {
+        trace->sampled ++;
+
+        SL_LOG_WRITE_FORMAT(log, SL_LOG_INFO, "Trace %S: recv %z ns, parse %z ns, process %z ns, execute %z ns, send %z ns, total %z ns",
+            &trace->route_names[span->route], durations[SL_TRACE_PHASE_RECV], durations[SL_TRACE_PHASE_PARSE], durations[SL_TRACE_PHASE_PROCESS],
+            durations[SL_TRACE_PHASE_EXECUTE], durations[SL_TRACE_PHASE_SEND], durations[SL_TRACE_PHASE_REQUEST]);
+    }
+
+    *span = (sl_trace_span) {0};
+
+    return durations[SL_TRACE_PHASE_REQUEST];
+}
+
+static void sl_trace_log_histogram(sl_log *log, char *kind, sl_string *name, sl_trace_histogram *histogram)
+{
+    SL_LOG_WRITE_FORMAT(log, SL_LOG_INFO, "Latency %s %S: %z samples, p50 %z ns, p90 %z ns, p99 %z ns, p99.9 %z ns, max %z ns",
+        kind, name, histogram->count, sl_trace_histogram_percentile(histogram, 50.0), sl_trace_histogram_percentile(histogram, 90.0),
+        sl_trace_histogram_percentile(histogram, 99.0), sl_trace_histogram_percentile(histogram, 99.9), histogram->max);
+}
+
+void sl_trace_log_summary(sl_trace *trace, sl_log *log)
+{
+    SL_LOG_WRITE_FORMAT(log, SL_LOG_INFO, "Tracing: %z requests, %z sampled, clock %s", trace->requests, trace->sampled, sl_trace_source == SL_TRACE_CLOCK_TSC ? "tsc" : "monotonic_raw");
+
+    for (size_t n = 0; n < SL_TRACE_PHASES; n ++) {
+        if (trace->phases[n].count > 0) {
+            sl_string name = sl_string_init_with_cstring(sl_trace_phase_names[n]);
+            sl_trace_log_histogram(log, "phase", &name, &trace->phases[n]);
+        }
+    }
+
+    for (size_t n = 0; n < trace->route_count; n ++) {
+        if (trace->routes[n].count > 0) {
+            sl_trace_log_histogram(log, "route", &trace->route_names[n], &trace->routes[n]);
+        }
+    }
+}
@@ -0,0 +1,85 @@
+#ifndef SL_TRACE_H
+#define SL_TRACE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "sl_string.h"
+#include "sl_log.h"
+
+#define SL_TRACE_SUB_BUCKET_BITS  4
+#define SL_TRACE_SUB_BUCKETS      (1 << SL_TRACE_SUB_BUCKET_BITS)
+#define SL_TRACE_MAGNITUDES       40
+#define SL_TRACE_BUCKETS          ((SL_TRACE_MAGNITUDES - SL_TRACE_SUB_BUCKET_BITS + 1) * SL_TRACE_SUB_BUCKETS)
+#define SL_TRACE_MAX_ROUTES       16
+#define SL_TRACE_ROUTE_OTHER       0
+#define SL_TRACE_CALIBRATE_NS     (10 * 1000 * 1000)
+
+typedef enum sl_trace_phase sl_trace_phase;
+typedef enum sl_trace_clock sl_trace_clock;
+
+typedef struct sl_trace_histogram sl_trace_histogram;
+typedef struct sl_trace_span sl_trace_span;
+typedef struct sl_trace sl_trace;
+
+enum sl_trace_phase {
+    SL_TRACE_PHASE_RECV,
+    SL_TRACE_PHASE_PARSE,
+    SL_TRACE_PHASE_PROCESS,
+    SL_TRACE_PHASE_EXECUTE,
+    SL_TRACE_PHASE_SEND,
+    SL_TRACE_PHASE_REQUEST,
+    SL_TRACE_PHASES
+};
+
+enum sl_trace_clock {
+    SL_TRACE_CLOCK_MONOTONIC_RAW,
+    SL_TRACE_CLOCK_TSC
+};
+
+struct sl_trace_histogram {
+    uint64_t count;
+    uint64_t sum;
+    uint64_t min;
+    uint64_t max;
+    uint32_t buckets[SL_TRACE_BUCKETS];
+};
+
+struct sl_trace_span {
+    uint64_t start;
+    uint64_t durations[SL_TRACE_PHASES];
+    uint32_t phases;
+    size_t route;
+    bool sampled;
+};
+
+struct sl_trace {
+    sl_trace_histogram phases[SL_TRACE_PHASES];
+    sl_trace_histogram routes[SL_TRACE_MAX_ROUTES];
+    sl_string route_names[SL_TRACE_MAX_ROUTES];
+    size_t route_count;
+    size_t sample_rate;
+    size_t sample_counter;
+    size_t requests;
+    size_t sampled;
+};
+
+void sl_trace_calibrate(void);
+sl_trace_clock sl_trace_get_clock(void);
+uint64_t sl_trace_now(void);
+uint64_t sl_trace_to_ns(uint64_t ticks);
+
+void sl_trace_histogram_record(sl_trace_histogram *histogram, uint64_t value);
+uint64_t sl_trace_histogram_percentile(sl_trace_histogram *histogram, double percentile);
+
+void sl_trace_init(sl_trace *trace, size_t sample_rate);
+int sl_trace_register_route(sl_trace *trace, char *name);
+size_t sl_trace_find_route(sl_trace *trace, sl_string *name);
+
+void sl_trace_span_begin(sl_trace *trace, sl_trace_span *span, uint64_t start);
+void sl_trace_span_record(sl_trace_span *span, sl_trace_phase phase, uint64_t start);
+uint64_t sl_trace_span_finish(sl_trace *trace, sl_trace_span *span, sl_log *log);
+void sl_trace_log_summary(sl_trace *trace, sl_log *log);
+
+#endif
@@ -0,0 +1,604 @@
+#include "sl_view.h"
+#include "sl_cpu.h"
+
+#include <string.h>
+
+#ifdef SL_CPU_X86
+#include <immintrin.h>
+#endif
+
+#define SL_VIEW_ASCII_OFFSET 0x3f
+#define SL_VIEW_ASCII_BOUND  (-128 + 26)
+
+static inline uint64_t sl_view_read64(char *buffer)
+{
+    uint64_t value;
+
+    memcpy(&value, buffer, sizeof(value));
+
+    return value;
+}
+
+static inline char sl_view_lower(char c)
+{
+    return c >= 'A' && c <= 'Z' ? c | 0x20 : c;
+}
+
+static inline uint64_t sl_view_lower64(uint64_t chunk)
+{
+    uint64_t ascii = chunk & 0x7f7f7f7f7f7f7f7f;
+    uint64_t above_a = ascii + 0x3f3f3f3f3f3f3f3f;
+    uint64_t above_z = ascii + 0x2525252525252525;
+    uint64_t upper = ~chunk & (above_a ^ above_z) & 0x8080808080808080;
+
+    return chunk | (upper >> 2);
+}
+
+static bool sl_view_equal_scalar(char *a, char *b, size_t length)
+{
+    size_t n = 0;
+
+    for (; n + 8 <= length; n += 8) {
+        if (sl_view_read64(a + n) != sl_view_read64(b + n)) {
+            return false;
+        }
+    }
+
+    for (; n < length; n ++) {
+        if (a[n] != b[n]) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool sl_view_equal_case_scalar(char *a, char *b, size_t length)
+{
+    size_t n = 0;
+
+    for (; n + 8 <= length; n += 8) {
+        if (sl_view_lower64(sl_view_read64(a + n)) != sl_view_lower64(sl_view_read64(b + n))) {
+            return false;
+        }
+    }
+
+    for (; n < length; n ++) {
+        if (a[n] != b[n] && sl_view_lower(a[n]) != sl_view_lower(b[n])) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static size_t sl_view_find_byte_scalar(char *buffer, size_t length, char c)
+{
+    for (size_t n = 0; n < length; n ++) {
+        if (buffer[n] == c) {
+            return n;
+        }
+    }
+
+    return SL_VIEW_NOT_FOUND;
+}
+
+static size_t sl_view_find_scalar(char *buffer, size_t length, char *needle, size_t needle_length)
+{
+    for (size_t n = 0; n + needle_length <= length; n ++) {
+        if (buffer[n] == needle[0] && buffer[n + needle_length - 1] == needle[needle_length - 1] &&
+            memcmp(buffer + n + 1, needle + 1, needle_length - 2) == 0) {
+            return n;
+        }
+    }
+
+    return SL_VIEW_NOT_FOUND;
+}
+
+#ifdef SL_CPU_X86
+__attribute__((target("sse2")))
+static inline __m128i sl_view_lower_sse2(__m128i chunk)
+{
+    __m128i upper = _mm_cmplt_epi8(_mm_add_epi8(chunk, _mm_set1_epi8(SL_VIEW_ASCII_OFFSET)), _mm_set1_epi8(SL_VIEW_ASCII_BOUND));
+
+    return _mm_or_si128(chunk, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+}
+
+__attribute__((target("sse2")))
+static bool sl_view_equal_sse2(char *a, char *b, size_t length)
+{
+    size_t n = 0;
+
+    for (; n + 32 < length; n += 32) {
+        __m128i first = _mm_cmpeq_epi8(_mm_loadu_si128((__m128i *) (a + n)), _mm_loadu_si128((__m128i *) (b + n)));
+        __m128i second = _mm_cmpeq_epi8(_mm_loadu_si128((__m128i *) (a + n + 16)), _mm_loadu_si128((__m128i *) (b + n + 16)));
+
+        if (_mm_movemask_epi8(_mm_and_si128(first, second)) != 0xffff) {
+            return false;
+        }
+    }
+
+    for (; n + 16 < length; n += 16) {
+        __m128i chunk_a = _mm_loadu_si128((__m128i *) (a + n));
+        __m128i chunk_b = _mm_loadu_si128((__m128i *) (b + n));
+
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(chunk_a, chunk_b)) != 0xffff) {
+            return false;
+        }
+    }
+
+    __m128i chunk_a = _mm_loadu_si128((__m128i *) (a + length - 16));
+    __m128i chunk_b = _mm_loadu_si128((__m128i *) (b + length - 16));
+
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(chunk_a, chunk_b)) == 0xffff;
+}
+
+__attribute__((target("sse2")))
+static bool sl_view_equal_case_sse2(char *a, char *b, size_t length)
+{
+    size_t n = 0;
+
+    for (; n + 32 < length; n += 32) {
+        __m128i first = _mm_cmpeq_epi8(sl_view_lower_sse2(_mm_loadu_si128((__m128i *) (a + n))), sl_view_lower_sse2(_mm_loadu_si128((__m128i *) (b + n))));
+        __m128i second = _mm_cmpeq_epi8(sl_view_lower_sse2(_mm_loadu_si128((__m128i *) (a + n + 16))), sl_view_lower_sse2(_mm_loadu_si128((__m128i *) (b + n + 16))));
+
+        if (_mm_movemask_epi8(_mm_and_si128(first, second)) != 0xffff) {
+            return false;
+        }
+    }
+
+    for (; n + 16 < length; n += 16) {
+        __m128i chunk_a = sl_view_lower_sse2(_mm_loadu_si128((__m128i *) (a + n)));
+        __m128i chunk_b = sl_view_lower_sse2(_mm_loadu_si128((__m128i *) (b + n)));
+
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(chunk_a, chunk_b)) != 0xffff) {
+            return false;
+        }
+    }
+
+    __m128i chunk_a = sl_view_lower_sse2(_mm_loadu_si128((__m128i *) (a + length - 16)));
+    __m128i chunk_b = sl_view_lower_sse2(_mm_loadu_si128((__m128i *) (b + length - 16)));
+
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(chunk_a, chunk_b)) == 0xffff;
+}
+
+__attribute__((target("sse2")))
+static size_t sl_view_find_byte_sse2(char *buffer, size_t length, char c)
+{
+    __m128i target = _mm_set1_epi8(c);
+    size_t n = 0;
+
+    for (; n + 16 <= length; n += 16) {
+        __m128i chunk = _mm_loadu_si128((__m128i *) (buffer + n));
+
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, target));
+        if (mask != 0) {
+            return n + __builtin_ctz(mask);
+        }
+    }
+
+    size_t found = sl_view_find_byte_scalar(buffer + n, length - n, c);
+
+    return found == SL_VIEW_NOT_FOUND ? found : n + found;
+}
+
+__attribute__((target("sse2")))
+static size_t sl_view_find_sse2(char *buffer, size_t length, char *needle, size_t needle_length)
+{
+    __m128i first = _mm_set1_epi8(needle[0]);
+    __m128i last = _mm_set1_epi8(needle[needle_length - 1]);
+    size_t n = 0;
+
+    for (; n + needle_length - 1 + 16 <= length; n += 16) {
+        __m128i chunk_first = _mm_loadu_si128((__m128i *) (buffer + n));
+        __m128i chunk_last = _mm_loadu_si128((__m128i *) (buffer + n + needle_length - 1));
+
+        int mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(chunk_first, first), _mm_cmpeq_epi8(chunk_last, last)));
+
+        while (mask != 0) {
+            size_t offset = n + __builtin_ctz(mask);
+
+            if (memcmp(buffer + offset + 1, needle + 1, needle_length - 2) == 0) {
+                return offset;
+            }
+
+            mask &= mask - 1;
+        }
+    }
+
+    size_t found = sl_view_find_scalar(buffer + n, length - n, needle, needle_length);
+
+    return found == SL_VIEW_NOT_FOUND ? found : n + found;
+}
+
+__attribute__((target("avx2")))
+static inline __m256i sl_view_lower_avx2(__m256i chunk)
+{
+    __m256i upper = _mm256_cmpgt_epi8(_mm256_set1_epi8(SL_VIEW_ASCII_BOUND), _mm256_add_epi8(chunk, _mm256_set1_epi8(SL_VIEW_ASCII_OFFSET)));
+
+    return _mm256_or_si256(chunk, _mm256_and_si256(upper, _mm256_set1_epi8(0x20)));
+}
+
+__attribute__((target("avx2")))
+static inline __m128i sl_view_lower_avx2_half(__m128i chunk)
+{
+    __m128i upper = _mm_cmplt_epi8(_mm_add_epi8(chunk, _mm_set1_epi8(SL_VIEW_ASCII_OFFSET)), _mm_set1_epi8(SL_VIEW_ASCII_BOUND));
+
+    return _mm_or_si128(chunk, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+}
+
+__attribute__((target("avx2")))
+static bool sl_view_equal_avx2(char *a, char *b, size_t length)
+{
+    if (length <= 32) {
+        __m128i head = _mm_cmpeq_epi8(_mm_loadu_si128((__m128i *) a), _mm_loadu_si128((__m128i *) b));
+        __m128i tail = _mm_cmpeq_epi8(_mm_loadu_si128((__m128i *) (a + length - 16)), _mm_loadu_si128((__m128i *) (b + length - 16)));
+
+        return _mm_movemask_epi8(_mm_and_si128(head, tail)) == 0xffff;
+    }
+
+    size_t n = 0;
+
+    for (; n + 64 < length; n += 64) {
+        __m256i first = _mm256_cmpeq_epi8(_mm256_loadu_si256((__m256i *) (a + n)), _mm256_loadu_si256((__m256i *) (b + n)));
+        __m256i second = _mm256_cmpeq_epi8(_mm256_loadu_si256((__m256i *) (a + n + 32)), _mm256_loadu_si256((__m256i *) (b + n + 32)));
+
+        if ((uint32_t) _mm256_movemask_epi8(_mm256_and_si256(first, second)) != 0xffffffff) {
+            return false;
+        }
+    }
+
+    for (; n + 32 < length; n += 32) {
+        __m256i chunk_a = _mm256_loadu_si256((__m256i *) (a + n));
+        __m256i chunk_b = _mm256_loadu_si256((__m256i *) (b + n));
+
+        if ((uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk_a, chunk_b)) != 0xffffffff) {
+            return false;
+        }
+    }
+
+    __m256i chunk_a = _mm256_loadu_si256((__m256i *) (a + length - 32));
+    __m256i chunk_b = _mm256_loadu_si256((__m256i *) (b + length - 32));
+
+    return (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk_a, chunk_b)) == 0xffffffff;
+}
+
+__attribute__((target("avx2")))
+static bool sl_view_equal_case_avx2(char *a, char *b, size_t length)
+{
+    if (length <= 32) {
+        __m128i head = _mm_cmpeq_epi8(sl_view_lower_avx2_half(_mm_loadu_si128((__m128i *) a)), sl_view_lower_avx2_half(_mm_loadu_si128((__m128i *) b)));
+        __m128i tail = _mm_cmpeq_epi8(sl_view_lower_avx2_half(_mm_loadu_si128((__m128i *) (a + length - 16))), sl_view_lower_avx2_half(_mm_loadu_si128((__m128i *) (b + length - 16))));
+
+        return _mm_movemask_epi8(_mm_and_si128(head, tail)) == 0xffff;
+    }
+
+    size_t n = 0;
+
+    for (; n + 64 < length; n += 64) {
+        __m256i first = _mm256_cmpeq_epi8(sl_view_lower_avx2(_mm256_loadu_si256((__m256i *) (a + n))), sl_view_lower_avx2(_mm256_loadu_si256((__m256i *) (b + n))));
+        __m256i second = _mm256_cmpeq_epi8(sl_view_lower_avx2(_mm256_loadu_si256((__m256i *) (a + n + 32))), sl_view_lower_avx2(_mm256_loadu_si256((__m256i *) (b + n + 32))));
+
+        if ((uint32_t) _mm256_movemask_epi8(_mm256_and_si256(first, second)) != 0xffffffff) {
+            return false;
+        }
+    }
+
+    for (; n + 32 < length; n += 32) {
+        __m256i chunk_a = sl_view_lower_avx2(_mm256_loadu_si256((__m256i *) (a + n)));
+        __m256i chunk_b = sl_view_lower_avx2(_mm256_loadu_si256((__m256i *) (b + n)));
+
+        if ((uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk_a, chunk_b)) != 0xffffffff) {
+            return false;
+        }
+    }
+
+    __m256i chunk_a = sl_view_lower_avx2(_mm256_loadu_si256((__m256i *) (a + length - 32)));
+    __m256i chunk_b = sl_view_lower_avx2(_mm256_loadu_si256((__m256i *) (b + length - 32)));
+
+    return (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk_a, chunk_b)) == 0xffffffff;
+}
+
+__attribute__((target("avx2")))
+static size_t sl_view_find_byte_avx2(char *buffer, size_t length, char c)
+{
+    __m256i target = _mm256_set1_epi8(c);
+    size_t n = 0;
+
+    for (; n + 32 <= length; n += 32) {
+        __m256i chunk = _mm256_loadu_si256((__m256i *) (buffer + n));
+
+        uint32_t mask = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, target));
+        if (mask != 0) {
+            return n + __builtin_ctz(mask);
+        }
+    }
+
+    if (n + 16 <= length) {
+        __m128i chunk = _mm_loadu_si128((__m128i *) (buffer + n));
+
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm256_castsi256_si128(target)));
+        if (mask != 0) {
+            return n + __builtin_ctz(mask);
+        }
+
+        n += 16;
+    }
+
+    size_t found = sl_view_find_byte_scalar(buffer + n, length - n, c);
+
+    return found == SL_VIEW_NOT_FOUND ? found : n + found;
+}
+
+__attribute__((target("avx2")))
+static size_t sl_view_find_avx2(char *buffer, size_t length, char *needle, size_t needle_length)
+{
+    __m256i first = _mm256_set1_epi8(needle[0]);
+    __m256i last = _mm256_set1_epi8(needle[needle_length - 1]);
+    size_t n = 0;
+
+    for (; n + needle_length - 1 + 32 <= length; n += 32) {
+        __m256i chunk_first = _mm256_loadu_si256((__m256i *) (buffer + n));
+        __m256i chunk_last = _mm256_loadu_si256((__m256i *) (buffer + n + needle_length - 1));
+
+        uint32_t mask = (uint32_t) _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(chunk_first, first), _mm256_cmpeq_epi8(chunk_last, last)));
+
+        while (mask != 0) {
+            size_t offset = n + __builtin_ctz(mask);
+
+            if (memcmp(buffer + offset + 1, needle + 1, needle_length - 2) == 0) {
+                return offset;
+            }
+
+            mask &= mask - 1;
+        }
+    }
+
+    size_t found = sl_view_find_scalar(buffer + n, length - n, needle, needle_length);
+
+    return found == SL_VIEW_NOT_FOUND ? found : n + found;
+}
+#endif
+
+bool sl_view_equal(sl_string *a, sl_string *b)
+{
+    if (a->length != b->length) {
+        return false;
+    }
+
+    if (a->length < 16) {
+        return sl_view_equal_scalar(a->buffer, b->buffer, a->length);
+    }
+
+    switch (sl_cpu_get_level()) {
+#ifdef SL_CPU_X86
+        case SL_CPU_AVX2:
+            return sl_view_equal_avx2(a->buffer, b->buffer, a->length);
+        case SL_CPU_SSE2:
+            return sl_view_equal_sse2(a->buffer, b->buffer, a->length);
+#endif
+        default:
+            return sl_view_equal_scalar(a->buffer, b->buffer, a->length);
+    }
+}
+
+bool sl_view_equal_case(sl_string *a, sl_string *b)
+{
+    if (a->length != b->length) {
+        return false;
+    }
+
+    if (a->length < 16) {
+        return sl_view_equal_case_scalar(a->buffer, b->buffer, a->length);
+    }
+
+    switch (sl_cpu_get_level()) {
+#ifdef SL_CPU_X86
+        case SL_CPU_AVX2:
+            return sl_view_equal_case_avx2(a->buffer, b->buffer, a->length);
+        case SL_CPU_SSE2:
+            return sl_view_equal_case_sse2(a->buffer, b->buffer, a->length);
+#endif
+        default:
+            return sl_view_equal_case_scalar(a->buffer, b->buffer, a->length);
+    }
+}
+
+bool sl_view_equal_cstring(sl_string *a, char *b)
+{
+    sl_string other = sl_string_init_with_buffer(b, strlen(b));
+
+    return sl_view_equal(a, &other);
+}
+
+size_t sl_view_find_byte(sl_string *string, char c)
+{
+    switch (sl_cpu_get_level()) {
+#ifdef SL_CPU_X86
+        case SL_CPU_AVX2:
+            return sl_view_find_byte_avx2(string->buffer, string->length, c);
+        case SL_CPU_SSE2:
+            return sl_view_find_byte_sse2(string->buffer, string->length, c);
+#endif
+        default:
+            return sl_view_find_byte_scalar(string->buffer, string->length, c);
+    }
+}
+
+size_t sl_view_find(sl_string *string, sl_string *needle)
+{
+    if (needle->length == 0) {
+        return 0;
+    }
+
+    if (needle->length > string->length) {
+        return SL_VIEW_NOT_FOUND;
+    }
+
+    if (needle->length == 1) {
+        return sl_view_find_byte(string, needle->buffer[0]);
+    }
+
+    switch (sl_cpu_get_level()) {
+#ifdef SL_CPU_X86
+        case SL_CPU_AVX2:
+            return sl_view_find_avx2(string->buffer, string->length, needle->buffer, needle->length);
+        case SL_CPU_SSE2:
+            return sl_view_find_sse2(string->buffer, string->length, needle->buffer, needle->length);
+#endif
+        default:
+            return sl_view_find_scalar(string->buffer, string->length, needle->buffer, needle->length);
+    }
+}
+
+sl_string sl_view_slice(sl_string *string, size_t start, size_t length)
+{
+    if (start > string->length) {
+        start = string->length;
+    }
+
+    if (length > string->length - start) {
+        length = string->length - start;
+    }
+
+    return sl_string_init_with_buffer(string->buffer + start, length);
+}
+
+static inline bool sl_view_is_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+sl_string sl_view_trim(sl_string *string)
+{
+    size_t start = 0, end = string->length;
+
+    while (start < end && sl_view_is_space(string->buffer[start])) {
+        start ++;
+    }
+
+    while (end > start && sl_view_is_space(string->buffer[end - 1])) {
+        end --;
+    }
+
+    return sl_string_init_with_buffer(string->buffer + start, end - start);
+}
+
+void sl_view_split_init(sl_view_split *split, sl_string *source, char separator)
+{
+    split->source = sl_string_init_with_buffer(source->buffer, source->length);
+    split->position = 0;
+    split->separator = separator;
+    split->finished = false;
+}
+
+bool sl_view_split_next(sl_view_split *split, sl_string *token)
+{
+    if (split->finished) {
+        return false;
+    }
+
+    sl_string rest = sl_view_slice(&split->source, split->position, split->source.length);
+
+    size_t found = sl_view_find_byte(&rest, split->separator);
+    if (found == SL_VIEW_NOT_FOUND) {
+        *token = rest;
+        split->finished = true;
+
+        return true;
+    }
+
+    *token = sl_view_slice(&rest, 0, found);
+    split->position += found + 1;
+
+    return true;
+}
+
+static inline bool sl_view_is_eight_digits(uint64_t chunk)
+{
+    return ((chunk & 0xf0f0f0f0f0f0f0f0) | (((chunk + 0x0606060606060606) & 0xf0f0f0f0f0f0f0f0) >> 4)) == 0x3333333333333333;
+}
+
+static inline uint64_t sl_view_parse_eight_digits(uint64_t chunk)
+{
+    chunk -= 0x3030303030303030;
+    chunk = (chunk * 10) + (chunk >> 8);
+
+    return (((chunk & 0x000000ff000000ff) * (100 + (1000000ull << 32))) +
+            (((chunk >> 16) & 0x000000ff000000ff) * (1 + (10000ull << 32)))) >> 32;
+}
+
+int sl_view_parse_unsigned(sl_string *string, uint64_t *value)
+{
+    char *buffer = string->buffer;
+    size_t length = string->length, n = 0;
+    uint64_t result = 0;
+
+    if (length == 0) {
+        return -1;
+    }
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    for (; n + 8 <= length; n += 8) {
+        uint64_t chunk = sl_view_read64(buffer + n);
+
+        if (!sl_view_is_eight_digits(chunk)) {
+            break;
+        }
+
+        uint64_t digits = sl_view_parse_eight_digits(chunk);
+
+        if (result > (UINT64_MAX - digits) / 100000000) {
+            return -1;
+        }
+
+        result = result * 100000000 + digits;
+    }
+#endif
+
+    for (; n < length; n ++) {
+        uint64_t digit = (uint64_t) (buffer[n] - '0');
+
+        if (digit > 9 || result > (UINT64_MAX - digit) / 10) {
+            return -1;
+        }
+
+        result = result * 10 + digit;
+    }
+
+    *value = result;
+
+    return 0;
+}
+
+int sl_view_parse_signed(sl_string *string, int64_t *value)
+{
+    sl_string digits = *string;
+    bool negative = false;
+    uint64_t result;
+
+    if (digits.length > 0 && (digits.buffer[0] == '-' || digits.buffer[0] == '+')) {
+        negative = digits.buffer[0] == '-';
+        digits = sl_view_slice(string, 1, string->length);
+    }
+
+    if (sl_view_parse_unsigned(&digits, &result) == -1) {
+        return -1;
+    }
+
+    if (negative) {
+        if (result > (uint64_t) INT64_MAX + 1) {
+            return -1;
+        }
+
+        *value = result == (uint64_t) INT64_MAX + 1 ? INT64_MIN : -(int64_t) result;
+    } else {
+        if (result > INT64_MAX) {
+            return -1;
+        }
+
+        *value = (int64_t) result;
+    }
+
+    return 0;
+}
@@ -0,0 +1,36 @@
+#ifndef SL_VIEW_H
+#define SL_VIEW_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "sl_string.h"
+
+#define SL_VIEW_NOT_FOUND SIZE_MAX
+
+typedef struct sl_view_split sl_view_split;
+
+struct sl_view_split {
+    sl_string source;
+    size_t position;
+    char separator;
+    bool finished;
+};
+
+bool sl_view_equal(sl_string *a, sl_string *b);
+bool sl_view_equal_case(sl_string *a, sl_string *b);
+bool sl_view_equal_cstring(sl_string *a, char *b);
+size_t sl_view_find_byte(sl_string *string, char c);
+size_t sl_view_find(sl_string *string, sl_string *needle);
+
+sl_string sl_view_slice(sl_string *string, size_t start, size_t length);
+sl_string sl_view_trim(sl_string *string);
+
+void sl_view_split_init(sl_view_split *split, sl_string *source, char separator);
+bool sl_view_split_next(sl_view_split *split, sl_string *token);
+
+int sl_view_parse_unsigned(sl_string *string, uint64_t *value);
+int sl_view_parse_signed(sl_string *string, int64_t *value);
+
+#endif
@@ -0,0 +1,870 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include "../sl_arena.h"
+#include "../sl_string.h"
+#include "../sl_fcgi.h"
+#include "../sl_net.h"
+#include "../sl_trace.h"
+
+#define SL_LOADGEN_ARENA_PREALLOCATE 102400
+#define SL_LOADGEN_RECV_BUFFER_SIZE  (64 * 1024)
+#define SL_LOADGEN_MAX_DEPTH         64
+#define SL_LOADGEN_MAX_PARAMS        64
+#define SL_LOADGEN_MAX_EVENTS        256
+#define SL_LOADGEN_POLL_INTERVAL_MS  10
+
+#define SL_LOADGEN_DEFAULT_PORT        9000
+#define SL_LOADGEN_DEFAULT_CONNECTIONS 16
+#define SL_LOADGEN_DEFAULT_DURATION    5
+#define SL_LOADGEN_DEFAULT_WARMUP      1
+#define SL_LOADGEN_DEFAULT_TIMEOUT_MS  2000
+
+typedef struct sl_loadgen_scenario sl_loadgen_scenario;
+typedef struct sl_loadgen_config sl_loadgen_config;
+typedef struct sl_loadgen_connection sl_loadgen_connection;
+typedef struct sl_loadgen sl_loadgen;
+
+struct sl_loadgen_scenario {
+    char *name;
+    char *document_uri;
+    char *accept_encoding;
+    size_t connections;
+    size_t depth;
+    size_t extra_params;
+    size_t body_size;
+    bool keep_alive;
+};
+
+struct sl_loadgen_config {
+    struct sockaddr_storage address;
+    socklen_t address_length;
+    uint64_t duration_ns;
+    uint64_t warmup_ns;
+    uint64_t timeout_ns;
+    size_t max_requests;
+    char *query_string;
+    char *params[SL_LOADGEN_MAX_PARAMS];
+    size_t param_count;
+};
+
+struct sl_loadgen_connection {
+    int fd;
+    bool writing;
+    size_t queue[SL_LOADGEN_MAX_DEPTH];
+    size_t queue_head;
+    size_t queue_count;
+    size_t write_offset;
+    uint64_t sent_at[SL_LOADGEN_MAX_DEPTH];
+    bool pending[SL_LOADGEN_MAX_DEPTH];
+    size_t in_flight;
+    uint8_t header[sizeof(sl_fcgi_msg_header)];
+    size_t header_read;
+    size_t content_remaining;
+    size_t padding_remaining;
+};
+
+struct sl_loadgen {
+    sl_loadgen_config *config;
+    sl_loadgen_scenario *scenario;
+    sl_string templates[SL_LOADGEN_MAX_DEPTH];
+    sl_loadgen_connection *connections;
+    int epoll_instance;
+    uint64_t measure_start;
+    uint64_t measure_end;
+    bool running;
+    sl_trace_histogram latency;
+    size_t requests;
+    size_t errors;
+    size_t timeouts;
+    size_t reconnects;
+    size_t bytes;
+};
+
+static sl_loadgen_scenario sl_loadgen_suite[] = {
+    {"cached/keepalive/c1",     "/",         "",     1, 1,  0,     0, true},
+    {"cached/keepalive/c16",    "/",         "",    16, 1,  0,     0, true},
+    {"cached/close/c16",        "/",         "",    16, 1,  0,     0, false},
+    {"dynamic/keepalive/c16",   "/bench",    "",    16, 1,  0,     0, true},
+    {"params32/keepalive/c16",  "/bench",    "",    16, 1, 32,     0, true},
+    {"body4k/keepalive/c16",    "/bench",    "",    16, 1,  0,  4096, true},
+    {"body64k/keepalive/c16",   "/bench",    "",    16, 1,  0, 65536, true},
+    {"metrics/keepalive/c4",    "/metrics",  "",     4, 1,  0,     0, true},
+    {"metrics/gzip/c4",         "/metrics",  "gzip", 4, 1,  0,     0, true}
+};
+
+static volatile bool sl_loadgen_interrupted = false;
+
+static uint64_t sl_loadgen_now(void)
+{
+    struct timespec timestamp;
+
+    clock_gettime(CLOCK_MONOTONIC, &timestamp);
+
+    return (uint64_t) timestamp.tv_sec * 1000000000 + timestamp.tv_nsec;
+}
+
+static void sl_loadgen_signal_handler(int signal_number)
+{
+    (void) signal_number;
+
+    sl_loadgen_interrupted = true;
+}
+
+static int sl_loadgen_append_record(sl_string_builder *builder, uint8_t type, uint16_t request_id, uint8_t *content, size_t length)
+{
+    do {
+        size_t chunk = length < SL_FCGI_MAX_CONTENT_LENGTH ? length : SL_FCGI_MAX_CONTENT_LENGTH;
+
+        sl_fcgi_msg_header header = {
+            .version = SL_FCGI_VERSION,
+            .type = type,
+            .request_id = htons(request_id),
+            .content_length = htons(chunk),
+            .padding_length = 0,
+            .reserved = 0
+        };
+
+        if (sl_string_builder_append(builder, (char *) &header, sizeof(header)) == -1 ||
+            sl_string_builder_append(builder, (char *) content, chunk) == -1) {
+            return -1;
+        }
+
+        content += chunk;
+        length -= chunk;
+    } while (length > 0);
+
+    return 0;
+}
+
+static int sl_loadgen_append_length(sl_string_builder *builder, size_t length)
+{
+    if (length < 128) {
+        uint8_t byte = length;
+        return sl_string_builder_append(builder, (char *) &byte, 1);
+    }
+
+    uint32_t word = htonl(length | 0x80000000);
+
+    return sl_string_builder_append(builder, (char *) &word, sizeof(word));
+}
+
+static int sl_loadgen_append_param(sl_string_builder *builder, char *name, size_t name_length, char *value, size_t value_length)
+{
+    if (sl_loadgen_append_length(builder, name_length) == -1 ||
+        sl_loadgen_append_length(builder, value_length) == -1 ||
+        sl_string_builder_append(builder, name, name_length) == -1 ||
+        sl_string_builder_append(builder, value, value_length) == -1) {
+        return -1;
+    }
+
+    return 0;
+}
+
+static int sl_loadgen_append_cstring_param(sl_string_builder *builder, char *name, char *value)
+{
+    return sl_loadgen_append_param(builder, name, strlen(name), value, strlen(value));
+}
+
+static int sl_loadgen_build_params(sl_loadgen_config *config, sl_loadgen_scenario *scenario, sl_string_builder *params)
+{
+    char name[48], length[32];
+
+    snprintf(length, sizeof(length), "%zu", scenario->body_size);
+
+    if (sl_loadgen_append_cstring_param(params, "GATEWAY_INTERFACE", "CGI/1.1") == -1 ||
+        sl_loadgen_append_cstring_param(params, "REQUEST_METHOD", scenario->body_size > 0 ? "POST" : "GET") == -1 ||
+        sl_loadgen_append_cstring_param(params, "DOCUMENT_URI", scenario->document_uri) == -1 ||
+        sl_loadgen_append_cstring_param(params, "QUERY_STRING", config->query_string) == -1 ||
+        sl_loadgen_append_cstring_param(params, "CONTENT_LENGTH", length) == -1) {
+        return -1;
+    }
+
+    if (scenario->accept_encoding[0] != '\0' && sl_loadgen_append_cstring_param(params, "HTTP_ACCEPT_ENCODING", scenario->accept_encoding) == -1) {
+        return -1;
+    }
+
+    for (size_t n = 0; n < config->param_count; n ++) {
+        char *separator = strchr(config->params[n], '=');
+
+        if (sl_loadgen_append_param(params, config->params[n], separator - config->params[n], separator + 1, strlen(separator + 1)) == -1) {
+            return -1;
+        }
+    }
+
+    for (size_t n = 0; n < scenario->extra_params; n ++) {
+        snprintf(name, sizeof(name), "HTTP_X_LOADGEN_%zu", n);
+
+        if (sl_loadgen_append_cstring_param(params, name, "loadgen-parameter-value") == -1) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static int sl_loadgen_build_templates(sl_loadgen *loadgen, sl_arena *arena)
+{
+    sl_loadgen_scenario *scenario = loadgen->scenario;
+    sl_string_builder params;
+
+    sl_string_builder_init(&params, arena);
+
+    if (sl_loadgen_build_params(loadgen->config, scenario, &params) == -1) {
+        return -1;
+    }
+
+    uint8_t *body = sl_arena_allocate(arena, scenario->body_size + 1);
+    if (body == NULL) {
+        return -1;
+    }
+
+    memset(body, 'x', scenario->body_size);
+
+    sl_fcgi_msg_begin begin = {
+        .role = htons(1),
+        .flags = scenario->keep_alive == true ? SL_FCGI_FLAG_KEEP_CONN : 0
+    };
+
+    for (size_t n = 0; n < scenario->depth; n ++) {
+        sl_string_builder builder;
+        uint16_t request_id = n + 1;
+
+        sl_string_builder_init(&builder, arena);
+
+        if (sl_loadgen_append_record(&builder, SL_FCGI_TYPE_BEGIN_REQUEST, request_id, (uint8_t *) &begin, sizeof(begin)) == -1 ||
+            sl_loadgen_append_record(&builder, SL_FCGI_TYPE_PARAMS, request_id, (uint8_t *) params.string.buffer, params.string.length) == -1 ||
+            (params.string.length > 0 && sl_loadgen_append_record(&builder, SL_FCGI_TYPE_PARAMS, request_id, NULL, 0) == -1) ||
+            (scenario->body_size > 0 && sl_loadgen_append_record(&builder, SL_FCGI_TYPE_STDIN, request_id, body, scenario->body_size) == -1) ||
+            sl_loadgen_append_record(&builder, SL_FCGI_TYPE_STDIN, request_id, NULL, 0) == -1) {
+            return -1;
+        }
+
+        loadgen->templates[n] = builder.string;
+    }
+
+    return 0;
+}
+
+static void sl_loadgen_enqueue(sl_loadgen_connection *connection, size_t slot, uint64_t start)
+{
+    connection->queue[(connection->queue_head + connection->queue_count) % SL_LOADGEN_MAX_DEPTH] = slot;
+    connection->queue_count ++;
+    connection->sent_at[slot] = start;
+    connection->pending[slot] = true;
+    connection->in_flight ++;
+}
+
+static int sl_loadgen_set_events(sl_loadgen *loadgen, sl_loadgen_connection *connection, bool writing)
+{
+    struct epoll_event event = {
+        .events = EPOLLIN | (writing == true ? EPOLLOUT : 0),
+        .data.ptr = connection
+    };
+
+    if (connection->writing == writing) {
+        return 0;
+    }
+
+    connection->writing = writing;
+
+    return epoll_ctl(loadgen->epoll_instance, EPOLL_CTL_MOD, connection->fd, &event);
+}
+
+static int sl_loadgen_write(sl_loadgen *loadgen, sl_loadgen_connection *connection)
+{
+    struct iovec buffers[SL_LOADGEN_MAX_DEPTH];
+
+    while (connection->queue_count > 0) {
+        for (size_t n = 0; n < connection->queue_count; n ++) {
+            sl_string *request = &loadgen->templates[connection->queue[(connection->queue_head + n) % SL_LOADGEN_MAX_DEPTH]];
+            size_t offset = n == 0 ? connection->write_offset : 0;
+
+            buffers[n] = (struct iovec) {request->buffer + offset, request->length - offset};
+        }
+
+        ssize_t bytes_sent = writev(connection->fd, buffers, connection->queue_count);
+        if (bytes_sent == -1 && errno == EINTR) {
+            continue;
+        } else if (bytes_sent == -1 && errno == EAGAIN) {
+            return sl_loadgen_set_events(loadgen, connection, true);
+        } else if (bytes_sent == -1) {
+            return -1;
+        }
+
+        for (size_t n = 0; bytes_sent > 0; n ++) {
+            if ((size_t) bytes_sent < buffers[n].iov_len) {
+                connection->write_offset += bytes_sent;
+                break;
+            }
+
+            bytes_sent -= buffers[n].iov_len;
+            connection->queue_head = (connection->queue_head + 1) % SL_LOADGEN_MAX_DEPTH;
+            connection->queue_count --;
+            connection->write_offset = 0;
+        }
+    }
+
+    return sl_loadgen_set_events(loadgen, connection, false);
+}
+
+static int sl_loadgen_open(sl_loadgen *loadgen, sl_loadgen_connection *connection, uint64_t start)
+{
+    sl_loadgen_config *config = loadgen->config;
+    int one = 1;
+
+    *connection = (sl_loadgen_connection) {0};
+
+    connection->fd = socket(config->address.ss_family, SOCK_STREAM, 0);
+    if (connection->fd == -1) {
+        perror("socket()");
+        return -1;
+    }
+
+    if (connect(connection->fd, (struct sockaddr *) &config->address, config->address_length) == -1) {
+        perror("connect()");
+        close(connection->fd);
+        return -1;
+    }
+
+    if (config->address.ss_family == AF_INET && setsockopt(connection->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)) == -1) {
+        perror("setsockopt()");
+    }
+
+    if (sl_net_set_nonblocking_socket(connection->fd) == -1) {
+        perror("fcntl()");
+        close(connection->fd);
+        return -1;
+    }
+
+    struct epoll_event event = {
+        .events = EPOLLIN,
+        .data.ptr = connection
+    };
+
+    if (epoll_ctl(loadgen->epoll_instance, EPOLL_CTL_ADD, connection->fd, &event) == -1) {
+        perror("epoll_ctl()");
+        close(connection->fd);
+        return -1;
+    }
+
+    for (size_t n = 0; n < loadgen->scenario->depth; n ++) {
+        sl_loadgen_enqueue(connection, n, start);
+    }
+
+    return sl_loadgen_write(loadgen, connection);
+}
+
+static void sl_loadgen_close(sl_loadgen_connection *connection)
+{
+    if (connection->fd != -1) {
+        close(connection->fd);
+        connection->fd = -1;
+    }
+}
+
+static int sl_loadgen_reopen(sl_loadgen *loadgen, sl_loadgen_connection *connection, uint64_t start)
+{
+    sl_loadgen_close(connection);
+
+    loadgen->reconnects ++;
+
+    return sl_loadgen_open(loadgen, connection, start);
+}
+
+static int sl_loadgen_fail(sl_loadgen *loadgen, sl_loadgen_connection *connection, uint64_t now)
+{
+    if (now >= loadgen->measure_start) {
+        loadgen->errors += connection->in_flight;
+    }
+
+    return sl_loadgen_reopen(loadgen, connection, now);
+}
+
+static int sl_loadgen_complete(sl_loadgen *loadgen, sl_loadgen_connection *connection, uint16_t request_id)
+{
+    size_t slot = request_id - 1;
+    uint64_t now = sl_loadgen_now();
+
+    if (slot >= loadgen->scenario->depth || connection->pending[slot] == false) {
+        return -1;
+    }
+
+    connection->pending[slot] = false;
+    connection->in_flight --;
+
+    if (now >= loadgen->measure_start) {
+        sl_trace_histogram_record(&loadgen->latency, now - connection->sent_at[slot]);
+        loadgen->requests ++;
+
+        if (loadgen->config->max_requests > 0 && loadgen->requests >= loadgen->config->max_requests) {
+            loadgen->running = false;
+        }
+    }
+
+    if (loadgen->running == false) {
+        return 0;
+    }
+
+    if (loadgen->scenario->keep_alive == false) {
+        return sl_loadgen_reopen(loadgen, connection, now);
+    }
+
+    sl_loadgen_enqueue(connection, slot, now);
+
+    return sl_loadgen_write(loadgen, connection);
+}
+
+static int sl_loadgen_parse(sl_loadgen *loadgen, sl_loadgen_connection *connection, uint8_t *buffer, size_t length)
+{
+    sl_fcgi_msg_header *header = (sl_fcgi_msg_header *) connection->header;
+    size_t reconnects = loadgen->reconnects;
+
+    while (length > 0) {
+        if (connection->header_read < sizeof(sl_fcgi_msg_header)) {
+            size_t chunk = sizeof(sl_fcgi_msg_header) - connection->header_read;
+
+            if (chunk > length) {
+                chunk = length;
+            }
+
+            memcpy(connection->header + connection->header_read, buffer, chunk);
+            connection->header_read += chunk;
+            buffer += chunk;
+            length -= chunk;
+
+            if (connection->header_read < sizeof(sl_fcgi_msg_header)) {
+                break;
+            }
+
+            if (header->version != SL_FCGI_VERSION) {
+                return -1;
+            }
+
+            connection->content_remaining = ntohs(header->content_length);
+            connection->padding_remaining = header->padding_length;
+        }
+
+        size_t chunk = connection->content_remaining + connection->padding_remaining;
+
+        if (chunk > length) {
+            chunk = length;
+        }
+
+        size_t content = chunk < connection->content_remaining ? chunk : connection->content_remaining;
+
+        if (header->type == SL_FCGI_TYPE_STDOUT) {
+            loadgen->bytes += content;
+        }
+
+        connection->content_remaining -= content;
+        connection->padding_remaining -= chunk - content;
+        buffer += chunk;
+        length -= chunk;
+
+        if (connection->content_remaining > 0 || connection->padding_remaining > 0) {
+            break;
+        }
+
+        connection->header_read = 0;
+
+        if (header->type == SL_FCGI_TYPE_END_REQUEST) {
+            if (sl_loadgen_complete(loadgen, connection, ntohs(header->request_id)) == -1) {
+                return -1;
+            }
+
+            if (loadgen->reconnects != reconnects || connection->in_flight == 0) {
+                break;
+            }
+        }
+    }
+
+    return 0;
+}
+
+static int sl_loadgen_read(sl_loadgen *loadgen, sl_loadgen_connection *connection)
+{
+    uint8_t buffer[SL_LOADGEN_RECV_BUFFER_SIZE];
+
+    for (;;) {
+        size_t reconnects = loadgen->reconnects;
+
+        ssize_t bytes_read = recv(connection->fd, buffer, sizeof(buffer), 0);
+        if (bytes_read == -1 && errno == EINTR) {
+            continue;
+        } else if (bytes_read == -1 && errno == EAGAIN) {
+            return 0;
+        } else if (bytes_read <= 0) {
+            return -1;
+        }
+
+        if (sl_loadgen_parse(loadgen, connection, buffer, bytes_read) == -1) {
+            return -1;
+        }
+
+        if (loadgen->reconnects != reconnects || (size_t) bytes_read < sizeof(buffer)) {
+            return 0;
+        }
+    }
+}
+
+static int sl_loadgen_check_timeouts(sl_loadgen *loadgen, uint64_t now)
+{
+    for (size_t n = 0; n < loadgen->scenario->connections; n ++) {
+        sl_loadgen_connection *connection = &loadgen->connections[n];
+
+        for (size_t slot = 0; slot < loadgen->scenario->depth; slot ++) {
+            if (connection->pending[slot] == true && now - connection->sent_at[slot] > loadgen->config->timeout_ns) {
+                loadgen->timeouts ++;
+
+                if (sl_loadgen_fail(loadgen, connection, now) == -1) {
+                    return -1;
+                }
+                break;
+            }
+        }
+    }
+
+    return 0;
+}
+
+static int sl_loadgen_loop(sl_loadgen *loadgen)
+{
+    struct epoll_event events[SL_LOADGEN_MAX_EVENTS];
+    uint64_t next_check = 0;
+
+    while (loadgen->running == true && sl_loadgen_interrupted == false) {
+        int num_events = epoll_wait(loadgen->epoll_instance, events, SL_LOADGEN_MAX_EVENTS, SL_LOADGEN_POLL_INTERVAL_MS);
+        if (num_events == -1 && errno != EINTR) {
+            perror("epoll_wait()");
+            return -1;
+        }
+
+        for (int n = 0; n < num_events && loadgen->running == true; n ++) {
+            sl_loadgen_connection *connection = events[n].data.ptr;
+            int result = 0;
+
+            if (connection->fd == -1) {
+                continue;
+            }
+
+            if ((events[n].events & EPOLLOUT) != 0) {
+                result = sl_loadgen_write(loadgen, connection);
+            }
+
+            if (result == 0 && (events[n].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) != 0) {
+                result = sl_loadgen_read(loadgen, connection);
+            }
+
+            if (result == -1 && sl_loadgen_fail(loadgen, connection, sl_loadgen_now()) == -1) {
+                return -1;
+            }
+        }
+
+        uint64_t now = sl_loadgen_now();
+
+        if (now >= loadgen->measure_end) {
+            break;
+        }
+
+        if (now >= next_check) {
+            if (sl_loadgen_check_timeouts(loadgen, now) == -1) {
+                return -1;
+            }
+
+            next_check = now + SL_LOADGEN_POLL_INTERVAL_MS * 1000000;
+        }
+    }
+
+    if (loadgen->measure_end > sl_loadgen_now()) {
+        loadgen->measure_end = sl_loadgen_now();
+    }
+
+    return 0;
+}
+
+static void sl_loadgen_report(sl_loadgen *loadgen)
+{
+    sl_trace_histogram *latency = &loadgen->latency;
+    double elapsed = loadgen->measure_end > loadgen->measure_start ? (double) (loadgen->measure_end - loadgen->measure_start) / 1e9 : 0.0;
+    double throughput = elapsed > 0.0 ? loadgen->requests / elapsed : 0.0;
+    double megabytes = elapsed > 0.0 ? loadgen->bytes / elapsed / 1e6 : 0.0;
+
+    printf("%-28s %12.0f req/s %8.2f MB/s  p50 %9.1f us  p99 %9.1f us  p99.9 %9.1f us  max %9.1f us  %zu requests, %zu errors, %zu timeouts, %zu reconnects\n",
+        loadgen->scenario->name, throughput, megabytes,
+        sl_trace_histogram_percentile(latency, 50.0) / 1e3, sl_trace_histogram_percentile(latency, 99.0) / 1e3,
+        sl_trace_histogram_percentile(latency, 99.9) / 1e3, latency->max / 1e3,
+        loadgen->requests, loadgen->errors, loadgen->timeouts, loadgen->reconnects);
+
+    fflush(stdout);
+}
+
+static int sl_loadgen_run(sl_loadgen_config *config, sl_loadgen_scenario *scenario)
+{
+    static sl_loadgen loadgen;
+    sl_arena arena;
+    int result = -1;
+
+    loadgen = (sl_loadgen) {
+        .config = config,
+        .scenario = scenario,
+        .running = true
+    };
+
+    sl_arena_init(&arena, SL_LOADGEN_ARENA_PREALLOCATE);
+
+    loadgen.connections = calloc(scenario->connections, sizeof(sl_loadgen_connection));
+    loadgen.epoll_instance = epoll_create1(0);
+
+    if (loadgen.connections == NULL || loadgen.epoll_instance == -1) {
+        perror("sl_loadgen_run()");
+        goto cleanup;
+    }
+
+    for (size_t n = 0; n < scenario->connections; n ++) {
+        loadgen.connections[n].fd = -1;
+    }
+
+    if (sl_loadgen_build_templates(&loadgen, &arena) == -1) {
+        fprintf(stderr, "Unable to build request templates\n");
+        goto cleanup;
+    }
+
+    uint64_t start = sl_loadgen_now();
+
+    loadgen.measure_start = start + config->warmup_ns;
+    loadgen.measure_end = loadgen.measure_start + config->duration_ns;
+
+    for (size_t n = 0; n < scenario->connections; n ++) {
+        if (sl_loadgen_open(&loadgen, &loadgen.connections[n], sl_loadgen_now()) == -1) {
+            goto cleanup;
+        }
+    }
+
+    if (sl_loadgen_loop(&loadgen) == -1) {
+        goto cleanup;
+    }
+
+    sl_loadgen_report(&loadgen);
+    result = 0;
+
+cleanup:
+    for (size_t n = 0; loadgen.connections != NULL && n < scenario->connections; n ++) {
+        sl_loadgen_close(&loadgen.connections[n]);
+    }
+
+    if (loadgen.epoll_instance != -1) {
+        close(loadgen.epoll_instance);
+    }
+
+    free(loadgen.connections);
+    sl_arena_destroy(&arena);
+
+    return result;
+}
+
+static int sl_loadgen_parse_number(char *value, size_t *number)
+{
+    char *end = NULL;
+
+    errno = 0;
+    unsigned long long parsed = strtoull(value, &end, 10);
+    if (errno != 0 || end == value || *end != '\0') {
+        return -1;
+    }
+
+    *number = parsed;
+
+    return 0;
+}
+
+static int sl_loadgen_set_address(sl_loadgen_config *config, char *host, size_t port, char *path)
+{
+    memset(&config->address, 0, sizeof(config->address));
+
+    if (path != NULL) {
+        struct sockaddr_un *address = (struct sockaddr_un *) &config->address;
+
+        if (strlen(path) >= sizeof(address->sun_path)) {
+            return -1;
+        }
+
+        address->sun_family = AF_UNIX;
+        strcpy(address->sun_path, path);
+        config->address_length = sizeof(struct sockaddr_un);
+
+        return 0;
+    }
+
+    struct sockaddr_in *address = (struct sockaddr_in *) &config->address;
+
+    if (port == 0 || port > UINT16_MAX || inet_pton(AF_INET, host, &address->sin_addr) != 1) {
+        return -1;
+    }
+
+    address->sin_family = AF_INET;
+    address->sin_port = htons(port);
+    config->address_length = sizeof(struct sockaddr_in);
+
+    return 0;
+}
+
+static void sl_loadgen_usage(char *name)
+{
+    fprintf(stderr, "Usage: %s [-a address] [-p port] [-u unix socket path] [-c connections] [-P pipelining depth] [-K close after each response] "
+        "[-U document uri] [-q query string] [-H NAME=value, repeatable] [-x extra parameters] [-b body bytes] [-e accept encoding] "
+        "[-d duration seconds] [-w warmup seconds] [-n requests] [-T timeout ms] [-S run the benchmark suite]\n", name);
+}
+
+int main(int argc, char *argv[])
+{
+    sl_loadgen_config config = {
+        .duration_ns = (uint64_t) SL_LOADGEN_DEFAULT_DURATION * 1000000000,
+        .warmup_ns = (uint64_t) SL_LOADGEN_DEFAULT_WARMUP * 1000000000,
+        .timeout_ns = (uint64_t) SL_LOADGEN_DEFAULT_TIMEOUT_MS * 1000000,
+        .query_string = ""
+    };
+
+    sl_loadgen_scenario scenario = {
+        .name = "loadgen",
+        .document_uri = "/",
+        .accept_encoding = "",
+        .connections = SL_LOADGEN_DEFAULT_CONNECTIONS,
+        .depth = 1,
+        .keep_alive = true
+    };
+
+    char *host = "127.0.0.1", *path = NULL;
+    size_t port = SL_LOADGEN_DEFAULT_PORT, value;
+    bool suite = false;
+    int option;
+
+    while ((option = getopt(argc, argv, "a:p:u:c:P:KU:q:H:x:b:e:d:w:n:T:S")) != -1) {
+        switch (option) {
+            case 'a':
+                host = optarg;
+                break;
+            case 'p':
+                if (sl_loadgen_parse_number(optarg, &port) == -1) {
+                    sl_loadgen_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'u':
+                path = optarg;
+                break;
+            case 'c':
+                if (sl_loadgen_parse_number(optarg, &scenario.connections) == -1 || scenario.connections == 0) {
+                    sl_loadgen_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'P':
+                if (sl_loadgen_parse_number(optarg, &scenario.depth) == -1 || scenario.depth == 0 || scenario.depth > SL_LOADGEN_MAX_DEPTH) {
+                    sl_loadgen_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'K':
+                scenario.keep_alive = false;
+                break;
+            case 'U':
+                scenario.document_uri = optarg;
+                break;
+            case 'q':
+                config.query_string = optarg;
+                break;
+            case 'H':
+                if (strchr(optarg, '=') == NULL || config.param_count >= SL_LOADGEN_MAX_PARAMS) {
+                    sl_loadgen_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                config.params[config.param_count ++] = optarg;
+                break;
+            case 'x':
+                if (sl_loadgen_parse_number(optarg, &scenario.extra_params) == -1) {
+                    sl_loadgen_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'b':
+                if (sl_loadgen_parse_number(optarg, &scenario.body_size) == -1) {
+                    sl_loadgen_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'e':
+                scenario.accept_encoding = optarg;
+                break;
+            case 'd':
+            case 'w':
+                if (sl_loadgen_parse_number(optarg, &value) == -1) {
+                    sl_loadgen_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                *(option == 'd' ? &config.duration_ns : &config.warmup_ns) = (uint64_t) value * 1000000000;
+                break;
+            case 'n':
+                if (sl_loadgen_parse_number(optarg, &config.max_requests) == -1) {
+                    sl_loadgen_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'T':
+                if (sl_loadgen_parse_number(optarg, &value) == -1 || value == 0) {
+                    sl_loadgen_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                config.timeout_ns = (uint64_t) value * 1000000;
+                break;
+            case 'S':
+                suite = true;
+                break;
+            default:
+                sl_loadgen_usage(argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    if (scenario.keep_alive == false && scenario.depth > 1) {
+        fprintf(stderr, "Pipelining requires keep-alive connections\n");
+        return EXIT_FAILURE;
+    }
+
+    if (sl_loadgen_set_address(&config, host, port, path) == -1) {
+        fprintf(stderr, "Invalid address\n");
+        return EXIT_FAILURE;
+    }
+
+    if (signal(SIGINT, &sl_loadgen_signal_handler) == SIG_ERR || signal(SIGPIPE, SIG_IGN) == SIG_ERR) {
+        perror("signal()");
+        return EXIT_FAILURE;
+    }
+
+    if (suite == false) {
+        return sl_loadgen_run(&config, &scenario) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    for (size_t n = 0; n < sizeof(sl_loadgen_suite) / sizeof(sl_loadgen_scenario) && sl_loadgen_interrupted == false; n ++) {
+        if (sl_loadgen_run(&config, &sl_loadgen_suite[n]) == -1) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
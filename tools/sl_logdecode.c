@@ -0,0 +1,500 @@
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+
+#include <arpa/inet.h>
+
+#include "../sl_arena.h"
+#include "../sl_string.h"
+#include "../sl_format.h"
+#include "../sl_hashtable.h"
+#include "../sl_log.h"
+
+#define SL_LOGDECODE_BUFFER_SIZE      (64 * 1024)
+#define SL_LOGDECODE_ARENA_PREALLOCATE 102400
+#define SL_LOGDECODE_MAX_SPEC_LENGTH   64
+
+typedef struct sl_logdecode_value sl_logdecode_value;
+typedef struct sl_logdecode_reader sl_logdecode_reader;
+
+struct sl_logdecode_value {
+    uint8_t type;
+    uint64_t number;
+    sl_string string;
+};
+
+struct sl_logdecode_reader {
+    char *buffer;
+    size_t length;
+    size_t position;
+    size_t count;
+    sl_logdecode_value values[SL_LOG_MAX_ARGUMENTS];
+};
+
+static char *sl_logdecode_levels[SL_LOG_MAX] = {
+    "debug", "info", "error"
+};
+
+static bool sl_logdecode_json = false;
+
+static int sl_logdecode_read_values(sl_logdecode_reader *reader, uint8_t *types, size_t count)
+{
+    for (size_t n = 0; n < count; n ++) {
+        sl_logdecode_value *value = &reader->values[n];
+
+        value->type = types[n];
+
+        if (value->type != SL_FORMAT_ARGUMENT_CSTRING && value->type != SL_FORMAT_ARGUMENT_STRING) {
+            if (reader->position + sizeof(uint64_t) > reader->length) {
+                return -1;
+            }
+
+            memcpy(&value->number, reader->buffer + reader->position, sizeof(uint64_t));
+            reader->position += sizeof(uint64_t);
+            continue;
+        }
+
+        uint32_t length;
+
+        if (reader->position + sizeof(length) > reader->length) {
+            return -1;
+        }
+
+        memcpy(&length, reader->buffer + reader->position, sizeof(length));
+        reader->position += sizeof(length);
+
+        if (length > reader->length - reader->position) {
+            return -1;
+        }
+
+        value->string = sl_string_init_with_buffer(reader->buffer + reader->position, length);
+        reader->position += length;
+    }
+
+    reader->count = count;
+
+    return 0;
+}
+
+static int sl_logdecode_render_value(sl_string_builder *builder, char *spec, sl_logdecode_value *value)
+{
+    double number;
+
+    switch (value->type) {
+        case SL_FORMAT_ARGUMENT_INT:
+            return sl_format_builder(builder, spec, (int) value->number);
+        case SL_FORMAT_ARGUMENT_LONG:
+            return sl_format_builder(builder, spec, (long) value->number);
+        case SL_FORMAT_ARGUMENT_UNSIGNED:
+            return sl_format_builder(builder, spec, (unsigned int) value->number);
+        case SL_FORMAT_ARGUMENT_UNSIGNED_LONG:
+            return sl_format_builder(builder, spec, (unsigned long) value->number);
+        case SL_FORMAT_ARGUMENT_SIZE:
+            return sl_format_builder(builder, spec, (size_t) value->number);
+        case SL_FORMAT_ARGUMENT_POINTER:
+            return sl_format_builder(builder, spec, (void *) (uintptr_t) value->number);
+        case SL_FORMAT_ARGUMENT_DOUBLE:
+            memcpy(&number, &value->number, sizeof(number));
+            return sl_format_builder(builder, spec, number);
+        case SL_FORMAT_ARGUMENT_CSTRING:
+        case SL_FORMAT_ARGUMENT_STRING:
+            spec[strlen(spec) - 1] = 'S';
+            return sl_format_builder(builder, spec, &value->string);
+        default:
+            return -1;
+    }
+}
+
+static int sl_logdecode_render(sl_string_builder *builder, sl_string *format, sl_logdecode_reader *reader)
+{
+    char *cursor = format->buffer, *end = format->buffer + format->length;
+    size_t next = 0;
+
+    while (cursor < end) {
+        char *literal = memchr(cursor, '%', end - cursor);
+        if (literal == NULL) {
+            return sl_string_builder_append(builder, cursor, end - cursor);
+        }
+
+        if (sl_string_builder_append(builder, cursor, literal - cursor) == -1) {
+            return -1;
+        }
+
+        char spec[SL_LOGDECODE_MAX_SPEC_LENGTH];
+        size_t spec_length = 0;
+
+        spec[spec_length ++] = '%';
+        cursor = literal + 1;
+
+        while (cursor < end && spec_length < SL_LOGDECODE_MAX_SPEC_LENGTH - SL_FORMAT_MAX_NUMBER_LENGTH - 4) {
+            char c = *cursor ++;
+
+            if (c == '*') {
+                if (next >= reader->count) {
+                    return -1;
+                }
+
+                spec_length += sl_format_signed((int) reader->values[next ++].number, spec + spec_length);
+                continue;
+            }
+
+            spec[spec_length ++] = c;
+
+            if (c == '-' || c == '0' || c == '.' || c == 'l' || (c >= '0' && c <= '9')) {
+                continue;
+            }
+
+            if (c == 'z' && cursor < end && (*cursor == 'd' || *cursor == 'u' || *cursor == 'x' || *cursor == 'X')) {
+                continue;
+            }
+
+            break;
+        }
+
+        spec[spec_length] = '\0';
+
+        if (spec[spec_length - 1] == '%' && spec_length == 2) {
+            if (sl_string_builder_append(builder, "%", 1) == -1) {
+                return -1;
+            }
+
+            continue;
+        }
+
+        if (next >= reader->count) {
+            return -1;
+        }
+
+        if (sl_logdecode_render_value(builder, spec, &reader->values[next ++]) == -1) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static int sl_logdecode_append_json_string(sl_string_builder *builder, char *buffer, size_t length)
+{
+    if (sl_string_builder_append(builder, "\"", 1) == -1) {
+        return -1;
+    }
+
+    for (size_t n = 0; n < length; n ++) {
+        unsigned char c = buffer[n];
+        int result;
+
+        if (c == '"' || c == '\\') {
+            char escaped[2] = {'\\', c};
+            result = sl_string_builder_append(builder, escaped, 2);
+        } else if (c < 0x20) {
+            result = sl_format_builder(builder, "\\u%04x", (unsigned int) c);
+        } else {
+            result = sl_string_builder_append(builder, (char *) &buffer[n], 1);
+        }
+
+        if (result == -1) {
+            return -1;
+        }
+    }
+
+    return sl_string_builder_append(builder, "\"", 1);
+}
+
+static int sl_logdecode_append_json_value(sl_string_builder *builder, sl_logdecode_value *value)
+{
+    double number;
+
+    switch (value->type) {
+        case SL_FORMAT_ARGUMENT_INT:
+        case SL_FORMAT_ARGUMENT_LONG:
+            return sl_format_builder(builder, "%ld", (long) value->number);
+        case SL_FORMAT_ARGUMENT_DOUBLE:
+            memcpy(&number, &value->number, sizeof(number));
+            return sl_format_builder(builder, "%f", number);
+        case SL_FORMAT_ARGUMENT_CSTRING:
+        case SL_FORMAT_ARGUMENT_STRING:
+            return sl_logdecode_append_json_string(builder, value->string.buffer, value->string.length);
+        default:
+            return sl_format_builder(builder, "%lu", (unsigned long) value->number);
+    }
+}
+
+static int sl_logdecode_write_text(sl_string_builder *builder, sl_log_record *record, sl_string *message)
+{
+    time_t seconds = record->timestamp / 1000000000;
+    struct tm local_time;
+    char date[SL_LOG_MAX_DATE_LENGTH];
+
+    localtime_r(&seconds, &local_time);
+    strftime(date, sizeof(date), "%D %T", &local_time);
+
+    if (sl_format_builder(builder, "%s [%s] #%u ", date, sl_logdecode_levels[record->level], record->pid) == -1) {
+        return -1;
+    }
+
+    if (record->address != 0 || record->port != 0) {
+        struct in_addr address = {record->address};
+
+        if (sl_format_builder(builder, "%s:%u ", inet_ntoa(address), (unsigned int) ntohs(record->port)) == -1) {
+            return -1;
+        }
+    }
+
+    if (sl_string_builder_append(builder, message->buffer, message->length) == -1) {
+        return -1;
+    }
+
+    if (record->suppressed > 0 && sl_format_builder(builder, " (%u similar messages suppressed)", record->suppressed) == -1) {
+        return -1;
+    }
+
+    if (record->error > 0 && sl_format_builder(builder, ": %s", strerror(record->error)) == -1) {
+        return -1;
+    }
+
+    return sl_string_builder_append(builder, "\n", 1);
+}
+
+static int sl_logdecode_write_json(sl_string_builder *builder, sl_log_record *record, sl_string *message, sl_logdecode_reader *reader)
+{
+    if (sl_format_builder(builder, "{\"timestamp\":%lu,\"level\":\"%s\",\"pid\":%u,\"id\":\"%08x\"", (unsigned long) record->timestamp, sl_logdecode_levels[record->level], record->pid, record->id) == -1) {
+        return -1;
+    }
+
+    if (record->address != 0 || record->port != 0) {
+        struct in_addr address = {record->address};
+
+        if (sl_format_builder(builder, ",\"peer\":\"%s:%u\"", inet_ntoa(address), (unsigned int) ntohs(record->port)) == -1) {
+            return -1;
+        }
+    }
+
+    if (sl_string_builder_append(builder, ",\"message\":", 11) == -1 ||
+        sl_logdecode_append_json_string(builder, message->buffer, message->length) == -1 ||
+        sl_string_builder_append(builder, ",\"arguments\":[", 14) == -1) {
+        return -1;
+    }
+
+    for (size_t n = 0; n < reader->count; n ++) {
+        if ((n > 0 && sl_string_builder_append(builder, ",", 1) == -1) || sl_logdecode_append_json_value(builder, &reader->values[n]) == -1) {
+            return -1;
+        }
+    }
+
+    if (sl_string_builder_append(builder, "]", 1) == -1) {
+        return -1;
+    }
+
+    if (record->suppressed > 0 && sl_format_builder(builder, ",\"suppressed\":%u", record->suppressed) == -1) {
+        return -1;
+    }
+
+    if (record->error > 0) {
+        char *error = strerror(record->error);
+
+        if (sl_string_builder_append(builder, ",\"error\":", 9) == -1 || sl_logdecode_append_json_string(builder, error, strlen(error)) == -1) {
+            return -1;
+        }
+    }
+
+    return sl_string_builder_append(builder, "}\n", 2);
+}
+
+static int sl_logdecode_define(sl_hashtable *formats, sl_arena *arena, sl_log_record *record, char *payload, size_t length)
+{
+    if (record->count > SL_LOG_MAX_ARGUMENTS || record->count > length) {
+        return -1;
+    }
+
+    uint8_t count = record->count;
+
+    sl_string *key = sl_string_create_with_buffer(arena, (char *) &record->id, sizeof(record->id));
+    sl_string *definition = sl_string_create_from_buffer(arena, (char *) &count, 1, length + 1);
+
+    if (key == NULL || definition == NULL || sl_string_append_with_buffer(arena, definition, payload, length) == -1) {
+        return -1;
+    }
+
+    return sl_hashtable_set(formats, key, definition);
+}
+
+static int sl_logdecode_event(sl_hashtable *formats, sl_arena *arena, sl_log_record *record, char *payload, size_t length)
+{
+    sl_string key = sl_string_init_with_buffer((char *) &record->id, sizeof(record->id));
+    sl_string_builder message, output;
+
+    sl_string *definition = sl_hashtable_get(formats, &key);
+    if (definition == NULL || record->level >= SL_LOG_MAX) {
+        fprintf(stderr, "Unknown format %08x\n", record->id);
+        return 0;
+    }
+
+    size_t count = (uint8_t) definition->buffer[0];
+    if (record->count != count) {
+        return -1;
+    }
+
+    sl_logdecode_reader reader = {.buffer = payload, .length = length};
+    sl_string format = sl_string_init_with_buffer(definition->buffer + 1 + count, definition->length - 1 - count);
+
+    sl_string_builder_init(&message, arena);
+    sl_string_builder_init(&output, arena);
+
+    if (sl_logdecode_read_values(&reader, (uint8_t *) definition->buffer + 1, count) == -1 ||
+        sl_logdecode_render(&message, &format, &reader) == -1) {
+        return -1;
+    }
+
+    int result = sl_logdecode_json == true ?
+        sl_logdecode_write_json(&output, record, &message.string, &reader) :
+        sl_logdecode_write_text(&output, record, &message.string);
+
+    if (result == -1) {
+        return -1;
+    }
+
+    fwrite(output.string.buffer, 1, output.string.length, stdout);
+
+    return 0;
+}
+
+static bool sl_logdecode_valid(sl_log_record *record)
+{
+    return memcmp(record->magic, SL_LOG_RECORD_MAGIC, SL_LOG_RECORD_MAGIC_SIZE) == 0 &&
+        record->length >= sizeof(sl_log_record) && record->length <= SL_LOG_MAX_MESSAGE_LENGTH &&
+        record->type <= SL_LOG_RECORD_EVENT && record->level < SL_LOG_MAX;
+}
+
+static size_t sl_logdecode_resync(char *buffer, size_t length)
+{
+    char *next = memmem(buffer + 1, length - 1, SL_LOG_RECORD_MAGIC, SL_LOG_RECORD_MAGIC_SIZE);
+
+    return next != NULL ? (size_t) (next - buffer) : length - (SL_LOG_RECORD_MAGIC_SIZE - 1);
+}
+
+static int sl_logdecode_decode(int fd, sl_hashtable *formats, sl_arena *definitions, sl_arena *scratch)
+{
+    char *buffer = malloc(SL_LOGDECODE_BUFFER_SIZE);
+    size_t length = 0, offset = 0, skipped = 0, skipped_offset = 0;
+    bool corrupt = false;
+
+    if (buffer == NULL) {
+        return -1;
+    }
+
+    for (;;) {
+        ssize_t bytes_read = read(fd, buffer + length, SL_LOGDECODE_BUFFER_SIZE - length);
+        if (bytes_read == -1) {
+            free(buffer);
+            return -1;
+        } else if (bytes_read == 0) {
+            break;
+        }
+
+        length += bytes_read;
+
+        size_t position = 0;
+
+        while (length - position >= sizeof(sl_log_record)) {
+            sl_log_record record;
+
+            memcpy(&record, buffer + position, sizeof(record));
+
+            if (sl_logdecode_valid(&record) == true && record.length > length - position) {
+                break;
+            }
+
+            int result = -1;
+
+            if (sl_logdecode_valid(&record) == true) {
+                char *payload = buffer + position + sizeof(record);
+                size_t payload_length = record.length - sizeof(record);
+
+                sl_arena_rewind(scratch);
+
+                if (record.type == SL_LOG_RECORD_DEFINE) {
+                    result = sl_logdecode_define(formats, definitions, &record, payload, payload_length);
+                } else {
+                    result = sl_logdecode_event(formats, scratch, &record, payload, payload_length);
+                }
+            }
+
+            if (result == -1) {
+                size_t skip = sl_logdecode_resync(buffer + position, length - position);
+
+                if (skipped == 0) {
+                    skipped_offset = offset + position;
+                }
+
+                skipped += skip;
+                position += skip;
+                continue;
+            }
+
+            if (skipped > 0) {
+                fprintf(stderr, "Skipped %zu corrupt bytes at offset %zu\n", skipped, skipped_offset);
+                skipped = 0;
+                corrupt = true;
+            }
+
+            position += record.length;
+        }
+
+        memmove(buffer, buffer + position, length - position);
+        length -= position;
+        offset += position;
+    }
+
+    free(buffer);
+
+    if (skipped > 0 || length > 0) {
+        fprintf(stderr, "Skipped %zu corrupt bytes at offset %zu\n", skipped + length, skipped > 0 ? skipped_offset : offset);
+        corrupt = true;
+    }
+
+    return corrupt == false ? 0 : -1;
+}
+
+int main(int argc, char *argv[])
+{
+    sl_arena definitions, scratch;
+    sl_hashtable formats;
+    int option, fd = STDIN_FILENO;
+
+    while ((option = getopt(argc, argv, "j")) != -1) {
+        switch (option) {
+            case 'j':
+                sl_logdecode_json = true;
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-j] [file]\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    if (optind < argc && (fd = open(argv[optind], O_RDONLY)) == -1) {
+        perror("open()");
+        return EXIT_FAILURE;
+    }
+
+    sl_arena_init(&definitions, SL_LOGDECODE_ARENA_PREALLOCATE);
+    sl_arena_init(&scratch, SL_LOGDECODE_ARENA_PREALLOCATE);
+    sl_hashtable_init(&formats, &definitions, 64, true);
+
+    int result = sl_logdecode_decode(fd, &formats, &definitions, &scratch);
+
+    fflush(stdout);
+
+    sl_hashtable_destroy(&formats);
+    sl_arena_destroy(&scratch);
+    sl_arena_destroy(&definitions);
+
+    return result == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
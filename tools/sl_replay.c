@@ -0,0 +1,993 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/un.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include "../sl_arena.h"
+#include "../sl_slab.h"
+#include "../sl_log.h"
+#include "../sl_fcgi.h"
+#include "../sl_net.h"
+#include "../sl_trace.h"
+#include "../sl_hashtable.h"
+#include "../sl_capture.h"
+
+#define SL_REPLAY_ARENA_PREALLOCATE 102400
+#define SL_REPLAY_PARAMS_PREALLOCATE 64
+#define SL_REPLAY_PARAM_SLAB_OBJECTS 256
+#define SL_REPLAY_RECV_BUFFER_SIZE  (64 * 1024)
+#define SL_REPLAY_MAX_EVENTS        256
+#define SL_REPLAY_POLL_INTERVAL_MS  10
+
+#define SL_REPLAY_DEFAULT_PORT        9000
+#define SL_REPLAY_DEFAULT_CONNECTIONS 64
+#define SL_REPLAY_DEFAULT_TIMEOUT_MS  2000
+#define SL_REPLAY_DEFAULT_PASSES      10
+
+typedef struct sl_replay_event sl_replay_event;
+typedef struct sl_replay_stream sl_replay_stream;
+typedef struct sl_replay sl_replay;
+
+struct sl_replay_event {
+    uint64_t timestamp;
+    size_t sequence;
+    sl_replay_stream *stream;
+    uint8_t type;
+    size_t end;
+};
+
+struct sl_replay_stream {
+    uint8_t *data;
+    size_t length;
+    size_t *chunks;
+    size_t chunk_count;
+    size_t *requests;
+    size_t request_count;
+    int fd;
+    bool writing;
+    bool closing;
+    bool done;
+    bool in_flight;
+    size_t released;
+    size_t sent;
+    size_t next_request;
+    uint64_t sent_at;
+    uint8_t header[sizeof(sl_fcgi_msg_header)];
+    size_t header_read;
+    size_t content_remaining;
+    size_t padding_remaining;
+};
+
+struct sl_replay {
+    struct sockaddr_storage address;
+    socklen_t address_length;
+    double speed;
+    size_t max_connections;
+    uint64_t timeout_ns;
+    sl_replay_stream **streams;
+    size_t stream_count;
+    sl_replay_event *events;
+    size_t event_count;
+    size_t bytes;
+    uint64_t duration;
+    int epoll_instance;
+    size_t active;
+    size_t peak_active;
+    sl_trace_histogram latency;
+    size_t responses;
+    size_t errors;
+    size_t timeouts;
+    size_t bytes_received;
+    uint64_t max_lag;
+    uint64_t elapsed;
+};
+
+static volatile bool sl_replay_interrupted = false;
+
+static uint64_t sl_replay_now(void)
+{
+    struct timespec timestamp;
+
+    clock_gettime(CLOCK_MONOTONIC, &timestamp);
+
+    return (uint64_t) timestamp.tv_sec * 1000000000 + timestamp.tv_nsec;
+}
+
+static void sl_replay_signal_handler(int signal_number)
+{
+    (void) signal_number;
+
+    sl_replay_interrupted = true;
+}
+
+static bool sl_replay_next_record(uint8_t *map, size_t size, size_t *offset, sl_capture_record *record, uint8_t **payload)
+{
+    if (*offset + sizeof(sl_capture_record) > size) {
+        return false;
+    }
+
+    memcpy(record, map + *offset, sizeof(sl_capture_record));
+
+    if (record->length > size - *offset - sizeof(sl_capture_record) || (record->connection == 0 && record->type != SL_CAPTURE_RECORD_TRUNCATED)) {
+        return false;
+    }
+
+    *payload = map + *offset + sizeof(sl_capture_record);
+    *offset += sizeof(sl_capture_record) + record->length;
+
+    return true;
+}
+
+static size_t sl_replay_index_requests(sl_replay_stream *stream, size_t *requests)
+{
+    size_t offset = 0, count = 0;
+
+    while (offset + sizeof(sl_fcgi_msg_header) <= stream->length) {
+        sl_fcgi_msg_header header;
+
+        memcpy(&header, stream->data + offset, sizeof(header));
+
+        if (header.version != SL_FCGI_VERSION) {
+            break;
+        }
+
+        if (header.type == SL_FCGI_TYPE_BEGIN_REQUEST) {
+            if (requests != NULL) {
+                requests[count] = offset;
+            }
+            count ++;
+        }
+
+        offset += sizeof(header) + ntohs(header.content_length) + header.padding_length;
+    }
+
+    return count;
+}
+
+static int sl_replay_load(sl_replay *replay, char *path)
+{
+    struct stat status;
+    sl_capture_header header;
+    sl_capture_record record;
+    uint8_t *payload;
+    size_t offset, records = 0, events_count = 0;
+    uint32_t connections = 0;
+    sl_replay_stream *file_streams = NULL;
+    int result = -1;
+
+    int fd = open(path, O_RDONLY);
+    if (fd == -1 || fstat(fd, &status) == -1) {
+        perror(path);
+        return -1;
+    }
+
+    if ((size_t) status.st_size < sizeof(header)) {
+        fprintf(stderr, "%s: not a traffic capture\n", path);
+        close(fd);
+        return -1;
+    }
+
+    size_t size = status.st_size;
+
+    uint8_t *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (map == MAP_FAILED) {
+        perror("mmap()");
+        return -1;
+    }
+
+    memcpy(&header, map, sizeof(header));
+
+    if (memcmp(header.magic, SL_CAPTURE_MAGIC, SL_CAPTURE_MAGIC_SIZE) != 0 || header.version != SL_CAPTURE_VERSION) {
+        fprintf(stderr, "%s: not a traffic capture\n", path);
+        goto cleanup;
+    }
+
+    for (offset = sizeof(header); sl_replay_next_record(map, size, &offset, &record, &payload) == true; records ++) {
+        if (record.type == SL_CAPTURE_RECORD_TRUNCATED) {
+            fprintf(stderr, "%s: capture size limit reached after %.3f s, later connections were not recorded\n", path, record.timestamp / 1e9);
+            continue;
+        }
+
+        if (record.connection > connections) {
+            connections = record.connection;
+        }
+
+        events_count ++;
+    }
+
+    if (offset != size) {
+        fprintf(stderr, "%s: truncated after %zu records\n", path, records);
+    }
+
+    sl_replay_stream **streams = realloc(replay->streams, (replay->stream_count + connections) * sizeof(sl_replay_stream *));
+    if (streams != NULL) {
+        replay->streams = streams;
+    }
+
+    sl_replay_event *events = realloc(replay->events, (replay->event_count + events_count) * sizeof(sl_replay_event));
+    if (events != NULL) {
+        replay->events = events;
+    }
+
+    file_streams = calloc(connections, sizeof(sl_replay_stream));
+
+    if (streams == NULL || events == NULL || (connections > 0 && file_streams == NULL)) {
+        perror("sl_replay_load()");
+        goto cleanup;
+    }
+
+    for (offset = sizeof(header); sl_replay_next_record(map, size, &offset, &record, &payload) == true;) {
+        if (record.type == SL_CAPTURE_RECORD_DATA) {
+            file_streams[record.connection - 1].length += record.length;
+            file_streams[record.connection - 1].chunk_count ++;
+        }
+    }
+
+    for (uint32_t n = 0; n < connections; n ++) {
+        sl_replay_stream *stream = &file_streams[n];
+
+        stream->fd = -1;
+        stream->data = malloc(stream->length + 1);
+        stream->chunks = malloc((stream->chunk_count + 1) * sizeof(size_t));
+
+        if (stream->data == NULL || stream->chunks == NULL) {
+            perror("sl_replay_load()");
+            goto cleanup;
+        }
+
+        stream->length = 0;
+        stream->chunk_count = 0;
+    }
+
+    for (offset = sizeof(header); sl_replay_next_record(map, size, &offset, &record, &payload) == true;) {
+        if (record.type == SL_CAPTURE_RECORD_TRUNCATED) {
+            continue;
+        }
+
+        sl_replay_stream *stream = &file_streams[record.connection - 1];
+
+        if (record.type == SL_CAPTURE_RECORD_DATA) {
+            memcpy(stream->data + stream->length, payload, record.length);
+            stream->length += record.length;
+            stream->chunks[stream->chunk_count ++] = stream->length;
+        }
+
+        replay->events[replay->event_count] = (sl_replay_event) {
+            .timestamp = header.started + record.timestamp,
+            .sequence = replay->event_count,
+            .stream = stream,
+            .type = record.type,
+            .end = stream->length
+        };
+
+        replay->event_count ++;
+        replay->bytes += record.length;
+    }
+
+    for (uint32_t n = 0; n < connections; n ++) {
+        replay->streams[replay->stream_count + n] = &file_streams[n];
+    }
+
+    replay->stream_count += connections;
+    file_streams = NULL;
+    result = 0;
+
+cleanup:
+    if (file_streams != NULL) {
+        for (uint32_t n = 0; n < connections; n ++) {
+            free(file_streams[n].data);
+            free(file_streams[n].chunks);
+        }
+
+        free(file_streams);
+    }
+
+    munmap(map, size);
+
+    return result;
+}
+
+static int sl_replay_compare_events(const void *a, const void *b)
+{
+    const sl_replay_event *first = a, *second = b;
+
+    if (first->timestamp != second->timestamp) {
+        return first->timestamp < second->timestamp ? -1 : 1;
+    }
+
+    return first->sequence < second->sequence ? -1 : first->sequence > second->sequence;
+}
+
+static int sl_replay_prepare(sl_replay *replay)
+{
+    size_t requests = 0;
+
+    if (replay->event_count == 0) {
+        fprintf(stderr, "No captured connections\n");
+        return -1;
+    }
+
+    qsort(replay->events, replay->event_count, sizeof(sl_replay_event), sl_replay_compare_events);
+
+    uint64_t base = replay->events[0].timestamp;
+
+    for (size_t n = 0; n < replay->event_count; n ++) {
+        replay->events[n].timestamp -= base;
+    }
+
+    replay->duration = replay->events[replay->event_count - 1].timestamp;
+
+    for (size_t n = 0; n < replay->stream_count; n ++) {
+        sl_replay_stream *stream = replay->streams[n];
+
+        stream->request_count = sl_replay_index_requests(stream, NULL);
+        stream->requests = malloc((stream->request_count + 1) * sizeof(size_t));
+
+        if (stream->requests == NULL) {
+            perror("sl_replay_prepare()");
+            return -1;
+        }
+
+        sl_replay_index_requests(stream, stream->requests);
+        requests += stream->request_count;
+    }
+
+    printf("Loaded %zu connections, %zu requests, %zu bytes over %.3f s\n", replay->stream_count, requests, replay->bytes, replay->duration / 1e9);
+
+    return 0;
+}
+
+static int sl_replay_set_events(sl_replay *replay, sl_replay_stream *stream, bool writing)
+{
+    struct epoll_event event = {
+        .events = EPOLLIN | (writing == true ? EPOLLOUT : 0),
+        .data.ptr = stream
+    };
+
+    if (stream->writing == writing) {
+        return 0;
+    }
+
+    stream->writing = writing;
+
+    return epoll_ctl(replay->epoll_instance, EPOLL_CTL_MOD, stream->fd, &event);
+}
+
+static int sl_replay_open(sl_replay *replay, sl_replay_stream *stream)
+{
+    int one = 1;
+
+    stream->fd = socket(replay->address.ss_family, SOCK_STREAM, 0);
+    if (stream->fd == -1) {
+        perror("socket()");
+        return -1;
+    }
+
+    if (connect(stream->fd, (struct sockaddr *) &replay->address, replay->address_length) == -1) {
+        perror("connect()");
+        goto error;
+    }
+
+    if (replay->address.ss_family == AF_INET && setsockopt(stream->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)) == -1) {
+        perror("setsockopt()");
+    }
+
+    if (sl_net_set_nonblocking_socket(stream->fd) == -1) {
+        perror("fcntl()");
+        goto error;
+    }
+
+    struct epoll_event event = {
+        .events = EPOLLIN,
+        .data.ptr = stream
+    };
+
+    if (epoll_ctl(replay->epoll_instance, EPOLL_CTL_ADD, stream->fd, &event) == -1) {
+        perror("epoll_ctl()");
+        goto error;
+    }
+
+    replay->active ++;
+
+    if (replay->active > replay->peak_active) {
+        replay->peak_active = replay->active;
+    }
+
+    return 0;
+
+error:
+    close(stream->fd);
+    stream->fd = -1;
+
+    return -1;
+}
+
+static void sl_replay_finish(sl_replay *replay, sl_replay_stream *stream, bool failed)
+{
+    if (failed == true || stream->in_flight == true || stream->sent < stream->length) {
+        replay->errors ++;
+    }
+
+    if (stream->fd != -1) {
+        close(stream->fd);
+        stream->fd = -1;
+        replay->active --;
+    }
+
+    stream->done = true;
+}
+
+static size_t sl_replay_send_limit(sl_replay_stream *stream)
+{
+    size_t limit = stream->released;
+
+    if (stream->next_request < stream->request_count && stream->requests[stream->next_request] == stream->sent && limit > stream->sent) {
+        if (stream->in_flight == true) {
+            return stream->sent;
+        }
+
+        stream->in_flight = true;
+        stream->next_request ++;
+    }
+
+    if (stream->next_request < stream->request_count && stream->requests[stream->next_request] < limit) {
+        limit = stream->requests[stream->next_request];
+    }
+
+    return limit;
+}
+
+static int sl_replay_write(sl_replay *replay, sl_replay_stream *stream)
+{
+    size_t limit;
+
+    while ((limit = sl_replay_send_limit(stream)) > stream->sent) {
+        uint64_t now = sl_replay_now();
+
+        ssize_t bytes_sent = send(stream->fd, stream->data + stream->sent, limit - stream->sent, MSG_NOSIGNAL);
+        if (bytes_sent == -1 && errno == EINTR) {
+            continue;
+        } else if (bytes_sent == -1 && errno == EAGAIN) {
+            return sl_replay_set_events(replay, stream, true);
+        } else if (bytes_sent == -1) {
+            return -1;
+        }
+
+        stream->sent += bytes_sent;
+        stream->sent_at = now;
+    }
+
+    if (stream->closing == true && stream->sent == stream->length && stream->in_flight == false) {
+        sl_replay_finish(replay, stream, false);
+        return 0;
+    }
+
+    return sl_replay_set_events(replay, stream, false);
+}
+
+static int sl_replay_parse(sl_replay *replay, sl_replay_stream *stream, uint8_t *buffer, size_t length)
+{
+    sl_fcgi_msg_header *header = (sl_fcgi_msg_header *) stream->header;
+
+    while (length > 0) {
+        if (stream->header_read < sizeof(sl_fcgi_msg_header)) {
+            size_t chunk = sizeof(sl_fcgi_msg_header) - stream->header_read;
+
+            if (chunk > length) {
+                chunk = length;
+            }
+
+            memcpy(stream->header + stream->header_read, buffer, chunk);
+            stream->header_read += chunk;
+            buffer += chunk;
+            length -= chunk;
+
+            if (stream->header_read < sizeof(sl_fcgi_msg_header)) {
+                break;
+            }
+
+            if (header->version != SL_FCGI_VERSION) {
+                return -1;
+            }
+
+            stream->content_remaining = ntohs(header->content_length);
+            stream->padding_remaining = header->padding_length;
+        }
+
+        size_t chunk = stream->content_remaining + stream->padding_remaining;
+
+        if (chunk > length) {
+            chunk = length;
+        }
+
+        size_t content = chunk < stream->content_remaining ? chunk : stream->content_remaining;
+
+        stream->content_remaining -= content;
+        stream->padding_remaining -= chunk - content;
+        buffer += chunk;
+        length -= chunk;
+
+        if (stream->content_remaining > 0 || stream->padding_remaining > 0) {
+            break;
+        }
+
+        stream->header_read = 0;
+
+        if (header->type == SL_FCGI_TYPE_END_REQUEST && stream->in_flight == true) {
+            sl_trace_histogram_record(&replay->latency, sl_replay_now() - stream->sent_at);
+            stream->in_flight = false;
+            replay->responses ++;
+        }
+    }
+
+    return 0;
+}
+
+static int sl_replay_read(sl_replay *replay, sl_replay_stream *stream)
+{
+    uint8_t buffer[SL_REPLAY_RECV_BUFFER_SIZE];
+
+    for (;;) {
+        ssize_t bytes_read = recv(stream->fd, buffer, sizeof(buffer), 0);
+        if (bytes_read == -1 && errno == EINTR) {
+            continue;
+        } else if (bytes_read == -1 && errno == EAGAIN) {
+            return sl_replay_write(replay, stream);
+        } else if (bytes_read == 0) {
+            sl_replay_finish(replay, stream, false);
+            return 0;
+        } else if (bytes_read == -1) {
+            return -1;
+        }
+
+        replay->bytes_received += bytes_read;
+
+        if (sl_replay_parse(replay, stream, buffer, bytes_read) == -1) {
+            return -1;
+        }
+
+        if ((size_t) bytes_read < sizeof(buffer)) {
+            return sl_replay_write(replay, stream);
+        }
+    }
+}
+
+static int sl_replay_fire(sl_replay *replay, sl_replay_event *event)
+{
+    sl_replay_stream *stream = event->stream;
+
+    if (stream->done == true) {
+        return 0;
+    }
+
+    if (stream->fd == -1 && sl_replay_open(replay, stream) == -1) {
+        return -1;
+    }
+
+    if (replay->speed == 0.0) {
+        stream->released = stream->length;
+        stream->closing = true;
+    } else if (event->type == SL_CAPTURE_RECORD_DATA) {
+        stream->released = event->end;
+    } else if (event->type == SL_CAPTURE_RECORD_CLOSE) {
+        stream->closing = true;
+    }
+
+    return sl_replay_write(replay, stream);
+}
+
+static void sl_replay_check_timeouts(sl_replay *replay, uint64_t now)
+{
+    for (size_t n = 0; n < replay->stream_count; n ++) {
+        sl_replay_stream *stream = replay->streams[n];
+
+        if (stream->fd != -1 && stream->in_flight == true && now - stream->sent_at > replay->timeout_ns) {
+            replay->timeouts ++;
+            sl_replay_finish(replay, stream, true);
+        }
+    }
+}
+
+static int sl_replay_loop(sl_replay *replay)
+{
+    struct epoll_event events[SL_REPLAY_MAX_EVENTS];
+    uint64_t start = sl_replay_now(), next_check = 0;
+    size_t next_event = 0;
+    bool drained = false;
+
+    while (sl_replay_interrupted == false) {
+        uint64_t now = sl_replay_now();
+        int timeout = SL_REPLAY_POLL_INTERVAL_MS;
+
+        while (next_event < replay->event_count) {
+            sl_replay_event *event = &replay->events[next_event];
+
+            if (replay->speed == 0.0) {
+                if (replay->active >= replay->max_connections) {
+                    break;
+                }
+            } else {
+                uint64_t due = start + (uint64_t) (event->timestamp / replay->speed);
+
+                if (due > now) {
+                    if ((due - now) / 1000000 < (uint64_t) timeout) {
+                        timeout = (due - now) / 1000000;
+                    }
+                    break;
+                }
+
+                if (now - due > replay->max_lag) {
+                    replay->max_lag = now - due;
+                }
+            }
+
+            if ((replay->speed != 0.0 || event->stream->fd == -1) && sl_replay_fire(replay, event) == -1) {
+                return -1;
+            }
+
+            next_event ++;
+        }
+
+        if (next_event == replay->event_count && drained == false) {
+            drained = true;
+
+            for (size_t n = 0; n < replay->stream_count; n ++) {
+                sl_replay_stream *stream = replay->streams[n];
+
+                if (stream->fd != -1) {
+                    stream->closing = true;
+
+                    if (sl_replay_write(replay, stream) == -1) {
+                        sl_replay_finish(replay, stream, true);
+                    }
+                }
+            }
+        }
+
+        if (drained == true && replay->active == 0) {
+            break;
+        }
+
+        int num_events = epoll_wait(replay->epoll_instance, events, SL_REPLAY_MAX_EVENTS, timeout);
+        if (num_events == -1 && errno != EINTR) {
+            perror("epoll_wait()");
+            return -1;
+        }
+
+        for (int n = 0; n < num_events; n ++) {
+            sl_replay_stream *stream = events[n].data.ptr;
+            int result = 0;
+
+            if (stream->fd == -1) {
+                continue;
+            }
+
+            if ((events[n].events & EPOLLOUT) != 0) {
+                result = sl_replay_write(replay, stream);
+            }
+
+            if (result == 0 && stream->fd != -1 && (events[n].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) != 0) {
+                result = sl_replay_read(replay, stream);
+            }
+
+            if (result == -1) {
+                sl_replay_finish(replay, stream, true);
+            }
+        }
+
+        now = sl_replay_now();
+
+        if (now >= next_check) {
+            sl_replay_check_timeouts(replay, now);
+            next_check = now + SL_REPLAY_POLL_INTERVAL_MS * 1000000;
+        }
+    }
+
+    replay->elapsed = sl_replay_now() - start;
+
+    return 0;
+}
+
+static int sl_replay_run(sl_replay *replay)
+{
+    replay->epoll_instance = epoll_create1(0);
+    if (replay->epoll_instance == -1) {
+        perror("epoll_create1()");
+        return -1;
+    }
+
+    int result = sl_replay_loop(replay);
+
+    for (size_t n = 0; n < replay->stream_count; n ++) {
+        if (replay->streams[n]->fd != -1) {
+            sl_replay_finish(replay, replay->streams[n], true);
+        }
+    }
+
+    close(replay->epoll_instance);
+
+    if (result == -1) {
+        return -1;
+    }
+
+    sl_trace_histogram *latency = &replay->latency;
+    double elapsed = replay->elapsed / 1e9;
+    char name[32];
+
+    if (replay->speed == 0.0) {
+        snprintf(name, sizeof(name), "unpaced/c%zu", replay->max_connections);
+    } else {
+        snprintf(name, sizeof(name), "paced/x%g", replay->speed);
+    }
+
+    printf("%-16s %12.0f req/s %8.2f MB/s  p50 %9.1f us  p99 %9.1f us  p99.9 %9.1f us  max %9.1f us  %zu responses, %zu errors, %zu timeouts, peak %zu connections, max lag %.1f us, %.3f s\n",
+        name, elapsed > 0.0 ? replay->responses / elapsed : 0.0, elapsed > 0.0 ? replay->bytes_received / elapsed / 1e6 : 0.0,
+        sl_trace_histogram_percentile(latency, 50.0) / 1e3, sl_trace_histogram_percentile(latency, 99.0) / 1e3,
+        sl_trace_histogram_percentile(latency, 99.9) / 1e3, latency->max / 1e3,
+        replay->responses, replay->errors, replay->timeouts, replay->peak_active, replay->max_lag / 1e3, elapsed);
+
+    return 0;
+}
+
+static uint64_t sl_replay_parse_stream(sl_replay_stream *stream, sl_arena *arena, sl_slab *param_slab, sl_log *log, size_t *allocations, size_t *errors)
+{
+    sl_fcgi_parser parser;
+    sl_fcgi_request request;
+    size_t offset = 0, requests = 0;
+
+    sl_arena_rewind(arena);
+    sl_fcgi_parser_init(&parser, arena, param_slab, log);
+    sl_fcgi_request_init(&request, arena, log, SL_REPLAY_PARAMS_PREALLOCATE);
+
+    for (size_t n = 0; n < stream->chunk_count; n ++) {
+        size_t end = stream->chunks[n];
+
+        while (offset < end) {
+            offset += sl_fcgi_parser_parse(&parser, stream->data + offset, end - offset);
+
+            if (parser.state == SL_FCGI_PARSER_STATE_ERROR) {
+                (*errors) ++;
+                return requests;
+            }
+
+            if (parser.state != SL_FCGI_PARSER_STATE_FINISHED) {
+                continue;
+            }
+
+            sl_fcgi_request_process(&request, &parser);
+
+            if (request.state == SL_FCGI_REQUEST_STATE_ERROR) {
+                (*errors) ++;
+                return requests;
+            }
+
+            if (request.state == SL_FCGI_REQUEST_STATE_FINISHED) {
+                requests ++;
+                *allocations += arena->allocations;
+
+                sl_arena_rewind(arena);
+                sl_fcgi_request_init(&request, arena, log, SL_REPLAY_PARAMS_PREALLOCATE);
+            }
+
+            sl_fcgi_parser_init(&parser, arena, param_slab, log);
+        }
+    }
+
+    return requests;
+}
+
+static int sl_replay_run_in_process(sl_replay *replay, size_t passes)
+{
+    sl_arena arena;
+    sl_slab param_slab;
+    sl_log log;
+    uint64_t best = UINT64_MAX;
+    size_t requests = 0, allocations = 0, errors = 0;
+
+    int fd = open("/dev/null", O_WRONLY);
+    if (fd == -1) {
+        perror("/dev/null");
+        return -1;
+    }
+
+    sl_arena_init(&arena, SL_REPLAY_ARENA_PREALLOCATE);
+    sl_slab_init(&param_slab, sizeof(sl_fcgi_msg_param), SL_REPLAY_PARAM_SLAB_OBJECTS);
+    sl_log_init(&log, SL_LOG_ERROR, fd);
+
+    for (size_t pass = 0; pass < passes && sl_replay_interrupted == false; pass ++) {
+        uint64_t start = sl_replay_now();
+
+        requests = 0;
+        allocations = 0;
+        errors = 0;
+
+        for (size_t n = 0; n < replay->stream_count; n ++) {
+            requests += sl_replay_parse_stream(replay->streams[n], &arena, &param_slab, &log, &allocations, &errors);
+        }
+
+        uint64_t elapsed = sl_replay_now() - start;
+
+        if (elapsed < best) {
+            best = elapsed;
+        }
+    }
+
+    if (best != UINT64_MAX) {
+        printf("parse %12.2f ns/request %10.2f MB/s %8.1f allocations/request  %zu requests, %zu errors, best of %zu passes\n",
+            requests > 0 ? (double) best / requests : 0.0, best > 0 ? replay->bytes * 1000.0 / best : 0.0,
+            requests > 0 ? (double) allocations / requests : 0.0, requests, errors, passes);
+    }
+
+    sl_slab_destroy(&param_slab);
+    sl_arena_destroy(&arena);
+    close(fd);
+
+    return 0;
+}
+
+static int sl_replay_parse_number(char *value, size_t *number)
+{
+    char *end = NULL;
+
+    errno = 0;
+    unsigned long long parsed = strtoull(value, &end, 10);
+    if (errno != 0 || end == value || *end != '\0') {
+        return -1;
+    }
+
+    *number = parsed;
+
+    return 0;
+}
+
+static int sl_replay_set_address(sl_replay *replay, char *host, size_t port, char *path)
+{
+    memset(&replay->address, 0, sizeof(replay->address));
+
+    if (path != NULL) {
+        struct sockaddr_un *address = (struct sockaddr_un *) &replay->address;
+
+        if (strlen(path) >= sizeof(address->sun_path)) {
+            return -1;
+        }
+
+        address->sun_family = AF_UNIX;
+        strcpy(address->sun_path, path);
+        replay->address_length = sizeof(struct sockaddr_un);
+
+        return 0;
+    }
+
+    struct sockaddr_in *address = (struct sockaddr_in *) &replay->address;
+
+    if (port == 0 || port > UINT16_MAX || inet_pton(AF_INET, host, &address->sin_addr) != 1) {
+        return -1;
+    }
+
+    address->sin_family = AF_INET;
+    address->sin_port = htons(port);
+    replay->address_length = sizeof(struct sockaddr_in);
+
+    return 0;
+}
+
+static void sl_replay_usage(char *name)
+{
+    fprintf(stderr, "Usage: %s [-a address] [-p port] [-u unix socket path] [-x speedup, 0 replays unpaced] [-c connections when unpaced] "
+        "[-T timeout ms] [-i parse in-process] [-n in-process passes] capture [capture ...]\n", name);
+}
+
+int main(int argc, char *argv[])
+{
+    static sl_replay replay;
+    char *host = "127.0.0.1", *path = NULL, *end = NULL;
+    size_t port = SL_REPLAY_DEFAULT_PORT, passes = SL_REPLAY_DEFAULT_PASSES, value;
+    bool in_process = false;
+    int option;
+
+    replay.speed = 1.0;
+    replay.max_connections = SL_REPLAY_DEFAULT_CONNECTIONS;
+    replay.timeout_ns = (uint64_t) SL_REPLAY_DEFAULT_TIMEOUT_MS * 1000000;
+
+    while ((option = getopt(argc, argv, "a:p:u:x:c:T:in:")) != -1) {
+        switch (option) {
+            case 'a':
+                host = optarg;
+                break;
+            case 'p':
+                if (sl_replay_parse_number(optarg, &port) == -1) {
+                    sl_replay_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'u':
+                path = optarg;
+                break;
+            case 'x':
+                replay.speed = strtod(optarg, &end);
+                if (end == optarg || *end != '\0' || replay.speed < 0.0) {
+                    sl_replay_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'c':
+                if (sl_replay_parse_number(optarg, &replay.max_connections) == -1 || replay.max_connections == 0) {
+                    sl_replay_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'T':
+                if (sl_replay_parse_number(optarg, &value) == -1 || value == 0) {
+                    sl_replay_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                replay.timeout_ns = (uint64_t) value * 1000000;
+                break;
+            case 'i':
+                in_process = true;
+                break;
+            case 'n':
+                if (sl_replay_parse_number(optarg, &passes) == -1 || passes == 0) {
+                    sl_replay_usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                break;
+            default:
+                sl_replay_usage(argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    if (optind >= argc) {
+        sl_replay_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (in_process == false && sl_replay_set_address(&replay, host, port, path) == -1) {
+        fprintf(stderr, "Invalid address\n");
+        return EXIT_FAILURE;
+    }
+
+    if (signal(SIGINT, &sl_replay_signal_handler) == SIG_ERR || signal(SIGPIPE, SIG_IGN) == SIG_ERR) {
+        perror("signal()");
+        return EXIT_FAILURE;
+    }
+
+    if (sl_hashtable_init_seed() == -1) {
+        fprintf(stderr, "sl_hashtable_init_seed() failed\n");
+        return EXIT_FAILURE;
+    }
+
+    for (int n = optind; n < argc; n ++) {
+        if (sl_replay_load(&replay, argv[n]) == -1) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (sl_replay_prepare(&replay) == -1) {
+        return EXIT_FAILURE;
+    }
+
+    if (in_process == true) {
+        return sl_replay_run_in_process(&replay, passes) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    return sl_replay_run(&replay) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}